@@ -0,0 +1,16 @@
+#include "Benchmarks/benchmarks.h"
+#include "Utilities/debug.h"
+
+bool RunBenchmarks()
+{
+    bool passed = true;
+
+    // Every check runs even if an earlier one failed, so a single run reports all of them
+    passed &= RunFusedKernelCheck();
+    passed &= RunRandomBenchmark();
+    passed &= RunObjectPoolBenchmark();
+    passed &= RunUploadBenchmark();
+
+    OutputDebugMessage("Benchmarks %s\n", passed ? "passed" : "failed");
+    return passed;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Headless checks and benchmarks, run instead of the scene when the app is started with -benchmark.
+// Results are written to the debug output, every check returns false if any of its asserts failed.
+bool RunBenchmarks();
+
+// Best time of all runs in milliseconds, so a run preempted by the OS doesn't skew the result
+template<typename Func>
+float MeasureBestTime(uint32_t runsCount, Func&& func)
+{
+    float bestTime = std::numeric_limits<float>::max();
+
+    for (uint32_t run = 0; run < runsCount; ++run)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        func();
+        const std::chrono::duration<float, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+        bestTime = std::min(bestTime, time.count());
+    }
+
+    return bestTime;
+}
+
+// Powers of two up to maxThreads, maxThreads itself is always the last one
+inline std::vector<uint32_t> GetThreadCounts(uint32_t maxThreads)
+{
+    maxThreads = std::max(maxThreads, 1U);
+
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threadsCount = 1; threadsCount < maxThreads; threadsCount *= 2)
+    {
+        threadCounts.push_back(threadsCount);
+    }
+    threadCounts.push_back(maxThreads);
+
+    return threadCounts;
+}
+
+// Threads start together, so the time covers only the contended part and not thread creation.
+// Calling thread keeps calling pollFunc until they finish and once more after that, returns the time in milliseconds.
+template<typename ThreadFunc>
+float RunThreads(uint32_t threadsCount, ThreadFunc&& threadFunc, const std::function<void()>& pollFunc)
+{
+    std::atomic<bool> start = false;
+    std::atomic<uint32_t> finishedThreads = 0;
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadsCount);
+    for (uint32_t threadIndex = 0; threadIndex < threadsCount; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]() {
+            while (!start.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            threadFunc(threadIndex);
+            finishedThreads.fetch_add(1, std::memory_order_release);
+            });
+    }
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    start.store(true, std::memory_order_release);
+
+    while (finishedThreads.load(std::memory_order_acquire) != threadsCount)
+    {
+        pollFunc();
+        std::this_thread::yield();
+    }
+
+    const std::chrono::duration<float, std::milli> time = std::chrono::high_resolution_clock::now() - startTime;
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    pollFunc();
+
+    return time.count();
+}
+
+// Fused kernel's CPU reference with randomized slot order, validated every frame
+bool RunFusedKernelCheck();
+
+// Batch SIMD random APIs checked bit exact against shader's xxHash32 and scalar results, then timed against the scalar loop
+bool RunRandomBenchmark();
+
+// Allocations and frees from 1 to all hardware threads, lock-free pool against ObjectPool behind a mutex
+bool RunObjectPoolBenchmark();
+
+// Producers reserving upload memory during the same frame, from 1 to as many threads as a frame segment has blocks.
+// Advances frames, so it needs the engine started and the first frame signaled.
+bool RunUploadBenchmark();
@@ -0,0 +1,56 @@
+#include "Benchmarks/benchmarks.h"
+#include "Graphics/particlefusedkernel.h"
+#include "Utilities/debug.h"
+
+bool RunFusedKernelCheck()
+{
+    // Capacity isn't a multiple of the thread group size, so the last group is partially filled like on the GPU
+    const uint32_t capacity = 257;
+    const uint32_t framesCount = 500;
+
+    std::mt19937 generator(1);
+
+    FusedKernelEmitterData data;
+    data.Particles.assign(capacity, ParticleData{});
+    data.FreeList.resize(capacity);
+    data.Indices.resize(capacity);
+    std::iota(data.FreeList.begin(), data.FreeList.end(), 0);
+
+    std::vector<uint32_t> slotsOrder(capacity);
+
+    auto update = [](ParticleData& particle) {
+        particle.LifeTime -= 1.0f;
+        };
+
+    auto spawn = [&generator](ParticleData& particle) {
+        particle.LifeTime = static_cast<float>(1 + generator() % 5);
+        };
+
+    for (uint32_t frame = 0; frame < framesCount; ++frame)
+    {
+        // Emitter update never spawns more particles than there are free slots at the start of the frame
+        const uint32_t freeSlots = capacity - data.InstanceCount;
+        const uint32_t aliveAfterUpdate = static_cast<uint32_t>(std::count_if(data.Particles.begin(), data.Particles.end(), [](const ParticleData& particle) {
+            return particle.LifeTime > 1.0f;
+            }));
+
+        data.Status.ParticlesToSpawn = generator() % (freeSlots + 1);
+        data.Status.ClaimedSlots = 0;
+        data.InstanceCount = 0;
+
+        // GPU threads claim dead slots in any order, a shuffle each frame covers the orders a single sequential pass never hits
+        std::iota(slotsOrder.begin(), slotsOrder.end(), 0);
+        std::shuffle(slotsOrder.begin(), slotsOrder.end(), generator);
+
+        ParticleFusedKernel::Execute(data, update, spawn, slotsOrder);
+
+        if (!ParticleFusedKernel::Validate(data) || data.InstanceCount != aliveAfterUpdate + data.Status.ParticlesToSpawn)
+        {
+            OutputDebugMessage("Fused kernel check failed in frame %u, alive: %u, expected: %u\n", frame, data.InstanceCount, aliveAfterUpdate + data.Status.ParticlesToSpawn);
+            return false;
+        }
+    }
+
+    OutputDebugMessage("Fused kernel check passed, %u frames\n", framesCount);
+    return true;
+}
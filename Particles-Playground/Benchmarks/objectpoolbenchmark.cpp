@@ -0,0 +1,105 @@
+#include "Benchmarks/benchmarks.h"
+#include "Utilities/concurrentobjectpool.h"
+#include "Utilities/debug.h"
+
+namespace
+{
+    struct BenchmarkObject : public IObject<BenchmarkObject>
+    {
+        BenchmarkObject(uint32_t value)
+            : Value(value)
+        { }
+
+        uint32_t Value = 0;
+    };
+
+    // Every thread allocates a batch, checks it through the handles and frees it again, like emitters created and freed during a frame
+    const uint32_t batchSize = 64;
+    const uint32_t roundsCount = 1000;
+    const uint32_t runsCount = 3;
+
+    template<typename Pool, typename Lock>
+    bool RunPoolThread(Pool& pool, Lock&& lock, uint32_t threadIndex)
+    {
+        std::vector<ObjectHandle<BenchmarkObject>> handles(batchSize);
+        bool valid = true;
+
+        for (uint32_t round = 0; round < roundsCount; ++round)
+        {
+            for (uint32_t i = 0; i < batchSize; ++i)
+            {
+                auto guard = lock();
+                handles[i] = pool.AllocateObject(threadIndex * batchSize + i);
+            }
+
+            for (uint32_t i = 0; i < batchSize; ++i)
+            {
+                auto guard = lock();
+                valid &= pool.GetObject(handles[i])->Value == threadIndex * batchSize + i;
+                pool.FreeObject(handles[i]);
+            }
+        }
+
+        return valid;
+    }
+}
+
+bool RunObjectPoolBenchmark()
+{
+    const std::vector<uint32_t> threadCounts = GetThreadCounts(std::thread::hardware_concurrency());
+    bool passed = true;
+
+    OutputDebugMessage("Object pool, %u rounds of %u allocations and frees per thread\n", roundsCount, batchSize);
+
+    for (uint32_t threadsCount : threadCounts)
+    {
+        // Freed slots come back only after ProcessPendingObjects, the pool is big enough even if the frame loop never gets to it
+        const uint32_t poolSize = threadsCount * batchSize * roundsCount;
+        const uint32_t operationsCount = threadsCount * batchSize * roundsCount * 2;
+
+        float concurrentTime = std::numeric_limits<float>::max();
+        float mutexTime = std::numeric_limits<float>::max();
+
+        for (uint32_t run = 0; run < runsCount; ++run)
+        {
+            ConcurrentObjectPool<BenchmarkObject> concurrentPool(poolSize);
+            concurrentPool.Init();
+
+            std::atomic<bool> concurrentValid = true;
+            concurrentTime = std::min(concurrentTime, RunThreads(threadsCount, [&](uint32_t threadIndex) {
+                if (!RunPoolThread(concurrentPool, []() { return 0; }, threadIndex))
+                {
+                    concurrentValid = false;
+                }
+                }, [&]() { concurrentPool.ProcessPendingObjects(); }));
+
+            passed &= concurrentValid && concurrentPool.GetObjectsCount() == 0;
+            concurrentPool.Free();
+
+            ObjectPool<BenchmarkObject> mutexPool(poolSize);
+            mutexPool.Init();
+            std::mutex mutex;
+
+            std::atomic<bool> mutexValid = true;
+            mutexTime = std::min(mutexTime, RunThreads(threadsCount, [&](uint32_t threadIndex) {
+                if (!RunPoolThread(mutexPool, [&mutex]() { return std::lock_guard<std::mutex>(mutex); }, threadIndex))
+                {
+                    mutexValid = false;
+                }
+                }, []() {}));
+
+            passed &= mutexValid && mutexPool.GetObjectsCount() == 0;
+            mutexPool.Free();
+        }
+
+        OutputDebugMessage("    %2u threads: concurrent %.3f ms (%.1f M ops/s), mutex %.3f ms (%.1f M ops/s)\n", threadsCount,
+            concurrentTime, operationsCount / (concurrentTime * 1000.0f), mutexTime, operationsCount / (mutexTime * 1000.0f));
+    }
+
+    if (!passed)
+    {
+        OutputDebugMessage("Object pool check failed, objects were lost or corrupted\n");
+    }
+
+    return passed;
+}
@@ -0,0 +1,123 @@
+#include "Benchmarks/benchmarks.h"
+#include "Utilities/random.h"
+#include "Utilities/debug.h"
+
+namespace
+{
+    struct KnownRandom
+    {
+        uint32_t Seed;
+        uint32_t Index;
+        uint32_t Random;
+    };
+
+    // Computed independently from GetRandomXxHash32(uint2(seed, index)) in default.hlsli
+    const std::array<KnownRandom, 6> knownRandoms = { {
+        { 0x00000000U, 0x00000000U, 0x34560F83U },
+        { 0x00000000U, 0x00000001U, 0x9485C89BU },
+        { 0x00000001U, 0x00000000U, 0x8287B9F0U },
+        { 0x00003039U, 0x00000043U, 0xCAB39E48U },
+        { 0xFFFFFFFFU, 0xFFFFFFFFU, 0x1D1D3FE1U },
+        { 0xDEADBEEFU, 0x000003FFU, 0x8E78F160U },
+    } };
+
+    // First numbers GetRandom() returns in a shader after Internal_InitRandom(42, 7)
+    const uint32_t knownStreamSeed = 42;
+    const uint32_t knownStreamIndex = 7;
+    const std::array<uint32_t, 4> knownStream = { 0xDF1EF8A8U, 0x2D4EB932U, 0xF332418FU, 0xEA371A3BU };
+
+    bool CheckKnownRandoms()
+    {
+        for (const KnownRandom& known : knownRandoms)
+        {
+            // Single value goes through the SIMD path when the batch is padded to the full width
+            std::array<uint32_t, Simd::Width> indices;
+            std::array<uint32_t, Simd::Width> batch;
+            indices.fill(known.Index);
+
+            ParticleRandomNumberGenerator::GetRandom(known.Seed, indices.data(), Simd::Width, batch.data());
+            const uint32_t scalar = RngType::xxHash32().GetRandom(known.Seed, known.Index);
+
+            if (scalar != known.Random || batch[0] != known.Random || batch[Simd::Width - 1] != known.Random)
+            {
+                OutputDebugMessage("Random check failed for seed 0x%08X index 0x%08X: expected 0x%08X, scalar 0x%08X, batch 0x%08X\n", known.Seed, known.Index, known.Random, scalar, batch[0]);
+                return false;
+            }
+        }
+
+        ParticleRandomNumberGenerator generator(knownStreamSeed, knownStreamIndex);
+        for (uint32_t known : knownStream)
+        {
+            if (generator.GetRandom() != known)
+            {
+                OutputDebugMessage("Random check failed, particle stream doesn't match the shader's one\n");
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+bool RunRandomBenchmark()
+{
+    if (!CheckKnownRandoms())
+    {
+        return false;
+    }
+
+    // Count isn't a multiple of the SIMD width, so the scalar tail is covered too
+    const uint32_t count = 1000003;
+    const uint32_t runsCount = 10;
+    const uint32_t seed = 0x9E3779B9U;
+
+    std::vector<uint32_t> particleIndices(count);
+    std::iota(particleIndices.begin(), particleIndices.end(), 0);
+
+    std::vector<uint32_t> scalarRandoms(count);
+    std::vector<uint32_t> batchRandoms(count);
+    std::vector<float> scalarFloats(count);
+    std::vector<float> batchFloats(count);
+
+    const float scalarTime = MeasureBestTime(runsCount, [&]() {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            scalarRandoms[i] = RngType::xxHash32().GetRandom(seed, particleIndices[i]);
+        }
+        });
+
+    const float batchTime = MeasureBestTime(runsCount, [&]() {
+        ParticleRandomNumberGenerator::GetRandom(seed, particleIndices.data(), count, batchRandoms.data());
+        });
+
+    const float scalarFloatTime = MeasureBestTime(runsCount, [&]() {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            scalarFloats[i] = ConvertRandomToFloat(RngType::xxHash32().GetRandom(seed, particleIndices[i]));
+        }
+        });
+
+    const float batchFloatTime = MeasureBestTime(runsCount, [&]() {
+        ParticleRandomNumberGenerator::GetRandomFloat(seed, particleIndices.data(), count, batchFloats.data());
+        });
+
+    // Floats are compared as bits, the conversion has to be exact as well
+    const bool randomsMatch = scalarRandoms == batchRandoms;
+    const bool floatsMatch = std::memcmp(scalarFloats.data(), batchFloats.data(), count * sizeof(float)) == 0;
+
+    auto throughput = [count](float time) {
+        return time > 0.0f ? count / (time * 1000.0f) : 0.0f;
+        };
+
+    OutputDebugMessage("Random, %u values, SIMD width %u\n", count, Simd::Width);
+    OutputDebugMessage("    GetRandom:      scalar %.3f ms (%.1f M/s), batch %.3f ms (%.1f M/s)\n", scalarTime, throughput(scalarTime), batchTime, throughput(batchTime));
+    OutputDebugMessage("    GetRandomFloat: scalar %.3f ms (%.1f M/s), batch %.3f ms (%.1f M/s)\n", scalarFloatTime, throughput(scalarFloatTime), batchFloatTime, throughput(batchFloatTime));
+
+    if (!randomsMatch || !floatsMatch)
+    {
+        OutputDebugMessage("Random check failed, batch results differ from scalar ones\n");
+        return false;
+    }
+
+    return true;
+}
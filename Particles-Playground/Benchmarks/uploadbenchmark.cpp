@@ -0,0 +1,83 @@
+#include "Benchmarks/benchmarks.h"
+#include "System/engine.h"
+#include "System/gpubufferuploadmanager.h"
+#include "Utilities/debug.h"
+
+namespace
+{
+    // Ranges have the size and alignment of constant buffers, so they fill thread blocks without gaps
+    const uint32_t rangeSize = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+    const uint32_t framesCount = 64;
+
+    // Ranges reserved during a frame can't overlap and have to stay inside the frame's segment
+    bool ValidateRanges(std::vector<uint64_t>& rangeStarts)
+    {
+        std::sort(rangeStarts.begin(), rangeStarts.end());
+
+        const uint64_t segmentIndex = rangeStarts.front() / GPUBufferUploadManager::FrameSegmentSize;
+        if (rangeStarts.back() / GPUBufferUploadManager::FrameSegmentSize != segmentIndex)
+        {
+            return false;
+        }
+
+        for (size_t i = 1; i < rangeStarts.size(); ++i)
+        {
+            if (rangeStarts[i - 1] + rangeSize > rangeStarts[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+bool RunUploadBenchmark()
+{
+    // Producers beyond the number of blocks in a segment couldn't get even a single block in the same frame
+    const uint32_t blocksPerSegment = GPUBufferUploadManager::FrameSegmentSize / GPUBufferUploadManager::ThreadBlockSize;
+    const std::vector<uint32_t> threadCounts = GetThreadCounts(std::min(std::thread::hardware_concurrency(), blocksPerSegment));
+    bool passed = true;
+
+    // Uploads made during startup belong to the first frame, measured frames start with empty segments
+    Engine::Get().PreUpdate();
+    Engine::Get().PostUpdate();
+
+    OutputDebugMessage("Upload manager, %u frames, %u byte ranges\n", framesCount, rangeSize);
+
+    for (uint32_t threadsCount : threadCounts)
+    {
+        // Whole segment is split between the producers, so every frame reserves about the same amount of memory
+        const uint32_t rangesPerThread = blocksPerSegment / threadsCount * GPUBufferUploadManager::ThreadBlockSize / rangeSize;
+        const uint32_t rangesCount = rangesPerThread * threadsCount;
+
+        std::vector<uint64_t> rangeStarts(rangesCount);
+        float time = 0.0f;
+
+        for (uint32_t frame = 0; frame < framesCount; ++frame)
+        {
+            Engine::Get().PreUpdate();
+
+            time += RunThreads(threadsCount, [&](uint32_t threadIndex) {
+                for (uint32_t i = 0; i < rangesPerThread; ++i)
+                {
+                    UploadBufferTemporaryRangeHandle range = GPUBufferUploadManager::Get().Reserve(rangeSize, rangeSize);
+                    rangeStarts[threadIndex * rangesPerThread + i] = range->GetStartRange();
+                }
+                }, []() {});
+
+            Engine::Get().PostUpdate();
+
+            passed &= ValidateRanges(rangeStarts);
+        }
+
+        OutputDebugMessage("    %2u producers: %.3f ms per frame (%.1f M reserves/s)\n", threadsCount, time / framesCount, rangesCount * framesCount / (time * 1000.0f));
+    }
+
+    if (!passed)
+    {
+        OutputDebugMessage("Upload manager check failed, reserved ranges overlap or cross the frame's segment\n");
+    }
+
+    return passed;
+}
@@ -14,11 +14,7 @@ void PresentToScreenNode::Execute(const RGExecuteContext& context)
     }
 
     // Render on screen
-    Sampler defaultSampler;
-
-    ShaderParametersLayout screenLayout;
-    screenLayout.SetSRV(0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
-    screenLayout.SetStaticSampler(0, defaultSampler, D3D12_SHADER_VISIBILITY_PIXEL);
+    const ShaderParametersLayout& screenLayout = ShaderManager::Get().GetShaderParametersLayout(VS_Screen, PS_Screen);
 
     GraphicPipelineState screenState;
     screenState.SetVS(VS_Screen);
@@ -2,7 +2,7 @@
 
 void GPUParticleSystemUpdateDirtyEmittersNode::Execute(const RGExecuteContext& context)
 {
-    std::vector<GPUEmitter*> dirtyEmitters = context.GetSceneData().mGPUParticleSystem->GetDirtyEmitters();
+    GPUEmittersView dirtyEmitters = context.GetSceneData().mGPUParticleSystem->GetDirtyEmitters();
 
     if (dirtyEmitters.empty())
     {
@@ -27,6 +27,12 @@ void GPUParticleSystemUpdateDirtyEmittersNode::Execute(const RGExecuteContext& c
             emitterConstantBuffer->Unmap(commandList);
         }
 
+        // Emitters which only changed their particle pages keep their current status
+        if (!emitter->GetResetRequired())
+        {
+            continue;
+        }
+
         { // Reset status data
             const uint32_t offset = emitter->GetEmitterIndexGPU() * sizeof(EmitterStatusData);
             const uint32_t size = sizeof(EmitterStatusData);
@@ -51,47 +57,59 @@ void GPUParticleSystemUpdateDirtyEmittersNode::Execute(const RGExecuteContext& c
 
 void GPUParticleSystemDirtyEmittersFreeIndicesNode::Execute(const RGExecuteContext& context)
 {
-    std::vector<GPUEmitter*> dirtyEmitters = context.GetSceneData().mGPUParticleSystem->GetDirtyEmitters();
+    GPUEmittersView dirtyEmitters = context.GetSceneData().mGPUParticleSystem->GetDirtyEmitters();
 
     if (dirtyEmitters.empty())
     {
         return;
     }
 
+    GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("ParticlesDataBuffer"));
     GPUBuffer* freeIndicesBuffer = context.GetGPUBuffer(RESOURCEID("FreeIndicesBuffer"));
 
     CommandList& commandList = context.GetCommandList();
 
-    struct ResetConstants
+    struct RelocateConstants
     {
-        BindlessDescriptorHandle freeIndicesHandle;
-        uint32_t offset;
-        uint32_t indicesCount;
+        uint32_t srcOffset;
+        uint32_t dstOffset;
+        uint32_t copyCount;
+        uint32_t capacity;
+        ParticleEncoding particleEncoding;
+        uint32_t srcParticlesOffset;
+        uint32_t dstParticlesOffset;
     } constants;
 
-    constants.freeIndicesHandle = freeIndicesBuffer->GetUAVIndex();
+    const ShaderParametersLayout& relocateLayout = ShaderManager::Get().GetShaderParametersLayout(CS_RelocateParticles);
 
-    ShaderParametersLayout resetFreeIndicesLayout;
-    resetFreeIndicesLayout.SetConstant(0, 0, sizeof(ResetConstants), D3D12_SHADER_VISIBILITY_ALL);
-    resetFreeIndicesLayout.SetBindlessHeap(1);
-
-    ComputePipelineState resetFreeIndicesState;
-    resetFreeIndicesState.SetCS(CS_ResetFreeIndices);
-    resetFreeIndicesState.Bind(commandList, resetFreeIndicesLayout);
+    ComputePipelineState relocateState;
+    relocateState.SetCS(CS_RelocateParticles);
+    relocateState.Bind(commandList, relocateLayout);
 
     for (GPUEmitter* emitter : dirtyEmitters)
     {
-        const uint32_t offset = static_cast<uint32_t>(emitter->GetParticleAllocation().Start);
-        const uint32_t size = static_cast<uint32_t>(emitter->GetParticleAllocation().Size);
-
-        constants.offset = offset;
-        constants.indicesCount = size;
-
-        ShaderParameters resetFreeIndicesParams;
-        resetFreeIndicesParams.SetConstant(0, constants);
-        resetFreeIndicesParams.Bind<false>(commandList, resetFreeIndicesLayout);
+        const uint32_t capacity = emitter->GetParticleCapacity();
+        if (capacity == 0)
+        {
+            continue;
+        }
 
-        uint32_t dispatchCount = Align(size, 64) / 64;
+        // Emitters that are reset start with all particles dead, resized ones move their live particles to the new pages
+        constants.srcOffset = emitter->GetPreviousIndicesOffset();
+        constants.dstOffset = emitter->GetIndicesOffset();
+        constants.copyCount = emitter->GetResetRequired() ? 0 : std::min(emitter->GetPreviousParticleCapacity(), capacity);
+        constants.capacity = capacity;
+        constants.particleEncoding = emitter->GetConstantData().Encoding;
+        constants.srcParticlesOffset = emitter->GetPreviousParticlesOffset();
+        constants.dstParticlesOffset = emitter->GetParticlesOffset();
+
+        ShaderParameters relocateParams;
+        relocateParams.SetConstant(0, constants);
+        relocateParams.SetUAV(1, *particlesDataBuffer);
+        relocateParams.SetUAV(2, *freeIndicesBuffer);
+        relocateParams.Bind<false>(commandList, relocateLayout);
+
+        const uint32_t dispatchCount = Align(capacity, 64) / 64;
         commandList->Dispatch(dispatchCount, 1, 1);
     }
 }
@@ -99,9 +117,9 @@ void GPUParticleSystemDirtyEmittersFreeIndicesNode::Execute(const RGExecuteConte
 void GPUParticleSystemUpdateEmittersNode::Execute(const RGExecuteContext& context)
 {
     SceneData& sceneData = context.GetSceneData();
-    std::vector<GPUEmitter*> enabledEmitters = sceneData.mGPUParticleSystem->GetEnabledEmitters();
+    GPUEmittersView activeEmitters = sceneData.mGPUParticleSystem->GetActiveEmitters();
 
-    if (enabledEmitters.empty())
+    if (activeEmitters.empty())
     {
         return;
     }
@@ -111,42 +129,48 @@ void GPUParticleSystemUpdateEmittersNode::Execute(const RGExecuteContext& contex
     GPUBuffer* emitterStatusBuffer = context.GetGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterStatusBuffer"));
     GPUBuffer* drawIndirectBuffer = context.GetGPUBuffer(RESOURCEID("UpdateDirtyEmitters_DrawIndirectBuffer"));
     GPUBuffer* spawnIndirectBuffer = context.GetGPUBuffer(RESOURCEID("SpawnIndirectBuffer"));
+    GPUBuffer* spawnGroupTableBuffer = context.GetGPUBuffer(RESOURCEID("UpdateEmitters_SpawnGroupTableBuffer"));
 
     CommandList& commandList = context.GetCommandList();
+    GPUParticleSystem* particleSystem = sceneData.mGPUParticleSystem;
 
-    const uint32_t enabledEmittersCount = static_cast<uint32_t>(enabledEmitters.size());
-    uint32_t* emitterData = reinterpret_cast<uint32_t*>(emitterIndexBuffer->Map(0, enabledEmittersCount * sizeof(uint32_t)));
+    const uint32_t activeEmittersCount = activeEmitters.CountMatching();
+    uint32_t* emitterData = reinterpret_cast<uint32_t*>(emitterIndexBuffer->Map(0, activeEmittersCount * sizeof(uint32_t)));
 
-    for (uint32_t i = 0; i < enabledEmitters.size(); ++i)
+    uint32_t emitterIndex = 0;
+    for (GPUEmitter* emitter : activeEmitters)
     {
-        GPUEmitter* emitter = enabledEmitters[i];
-        emitterData[i] = emitter->GetEmitterIndexGPU();
+        emitterData[emitterIndex++] = emitter->GetEmitterIndexGPU();
     }
     emitterIndexBuffer->Unmap(commandList);
 
+    // Emitters reserve their groups of the uber spawn dispatch from many thread groups, so its arguments are reset here
+    const uint32_t spawnArgsOffset = GPUParticleSystem::MaxEmitters * sizeof(D3D12_DISPATCH_ARGUMENTS);
+    D3D12_DISPATCH_ARGUMENTS* spawnArgs = reinterpret_cast<D3D12_DISPATCH_ARGUMENTS*>(spawnIndirectBuffer->Map(spawnArgsOffset, spawnArgsOffset + sizeof(D3D12_DISPATCH_ARGUMENTS)));
+    *spawnArgs = { 0, 1, 1 };
+    spawnIndirectBuffer->Unmap(commandList);
+
     GlobalTimer& timer = Engine::Get().GetTimer();
 
     struct EmitterUpdateConstants
     {
         uint32_t emittersCount;
         float deltaTime;
+        uint32_t spawnArgsIndex;
+        uint32_t buildSpawnGroupTable;
     };
 
-    ShaderParametersLayout updateEmitterLayout;
-    updateEmitterLayout.SetConstant(0, 0, sizeof(EmitterUpdateConstants) / sizeof(uint32_t), D3D12_SHADER_VISIBILITY_ALL);
-    updateEmitterLayout.SetSRV(1, 0, D3D12_SHADER_VISIBILITY_ALL);
-    updateEmitterLayout.SetSRV(2, 1, D3D12_SHADER_VISIBILITY_ALL);
-    updateEmitterLayout.SetUAV(3, 1, D3D12_SHADER_VISIBILITY_ALL);
-    updateEmitterLayout.SetUAV(4, 2, D3D12_SHADER_VISIBILITY_ALL);
-    updateEmitterLayout.SetUAV(5, 3, D3D12_SHADER_VISIBILITY_ALL);
+    const ShaderParametersLayout& updateEmitterLayout = ShaderManager::Get().GetShaderParametersLayout(CS_EmitterUpdate);
 
     ComputePipelineState updateEmitterState;
     updateEmitterState.SetCS(CS_EmitterUpdate);
     updateEmitterState.Bind(commandList, updateEmitterLayout);
 
     EmitterUpdateConstants updateConstants;
-    updateConstants.emittersCount = enabledEmittersCount;
+    updateConstants.emittersCount = activeEmittersCount;
     updateConstants.deltaTime = timer.GetDeltaTime();
+    updateConstants.spawnArgsIndex = GPUParticleSystem::MaxEmitters;
+    updateConstants.buildSpawnGroupTable = particleSystem->IsUberKernelReady() ? 1 : 0;
 
     ShaderParameters updateEmitterParams;
     updateEmitterParams.SetConstant(0, updateConstants);
@@ -155,16 +179,17 @@ void GPUParticleSystemUpdateEmittersNode::Execute(const RGExecuteContext& contex
     updateEmitterParams.SetUAV(3, *emitterStatusBuffer);
     updateEmitterParams.SetUAV(4, *drawIndirectBuffer);
     updateEmitterParams.SetUAV(5, *spawnIndirectBuffer);
+    updateEmitterParams.SetUAV(6, *spawnGroupTableBuffer);
     updateEmitterParams.Bind<false>(commandList, updateEmitterLayout);
 
-    const uint32_t dispatchCount = Align(enabledEmittersCount, 64) / 64;
+    const uint32_t dispatchCount = Align(activeEmittersCount, 64) / 64;
     commandList->Dispatch(dispatchCount, 1, 1);
 }
 
 void GPUParticleSystemUpdateParticlesNode::Execute(const RGExecuteContext& context)
 {
     GPUBuffer* emitterConstantBuffer = context.GetGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"));
-    GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("ParticlesDataBuffer"));
+    GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("DirtyEmittersFreeIndices_ParticlesDataBuffer"));
     GPUBuffer* emitterStatusBuffer = context.GetGPUBuffer(RESOURCEID("UpdateEmitters_EmitterStatusBuffer"));
     GPUBuffer* indicesBuffer = context.GetGPUBuffer(RESOURCEID("IndicesBuffer"));
     GPUBuffer* freeIndicesBuffer = context.GetGPUBuffer(RESOURCEID("DirtyEmittersFreeIndices_FreeIndicesBuffer"));
@@ -172,18 +197,72 @@ void GPUParticleSystemUpdateParticlesNode::Execute(const RGExecuteContext& conte
 
     CommandList& commandList = context.GetCommandList();
     SceneData& sceneData = context.GetSceneData();
-    std::vector<GPUEmitter*> enabledEmitters = sceneData.mGPUParticleSystem->GetEnabledEmitters();
+    GPUParticleSystem* particleSystem = sceneData.mGPUParticleSystem;
+    GPUEmittersView activeEmitters = particleSystem->GetActiveEmitters();
 
     GlobalTimer& timer = Engine::Get().GetTimer();
 
-    ShaderParametersLayout updateLayout;
-    updateLayout.SetConstant(0, 0, 2, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetSRV(1, 0, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetUAV(2, 0, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetUAV(3, 1, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetUAV(4, 2, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetUAV(5, 3, D3D12_SHADER_VISIBILITY_ALL);
-    updateLayout.SetUAV(6, 4, D3D12_SHADER_VISIBILITY_ALL);
+    // Uber kernel updates particles of all emitters in a single dispatch over the flattened work list
+    if (particleSystem->IsUberKernelReady())
+    {
+        if (activeEmitters.empty())
+        {
+            return;
+        }
+
+        GPUBuffer* emitterWorkBuffer = context.GetGPUBuffer(RESOURCEID("EmitterWorkBuffer"));
+
+        const uint32_t activeEmittersCount = activeEmitters.CountMatching();
+        EmitterWorkItem* workItems = reinterpret_cast<EmitterWorkItem*>(emitterWorkBuffer->Map(0, activeEmittersCount * sizeof(EmitterWorkItem)));
+
+        uint32_t groupsCount = 0;
+        for (GPUEmitter* emitter : activeEmitters)
+        {
+            EmitterWorkItem& workItem = *workItems++;
+            workItem.EmitterIndex = emitter->GetEmitterIndexGPU();
+            workItem.TemplateIndex = emitter->GetTemplateHandle().GetIndex();
+            workItem.GroupOffset = groupsCount;
+            workItem.GroupsCount = Align(emitter->GetParticleCapacity(), 64) / 64;
+
+            groupsCount += workItem.GroupsCount;
+        }
+        emitterWorkBuffer->Unmap(commandList);
+
+        if (groupsCount == 0)
+        {
+            return;
+        }
+
+        struct UpdateUberConstants
+        {
+            uint32_t emittersCount;
+            float deltaTime;
+        } uberConstants;
+
+        uberConstants.emittersCount = activeEmittersCount;
+        uberConstants.deltaTime = timer.GetDeltaTime();
+
+        const ShaderHandle shader = particleSystem->GetUberUpdateShader();
+        const ShaderParametersLayout& updateLayout = ShaderManager::Get().GetShaderParametersLayout(shader);
+
+        ComputePipelineState updateState;
+        updateState.SetCS(shader);
+        updateState.Bind(commandList, updateLayout);
+
+        ShaderParameters updateParams;
+        updateParams.SetConstant(0, uberConstants);
+        updateParams.SetSRV(1, *emitterConstantBuffer);
+        updateParams.SetSRV(2, *emitterWorkBuffer);
+        updateParams.SetUAV(3, *particlesDataBuffer);
+        updateParams.SetUAV(4, *emitterStatusBuffer);
+        updateParams.SetUAV(5, *indicesBuffer);
+        updateParams.SetUAV(6, *freeIndicesBuffer);
+        updateParams.SetUAV(7, *drawIndirectBuffer);
+        updateParams.Bind<false>(commandList, updateLayout);
+
+        commandList->Dispatch(groupsCount, 1, 1);
+        return;
+    }
 
     struct UpdateConstants
     {
@@ -193,12 +272,19 @@ void GPUParticleSystemUpdateParticlesNode::Execute(const RGExecuteContext& conte
 
     constants.deltaTime = timer.GetDeltaTime();
 
-    for (GPUEmitter* emitter : enabledEmitters)
+    const bool fusedKernel = particleSystem->GetKernelMode() == ParticleKernelMode::Fused;
+
+    for (GPUEmitter* emitter : activeEmitters)
     {
-        GPUEmitterTemplate* emitterTemplate = sceneData.mGPUParticleSystem->GetEmitterTemplate(emitter->GetTemplateHandle());
+        GPUEmitterTemplate* emitterTemplate = particleSystem->GetEmitterTemplate(emitter->GetTemplateHandle());
+
+        // Fused kernel has the same parameters as the update, emitters without it are spawned by the spawn node
+        const ShaderHandle fusedShader = fusedKernel ? emitterTemplate->GetFusedShader(emitter->GetConstantData()) : ShaderHandle{};
+        const ShaderHandle shader = fusedShader.GetHandle() != ShaderHandle::Invalid ? fusedShader : emitterTemplate->GetUpdateShader(emitter->GetConstantData());
+        const ShaderParametersLayout& updateLayout = ShaderManager::Get().GetShaderParametersLayout(shader);
 
         ComputePipelineState updateState;
-        updateState.SetCS(emitterTemplate->GetUpdateShader());
+        updateState.SetCS(shader);
         updateState.Bind(commandList, updateLayout);
 
         constants.emitterIndex = emitter->GetEmitterIndexGPU();
@@ -213,7 +299,8 @@ void GPUParticleSystemUpdateParticlesNode::Execute(const RGExecuteContext& conte
         updateParams.SetUAV(6, *drawIndirectBuffer);
         updateParams.Bind<false>(commandList, updateLayout);
 
-        commandList->Dispatch(emitter->GetMaxParticles(), 1, 1);
+        const uint32_t dispatchCount = Align(emitter->GetParticleCapacity(), 64) / 64;
+        commandList->Dispatch(dispatchCount, 1, 1);
     }
 }
 
@@ -223,29 +310,67 @@ void GPUParticleSystemSpawnParticlesNode::Execute(const RGExecuteContext& contex
     GPUBuffer* spawnIndirectBuffer = context.GetGPUBuffer(RESOURCEID("SpawnIndirectBuffer"));
     GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("Update_ParticlesDataBuffer"));
     GPUBuffer* freeIndicesBuffer = context.GetGPUBuffer(RESOURCEID("Update_FreeIndicesBuffer"));
-    GPUBuffer* indicesBuffer = context.GetGPUBuffer(RESOURCEID("IndicesBuffer"));
+    GPUBuffer* indicesBuffer = context.GetGPUBuffer(RESOURCEID("Update_IndicesBuffer"));
     GPUBuffer* drawIndirectBuffer = context.GetGPUBuffer(RESOURCEID("Update_DrawIndirectBuffer"));
     GPUBuffer* emitterStatusBuffer = context.GetGPUBuffer(RESOURCEID("Update_EmitterStatusBuffer"));
 
     CommandList& commandList = context.GetCommandList();
     SceneData& sceneData = context.GetSceneData();
-    std::vector<GPUEmitter*> enabledEmitters = sceneData.mGPUParticleSystem->GetEnabledEmitters();
-
-    ShaderParametersLayout spawnLayout;
-    spawnLayout.SetConstant(0, 0, 1, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetSRV(1, 0, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetUAV(2, 0, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetUAV(3, 1, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetUAV(4, 2, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetUAV(5, 3, D3D12_SHADER_VISIBILITY_ALL);
-    spawnLayout.SetUAV(6, 4, D3D12_SHADER_VISIBILITY_ALL);
-
-    for (GPUEmitter* emitter : enabledEmitters)
+    GPUParticleSystem* particleSystem = sceneData.mGPUParticleSystem;
+    GPUEmittersView activeEmitters = particleSystem->GetActiveEmitters();
+
+    // Groups of all emitters were reserved by the emitter update, their total is stored after per emitter arguments
+    if (particleSystem->IsUberKernelReady())
+    {
+        if (activeEmitters.empty())
+        {
+            return;
+        }
+
+        GPUBuffer* emitterWorkBuffer = context.GetGPUBuffer(RESOURCEID("EmitterWorkBuffer"));
+        GPUBuffer* spawnGroupTableBuffer = context.GetGPUBuffer(RESOURCEID("UpdateEmitters_SpawnGroupTableBuffer"));
+
+        const ShaderHandle shader = particleSystem->GetUberSpawnShader();
+        const ShaderParametersLayout& spawnLayout = ShaderManager::Get().GetShaderParametersLayout(shader);
+
+        ComputePipelineState spawnState;
+        spawnState.SetCS(shader);
+        spawnState.Bind(commandList, spawnLayout);
+
+        ShaderParameters spawnParams;
+        spawnParams.SetConstant(0, activeEmitters.CountMatching());
+        spawnParams.SetSRV(1, *emitterConstantBuffer);
+        spawnParams.SetSRV(2, *emitterWorkBuffer);
+        spawnParams.SetSRV(3, *spawnGroupTableBuffer);
+        spawnParams.SetUAV(4, *particlesDataBuffer);
+        spawnParams.SetUAV(5, *freeIndicesBuffer);
+        spawnParams.SetUAV(6, *indicesBuffer);
+        spawnParams.SetUAV(7, *drawIndirectBuffer);
+        spawnParams.SetUAV(8, *emitterStatusBuffer);
+        spawnParams.Bind<false>(commandList, spawnLayout);
+
+        const uint32_t dispatchOffset = GPUParticleSystem::MaxEmitters * sizeof(D3D12_DISPATCH_ARGUMENTS);
+        commandList.ExecuteIndirect(Graphic::Get().GetDefaultDispatchCommandSignature(), 1, spawnIndirectBuffer->GetResource(), dispatchOffset, nullptr, 0);
+        return;
+    }
+
+    const bool fusedKernel = particleSystem->GetKernelMode() == ParticleKernelMode::Fused;
+
+    for (GPUEmitter* emitter : activeEmitters)
     {
-        GPUEmitterTemplate* emitterTemplate = sceneData.mGPUParticleSystem->GetEmitterTemplate(emitter->GetTemplateHandle());
+        GPUEmitterTemplate* emitterTemplate = particleSystem->GetEmitterTemplate(emitter->GetTemplateHandle());
+
+        // Already spawned by the fused kernel in the update node
+        if (fusedKernel && emitterTemplate->GetFusedShader(emitter->GetConstantData()).GetHandle() != ShaderHandle::Invalid)
+        {
+            continue;
+        }
+
+        const ShaderHandle shader = emitterTemplate->GetSpawnShader(emitter->GetConstantData());
+        const ShaderParametersLayout& spawnLayout = ShaderManager::Get().GetShaderParametersLayout(shader);
 
         ComputePipelineState spawnState;
-        spawnState.SetCS(emitterTemplate->GetSpawnShader());
+        spawnState.SetCS(shader);
         spawnState.Bind(commandList, spawnLayout);
 
         ShaderParameters spawnParams;
@@ -259,31 +384,253 @@ void GPUParticleSystemSpawnParticlesNode::Execute(const RGExecuteContext& contex
         spawnParams.Bind<false>(commandList, spawnLayout);
 
         const uint32_t dispatchOffset = emitter->GetEmitterIndexGPU() * sizeof(D3D12_DISPATCH_ARGUMENTS);
-        commandList->ExecuteIndirect(Graphic::Get().GetDefaultDispatchCommandSignature(), 1, spawnIndirectBuffer->GetResource(), dispatchOffset, nullptr, 0);
+        commandList.ExecuteIndirect(Graphic::Get().GetDefaultDispatchCommandSignature(), 1, spawnIndirectBuffer->GetResource(), dispatchOffset, nullptr, 0);
     }
 }
 
-void GPUParticleSystemDrawParticlesNode::Execute(const RGExecuteContext& context)
+void GPUParticleSystemBuildSortKeysNode::Execute(const RGExecuteContext& context)
 {
-    Texture2D* renderTarget = context.GetTexture2D(RESOURCEID("RenderTarget"));
+    SceneData& sceneData = context.GetSceneData();
+    const ParticleSortMode sortMode = sceneData.mGPUParticleSystem->GetSortMode();
+
+    if (sortMode == ParticleSortMode::None)
+    {
+        return;
+    }
+
+    GPUBuffer* sceneBuffer = context.GetGPUBuffer(RESOURCEID("SceneBuffer"));
+    GPUBuffer* emitterConstantBuffer = context.GetGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"));
     GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_ParticlesDataBuffer"));
     GPUBuffer* indicesBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_IndicesBuffer"));
     GPUBuffer* drawIndirectBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_DrawIndirectBuffer"));
-    GPUBuffer* sceneBuffer = context.GetGPUBuffer(RESOURCEID("SceneBuffer"));
+    GPUBuffer* sortKeysBuffer = context.GetGPUBuffer(RESOURCEID("SortKeysBuffer"));
+    GPUBuffer* sortValuesBuffer = context.GetGPUBuffer(RESOURCEID("SortValuesBuffer"));
+    GPUBuffer* sortCountBuffer = context.GetGPUBuffer(RESOURCEID("SortCountBuffer"));
 
     CommandList& commandList = context.GetCommandList();
+
+    uint32_t* countData = reinterpret_cast<uint32_t*>(sortCountBuffer->Map());
+    *countData = 0;
+    sortCountBuffer->Unmap(commandList);
+
+    GPUEmittersView activeEmitters = sceneData.mGPUParticleSystem->GetActiveEmitters();
+
+    // Emitters are ranked back to front by their position, so in per emitter mode whole emitters are blended in the right order
+
+    const XMMATRIX view = sceneData.mCamera->GetView();
+    std::vector<std::pair<float, GPUEmitter*>> emitterDepths;
+    emitterDepths.reserve(activeEmitters.CountMatching());
+
+    for (GPUEmitter* emitter : activeEmitters)
+    {
+        const XMVECTOR position = XMLoadFloat3(&emitter->GetConstantData().Position);
+        emitterDepths.push_back({ XMVectorGetZ(XMVector3TransformCoord(position, view)), emitter });
+    }
+
+    std::stable_sort(emitterDepths.begin(), emitterDepths.end(), [](const std::pair<float, GPUEmitter*>& lhs, const std::pair<float, GPUEmitter*>& rhs) {
+        return lhs.first > rhs.first;
+        });
+
+    struct BuildSortKeysConstants
+    {
+        uint32_t emitterIndex;
+        uint32_t emitterRank;
+        uint32_t sortMode;
+    } constants;
+
+    constants.sortMode = static_cast<uint32_t>(sortMode);
+
+    const ShaderParametersLayout& buildKeysLayout = ShaderManager::Get().GetShaderParametersLayout(CS_BuildSortKeys);
+
+    ComputePipelineState buildKeysState;
+    buildKeysState.SetCS(CS_BuildSortKeys);
+    buildKeysState.Bind(commandList, buildKeysLayout);
+
+    for (uint32_t rank = 0; rank < emitterDepths.size(); ++rank)
+    {
+        GPUEmitter* emitter = emitterDepths[rank].second;
+
+        const uint32_t capacity = emitter->GetParticleCapacity();
+        if (capacity == 0)
+        {
+            continue;
+        }
+
+        constants.emitterIndex = emitter->GetEmitterIndexGPU();
+        constants.emitterRank = rank;
+
+        ShaderParameters buildKeysParams;
+        buildKeysParams.SetConstant(0, constants);
+        buildKeysParams.SetSRV(1, *sceneBuffer);
+        buildKeysParams.SetSRV(2, *emitterConstantBuffer);
+        buildKeysParams.SetSRV(3, *particlesDataBuffer);
+        buildKeysParams.SetSRV(4, *indicesBuffer);
+        buildKeysParams.SetSRV(5, *drawIndirectBuffer);
+        buildKeysParams.SetUAV(6, *sortKeysBuffer);
+        buildKeysParams.SetUAV(7, *sortValuesBuffer);
+        buildKeysParams.SetUAV(8, *sortCountBuffer);
+        buildKeysParams.Bind<false>(commandList, buildKeysLayout);
+
+        const uint32_t dispatchCount = Align(capacity, 64) / 64;
+        commandList->Dispatch(dispatchCount, 1, 1);
+    }
+}
+
+void GPUParticleSystemSortParticlesNode::Execute(const RGExecuteContext& context)
+{
     SceneData& sceneData = context.GetSceneData();
-    std::vector<GPUEmitter*> emitters = sceneData.mGPUParticleSystem->GetEmitters();
 
-    Sampler defaultSampler;
+    if (sceneData.mGPUParticleSystem->GetSortMode() == ParticleSortMode::None)
+    {
+        return;
+    }
+
+    // Number of alive particles is known only on the GPU, so passes are recorded for the capacity of all active emitters
+    uint32_t maxCount = 0;
+    for (GPUEmitter* emitter : sceneData.mGPUParticleSystem->GetActiveEmitters())
+    {
+        maxCount += emitter->GetParticleCapacity();
+    }
+
+    if (maxCount <= 1)
+    {
+        return;
+    }
+
+    GPUBuffer* sortCountBuffer = context.GetGPUBuffer(RESOURCEID("SortCountBuffer"));
+    GPUBuffer* sortKeysBuffer = context.GetGPUBuffer(RESOURCEID("BuildSortKeys_SortKeysBuffer"));
+    GPUBuffer* sortValuesBuffer = context.GetGPUBuffer(RESOURCEID("BuildSortKeys_SortValuesBuffer"));
+
+    CommandList& commandList = context.GetCommandList();
+
+    enum class BitonicSortMode : uint32_t
+    {
+        LocalSort = 0,
+        Flip,
+        Disperse,
+        LocalDisperse
+    };
+
+    struct BitonicSortConstants
+    {
+        BitonicSortMode mode;
+        uint32_t height;
+    };
+
+    const ShaderParametersLayout& sortLayout = ShaderManager::Get().GetShaderParametersLayout(CS_BitonicSort);
+
+    ComputePipelineState sortState;
+    sortState.SetCS(CS_BitonicSort);
+    sortState.Bind(commandList, sortLayout);
+
+    ShaderParameters sortParams;
+    sortParams.SetSRV(1, *sortCountBuffer);
+    sortParams.SetUAV(2, *sortKeysBuffer);
+    sortParams.SetUAV(3, *sortValuesBuffer);
+    sortParams.Bind<false>(commandList, sortLayout);
+
+    const std::array<D3D12_RESOURCE_BARRIER, 2> uavBarriers = {
+        CD3DX12_RESOURCE_BARRIER::UAV(sortKeysBuffer->GetResource()),
+        CD3DX12_RESOURCE_BARRIER::UAV(sortValuesBuffer->GetResource())
+    };
+
+    // Each pass depends on the previous one
+    auto dispatchPass = [&](BitonicSortMode mode, uint32_t height, uint32_t groupsCount) {
+        ShaderParameters passParams;
+        passParams.SetConstant(0, BitonicSortConstants{ mode, height });
+        passParams.Bind<false>(commandList, sortLayout);
+
+        commandList->Dispatch(groupsCount, 1, 1);
+        commandList->ResourceBarrier(static_cast<uint32_t>(uavBarriers.size()), uavBarriers.data());
+    };
+
+    // Steps that fit into LocalSortSize elements are done in shared memory, bigger ones go through global memory, one per pass
+    const uint32_t localSize = ParticleSort::LocalSortSize;
+    const uint32_t sortSize = NextPow2(maxCount);
+    const uint32_t localGroupsCount = Align(maxCount, localSize) / localSize;
+    const uint32_t globalGroupsCount = sortSize / localSize;
 
-    ShaderParametersLayout drawLayout;
-    drawLayout.SetConstant(0, 0, 1, D3D12_SHADER_VISIBILITY_VERTEX);
-    drawLayout.SetSRV(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
-    drawLayout.SetSRV(2, 1, D3D12_SHADER_VISIBILITY_VERTEX);
-    drawLayout.SetSRV(3, 2, D3D12_SHADER_VISIBILITY_VERTEX);
-    //drawLayout.SetSRV(3, 2, D3D12_SHADER_VISIBILITY_PIXEL);
-    drawLayout.SetStaticSampler(0, defaultSampler, D3D12_SHADER_VISIBILITY_PIXEL);
+    dispatchPass(BitonicSortMode::LocalSort, localSize, localGroupsCount);
+
+    for (uint32_t height = localSize * 2; height <= sortSize; height *= 2)
+    {
+        dispatchPass(BitonicSortMode::Flip, height, globalGroupsCount);
+
+        for (uint32_t disperseHeight = height / 2; disperseHeight > localSize; disperseHeight /= 2)
+        {
+            dispatchPass(BitonicSortMode::Disperse, disperseHeight, globalGroupsCount);
+        }
+
+        dispatchPass(BitonicSortMode::LocalDisperse, localSize, localGroupsCount);
+    }
+}
+
+void GPUParticleSystemPrepareDrawParticlesNode::Execute(const RGExecuteContext& context)
+{
+    GPUBuffer* emitterConstantBuffer = context.GetGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"));
+    GPUBuffer* emitterIndexBuffer = context.GetGPUBuffer(RESOURCEID("EmitterIndexBuffer"));
+    GPUBuffer* drawIndirectBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_DrawIndirectBuffer"));
+    GPUBuffer* drawCommandsBuffer = context.GetGPUBuffer(RESOURCEID("DrawCommandsBuffer"));
+    GPUBuffer* drawCountBuffer = context.GetGPUBuffer(RESOURCEID("DrawCountBuffer"));
+    GPUBuffer* sortCountBuffer = context.GetGPUBuffer(RESOURCEID("SortCountBuffer"));
+
+    CommandList& commandList = context.GetCommandList();
+    GPUParticleSystem* particleSystem = context.GetSceneData().mGPUParticleSystem;
+
+    // Draw commands are appended from many thread groups, so the count is reset before the dispatch
+    uint32_t* countData = reinterpret_cast<uint32_t*>(drawCountBuffer->Map());
+    *countData = 0;
+    drawCountBuffer->Unmap(commandList);
+
+    struct PrepareDrawConstants
+    {
+        uint32_t emittersCount;
+        uint32_t sortMode;
+    } constants;
+
+    // Emitter index buffer has been filled with active emitters by the update emitters node
+    constants.emittersCount = particleSystem->GetActiveEmitters().CountMatching();
+    constants.sortMode = static_cast<uint32_t>(particleSystem->GetSortMode());
+
+    const ShaderParametersLayout& prepareDrawLayout = ShaderManager::Get().GetShaderParametersLayout(CS_PrepareDraw);
+
+    ComputePipelineState prepareDrawState;
+    prepareDrawState.SetCS(CS_PrepareDraw);
+    prepareDrawState.Bind(commandList, prepareDrawLayout);
+
+    ShaderParameters prepareDrawParams;
+    prepareDrawParams.SetConstant(0, constants);
+    prepareDrawParams.SetSRV(1, *emitterConstantBuffer);
+    prepareDrawParams.SetSRV(2, *emitterIndexBuffer);
+    prepareDrawParams.SetSRV(3, *drawIndirectBuffer);
+    prepareDrawParams.SetSRV(4, *sortCountBuffer);
+    prepareDrawParams.SetUAV(5, *drawCommandsBuffer);
+    prepareDrawParams.SetUAV(6, *drawCountBuffer);
+    prepareDrawParams.Bind<false>(commandList, prepareDrawLayout);
+
+    // Sorted particles are drawn with a single command
+    const uint32_t dispatchCount = constants.sortMode != static_cast<uint32_t>(ParticleSortMode::None) ? 1 : Align(constants.emittersCount, 64) / 64;
+    if (dispatchCount > 0)
+    {
+        commandList->Dispatch(dispatchCount, 1, 1);
+    }
+}
+
+void GPUParticleSystemDrawParticlesNode::Execute(const RGExecuteContext& context)
+{
+    Texture2D* renderTarget = context.GetTexture2D(RESOURCEID("RenderTarget"));
+    GPUBuffer* particlesDataBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_ParticlesDataBuffer"));
+    GPUBuffer* drawCommandsBuffer = context.GetGPUBuffer(RESOURCEID("DrawCommandsBuffer"));
+    GPUBuffer* drawCountBuffer = context.GetGPUBuffer(RESOURCEID("DrawCountBuffer"));
+    GPUBuffer* sceneBuffer = context.GetGPUBuffer(RESOURCEID("SceneBuffer"));
+
+    // Sorted particles are drawn with a single command, that uses global particle indices
+    const bool sorted = context.GetSceneData().mGPUParticleSystem->GetSortMode() != ParticleSortMode::None;
+    GPUBuffer* indicesBuffer = context.GetGPUBuffer(sorted ? RESOURCEID("Sort_SortValuesBuffer") : RESOURCEID("Spawn_IndicesBuffer"));
+
+    CommandList& commandList = context.GetCommandList();
+
+    const ShaderParametersLayout& drawLayout = ShaderManager::Get().GetShaderParametersLayout(VS_DrawParticle, PS_DrawParticle);
 
     GraphicPipelineState drawState;
     drawState.SetVS(VS_DrawParticle);
@@ -305,19 +652,29 @@ void GPUParticleSystemDrawParticlesNode::Execute(const RGExecuteContext& context
     commandList->OMSetRenderTargets(static_cast<uint32_t>(rtvHandles.size()), rtvHandles.data(), true, nullptr);
     MeshManager::Get().Bind(commandList, MeshType::Square);
 
-    for (GPUEmitter* emitter : emitters)
-    {
-        const uint32_t constant = static_cast<uint32_t>(emitter->GetParticleAllocation().Start);
-
-        ShaderParameters drawParams;
-        drawParams.SetConstant(0, constant);
-        drawParams.SetSRV(1, *sceneBuffer);
-        drawParams.SetSRV(2, *particlesDataBuffer);
-        drawParams.SetSRV(3, *indicesBuffer);
-        //drawParams.SetSRV(4, *texture);
-        drawParams.Bind<true>(commandList, drawLayout);
-
-        const uint32_t drawOffset = emitter->GetEmitterIndexGPU() * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
-        commandList->ExecuteIndirect(Graphic::Get().GetDefaultDrawCommandSignature(), 1, drawIndirectBuffer->GetResource(), drawOffset, nullptr, 0);
-    }
+    // Particles offset is set per emitter by the command signature
+    ShaderParameters drawParams;
+    drawParams.SetSRV(1, *sceneBuffer);
+    drawParams.SetSRV(2, *particlesDataBuffer);
+    drawParams.SetSRV(3, *indicesBuffer);
+    //drawParams.SetSRV(4, *texture);
+    drawParams.Bind<true>(commandList, drawLayout);
+
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC> indirectArgs(2);
+    indirectArgs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    indirectArgs[0].Constant.RootParameterIndex = 0;
+    indirectArgs[0].Constant.DestOffsetIn32BitValues = 0;
+    indirectArgs[0].Constant.Num32BitValuesToSet = 1;
+    indirectArgs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    ID3D12CommandSignature* drawCommandSignature = PSOManager::Get().CompileCommandSignature(drawLayout, indirectArgs, sizeof(DrawParticlesCommand));
+    commandList.ExecuteIndirect(drawCommandSignature, GPUParticleSystem::MaxEmitters, drawCommandsBuffer->GetResource(), 0, drawCountBuffer->GetResource(), 0);
+}
+
+void GPUParticleSystemReadbackEmittersStatusNode::Execute(const RGExecuteContext& context)
+{
+    GPUBuffer* emitterStatusBuffer = context.GetGPUBuffer(RESOURCEID("Spawn_EmitterStatusBuffer"));
+    GPUReadbackBuffer* readbackBuffer = context.GetSceneData().mGPUParticleSystem->GetEmitterStatusReadbackBuffer();
+
+    readbackBuffer->CopyFrom(context.GetCommandList(), *emitterStatusBuffer, 0, emitterStatusBuffer->GetBufferSize());
 }
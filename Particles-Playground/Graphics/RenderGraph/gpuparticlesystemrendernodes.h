@@ -19,6 +19,7 @@ class GPUParticleSystemDirtyEmittersFreeIndicesNode : public IRenderNodeBase
 public:
     void Setup(RGSetupContext& context) override
     {
+        context.InputOutputGPUBuffer(RESOURCEID("ParticlesDataBuffer"), RESOURCEID("DirtyEmittersFreeIndices_ParticlesDataBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("FreeIndicesBuffer"), RESOURCEID("DirtyEmittersFreeIndices_FreeIndicesBuffer"), BufferUsage::UnorderedAccess);
     }
 
@@ -31,14 +32,15 @@ public:
     void Setup(RGSetupContext& context) override
     {
         RGNewGPUBuffer& newBuffer = context.OutputGPUBuffer(RESOURCEID("SpawnIndirectBuffer"), BufferUsage::UnorderedAccess);
-        newBuffer.mElemSize = static_cast<uint32_t>(sizeof(D3D12_DISPATCH_ARGUMENTS) + sizeof(uint32_t));
-        newBuffer.mNumElems = GPUParticleSystem::MaxEmitters;
-        newBuffer.mUsage = BufferUsage::Indirect | BufferUsage::UnorderedAccess;
+        newBuffer.mElemSize = static_cast<uint32_t>(sizeof(D3D12_DISPATCH_ARGUMENTS));
+        newBuffer.mNumElems = GPUParticleSystem::MaxEmitters + 1; // Last one is for the uber spawn dispatch
+        newBuffer.mUsage = BufferUsage::Indirect | BufferUsage::UnorderedAccess | BufferUsage::CopyDst;
 
         context.InputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"), BufferUsage::Structured);
         context.InputGPUBuffer(RESOURCEID("EmitterIndexBuffer"), BufferUsage::Structured);
         context.InputOutputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterStatusBuffer"), RESOURCEID("UpdateEmitters_EmitterStatusBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_DrawIndirectBuffer"), RESOURCEID("UpdateEmitters_DrawIndirectBuffer"), BufferUsage::UnorderedAccess);
+        context.InputOutputGPUBuffer(RESOURCEID("SpawnGroupTableBuffer"), RESOURCEID("UpdateEmitters_SpawnGroupTableBuffer"), BufferUsage::UnorderedAccess);
     }
 
     void Execute(const RGExecuteContext& context) override;
@@ -49,13 +51,10 @@ class GPUParticleSystemUpdateParticlesNode : public IRenderNodeBase
 public:
     void Setup(RGSetupContext& context) override
     {
-        RGNewGPUBuffer& newBuffer = context.OutputGPUBuffer(RESOURCEID("IndicesBuffer"), BufferUsage::UnorderedAccess);
-        newBuffer.mElemSize = static_cast<uint32_t>(sizeof(int32_t));
-        newBuffer.mNumElems = GPUParticleSystem::MaxParticles;
-        newBuffer.mUsage = BufferUsage::Structured | BufferUsage::UnorderedAccess;
-
         context.InputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"), BufferUsage::Structured);
-        context.InputOutputGPUBuffer(RESOURCEID("ParticlesDataBuffer"), RESOURCEID("Update_ParticlesDataBuffer"), BufferUsage::UnorderedAccess);
+        context.InputGPUBuffer(RESOURCEID("EmitterWorkBuffer"), BufferUsage::Structured);
+        context.InputOutputGPUBuffer(RESOURCEID("IndicesBuffer"), RESOURCEID("Update_IndicesBuffer"), BufferUsage::UnorderedAccess);
+        context.InputOutputGPUBuffer(RESOURCEID("DirtyEmittersFreeIndices_ParticlesDataBuffer"), RESOURCEID("Update_ParticlesDataBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("UpdateEmitters_EmitterStatusBuffer"), RESOURCEID("Update_EmitterStatusBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("DirtyEmittersFreeIndices_FreeIndicesBuffer"), RESOURCEID("Update_FreeIndicesBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("UpdateEmitters_DrawIndirectBuffer"), RESOURCEID("Update_DrawIndirectBuffer"), BufferUsage::UnorderedAccess);
@@ -71,9 +70,11 @@ public:
     {
         context.InputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"), BufferUsage::Structured);
         context.InputGPUBuffer(RESOURCEID("SpawnIndirectBuffer"), BufferUsage::Indirect);
+        context.InputGPUBuffer(RESOURCEID("EmitterWorkBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("UpdateEmitters_SpawnGroupTableBuffer"), BufferUsage::Structured);
         context.InputOutputGPUBuffer(RESOURCEID("Update_ParticlesDataBuffer"), RESOURCEID("Spawn_ParticlesDataBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("Update_FreeIndicesBuffer"), RESOURCEID("Spawn_FreeIndicesBuffer"), BufferUsage::UnorderedAccess);
-        context.InputOutputGPUBuffer(RESOURCEID("IndicesBuffer"), RESOURCEID("Spawn_IndicesBuffer"), BufferUsage::UnorderedAccess);
+        context.InputOutputGPUBuffer(RESOURCEID("Update_IndicesBuffer"), RESOURCEID("Spawn_IndicesBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("Update_DrawIndirectBuffer"), RESOURCEID("Spawn_DrawIndirectBuffer"), BufferUsage::UnorderedAccess);
         context.InputOutputGPUBuffer(RESOURCEID("Update_EmitterStatusBuffer"), RESOURCEID("Spawn_EmitterStatusBuffer"), BufferUsage::UnorderedAccess);
     }
@@ -81,6 +82,65 @@ public:
     void Execute(const RGExecuteContext& context) override;
 };
 
+class GPUParticleSystemBuildSortKeysNode : public IRenderNodeBase
+{
+public:
+    void Setup(RGSetupContext& context) override
+    {
+        RGNewGPUBuffer& newBuffer = context.OutputGPUBuffer(RESOURCEID("SortCountBuffer"), BufferUsage::CopyDst);
+        newBuffer.mElemSize = static_cast<uint32_t>(sizeof(uint32_t));
+        newBuffer.mNumElems = 1;
+        newBuffer.mUsage = BufferUsage::Structured | BufferUsage::UnorderedAccess | BufferUsage::CopyDst;
+
+        context.InputGPUBuffer(RESOURCEID("SceneBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("Spawn_ParticlesDataBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("Spawn_IndicesBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("Spawn_DrawIndirectBuffer"), BufferUsage::Structured);
+        context.InputOutputGPUBuffer(RESOURCEID("SortKeysBuffer"), RESOURCEID("BuildSortKeys_SortKeysBuffer"), BufferUsage::UnorderedAccess);
+        context.InputOutputGPUBuffer(RESOURCEID("SortValuesBuffer"), RESOURCEID("BuildSortKeys_SortValuesBuffer"), BufferUsage::UnorderedAccess);
+    }
+
+    void Execute(const RGExecuteContext& context) override;
+};
+
+class GPUParticleSystemSortParticlesNode : public IRenderNodeBase
+{
+public:
+    void Setup(RGSetupContext& context) override
+    {
+        context.InputGPUBuffer(RESOURCEID("SortCountBuffer"), BufferUsage::Structured);
+        context.InputOutputGPUBuffer(RESOURCEID("BuildSortKeys_SortKeysBuffer"), RESOURCEID("Sort_SortKeysBuffer"), BufferUsage::UnorderedAccess);
+        context.InputOutputGPUBuffer(RESOURCEID("BuildSortKeys_SortValuesBuffer"), RESOURCEID("Sort_SortValuesBuffer"), BufferUsage::UnorderedAccess);
+    }
+
+    void Execute(const RGExecuteContext& context) override;
+};
+
+class GPUParticleSystemPrepareDrawParticlesNode : public IRenderNodeBase
+{
+public:
+    void Setup(RGSetupContext& context) override
+    {
+        RGNewGPUBuffer& commandsBuffer = context.OutputGPUBuffer(RESOURCEID("DrawCommandsBuffer"), BufferUsage::UnorderedAccess);
+        commandsBuffer.mElemSize = static_cast<uint32_t>(sizeof(DrawParticlesCommand));
+        commandsBuffer.mNumElems = GPUParticleSystem::MaxEmitters;
+        commandsBuffer.mUsage = BufferUsage::Indirect | BufferUsage::Structured | BufferUsage::UnorderedAccess;
+
+        RGNewGPUBuffer& countBuffer = context.OutputGPUBuffer(RESOURCEID("DrawCountBuffer"), BufferUsage::UnorderedAccess);
+        countBuffer.mElemSize = static_cast<uint32_t>(sizeof(uint32_t));
+        countBuffer.mNumElems = 1;
+        countBuffer.mUsage = BufferUsage::Indirect | BufferUsage::Structured | BufferUsage::UnorderedAccess | BufferUsage::CopyDst;
+
+        context.InputGPUBuffer(RESOURCEID("UpdateDirtyEmitters_EmitterConstantBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("EmitterIndexBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("Spawn_DrawIndirectBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("SortCountBuffer"), BufferUsage::Structured);
+    }
+
+    void Execute(const RGExecuteContext& context) override;
+};
+
 class GPUParticleSystemDrawParticlesNode : public IRenderNodeBase
 {
 public:
@@ -95,7 +155,20 @@ public:
         context.InputGPUBuffer(RESOURCEID("SceneBuffer"), BufferUsage::Structured);
         context.InputGPUBuffer(RESOURCEID("Spawn_ParticlesDataBuffer"), BufferUsage::Structured);
         context.InputGPUBuffer(RESOURCEID("Spawn_IndicesBuffer"), BufferUsage::Structured);
-        context.InputGPUBuffer(RESOURCEID("Spawn_DrawIndirectBuffer"), BufferUsage::Indirect);
+        context.InputGPUBuffer(RESOURCEID("Sort_SortValuesBuffer"), BufferUsage::Structured);
+        context.InputGPUBuffer(RESOURCEID("DrawCommandsBuffer"), BufferUsage::Indirect);
+        context.InputGPUBuffer(RESOURCEID("DrawCountBuffer"), BufferUsage::Indirect);
+    }
+
+    void Execute(const RGExecuteContext& context) override;
+};
+
+class GPUParticleSystemReadbackEmittersStatusNode : public IRenderNodeBase
+{
+public:
+    void Setup(RGSetupContext& context) override
+    {
+        context.InputGPUBuffer(RESOURCEID("Spawn_EmitterStatusBuffer"), BufferUsage::CopySrc);
     }
 
     void Execute(const RGExecuteContext& context) override;
@@ -0,0 +1,65 @@
+#include "Graphics/cpuemitter.h"
+#include "Graphics/cpuparticlesystem.h"
+
+CPUEmitter::CPUEmitter(CPUParticleSystem* particleSystem, CPUEmitterTemplateHandle emitterTemplate, uint32_t maxParticles)
+    : mTemplateHandle(emitterTemplate)
+{
+    Assert(maxParticles > 0);
+
+    mConstantData.MaxParticles = maxParticles;
+
+    mParticles.Resize(maxParticles);
+    mFreeList.resize(maxParticles);
+    mIndices.resize(maxParticles);
+
+    const uint32_t chunksCount = Align(maxParticles, CPUParticleSystem::ParticlesChunkSize) / CPUParticleSystem::ParticlesChunkSize;
+    mChunkResults.resize(chunksCount);
+
+    mInitialSeed = particleSystem->GetRandomNumber();
+}
+
+void CPUEmitter::Reset()
+{
+    mStatusData = EmitterStatusData{ mInitialSeed };
+
+    mParticles.Reset();
+    std::iota(mFreeList.begin(), mFreeList.end(), 0);
+    mInstanceCount = 0;
+
+    mDirty = false;
+}
+
+CPUEmitter& CPUEmitter::SetSpawnRate(float spawnRate)
+{
+    mConstantData.SpawnRate = spawnRate;
+    SetDitry();
+    return *this;
+}
+
+CPUEmitter& CPUEmitter::SetParticleLifeTime(float lifeTime)
+{
+    mConstantData.LifeTime = lifeTime;
+    SetDitry();
+    return *this;
+}
+
+CPUEmitter& CPUEmitter::SetParticleColor(const XMFLOAT4& color)
+{
+    mConstantData.Color = color;
+    SetDitry();
+    return *this;
+}
+
+CPUEmitter& CPUEmitter::SetPosition(const XMFLOAT3& position)
+{
+    mConstantData.Position = position;
+    SetDitry();
+    return *this;
+}
+
+CPUEmitter& CPUEmitter::SetLoopTime(float loopTime)
+{
+    mConstantData.LoopTime = loopTime;
+    SetDitry();
+    return *this;
+}
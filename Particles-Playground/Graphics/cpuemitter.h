@@ -0,0 +1,75 @@
+#pragma once
+#include "Graphics/cpuemittertemplate.h"
+
+class CPUParticleSystem;
+
+// CPU counterpart of GPUEmitter, owns its particles instead of allocating them from a shared pool
+class CPUEmitter : public IObject<CPUEmitter>
+{
+    friend class CPUParticleSystem;
+
+public:
+    CPUEmitter(CPUParticleSystem* particleSystem, CPUEmitterTemplateHandle emitterTemplate, uint32_t maxParticles);
+    ~CPUEmitter() = default;
+
+    CPUEmitter(CPUEmitter&&) = delete;
+    CPUEmitter& operator=(CPUEmitter&&) = delete;
+
+    CPUEmitter(const CPUEmitter&) = delete;
+    CPUEmitter& operator=(const CPUEmitter&) = delete;
+
+    CPUEmitter& SetSpawnRate(float spawnRate);
+    CPUEmitter& SetParticleLifeTime(float lifeTime);
+    CPUEmitter& SetParticleColor(const XMFLOAT4& color);
+    CPUEmitter& SetPosition(const XMFLOAT3& position);
+    CPUEmitter& SetLoopTime(float loopTime);
+
+    inline const EmitterConstantData& GetConstantData() const { return mConstantData; }
+    inline const EmitterStatusData& GetStatusData() const { return mStatusData; }
+
+    inline bool GetEnabled() const { return mEnabled; }
+    inline void SetEnabled(bool value) { mEnabled = value; }
+
+    inline bool GetDirty() const { return mDirty; }
+    inline void SetDitry() { mDirty = true; }
+
+    inline bool GetSleeping() const { return mStatusData.State == EmitterState::Sleeping; }
+
+    inline void SetTemplateHandle(CPUEmitterTemplateHandle handle) { mTemplateHandle = handle; }
+    inline CPUEmitterTemplateHandle GetTemplateHandle() const { return mTemplateHandle; }
+
+    inline uint32_t GetMaxParticles() const { return mConstantData.MaxParticles; }
+
+    // Alive particles in the order they would be drawn by the GPU
+    inline const std::vector<uint32_t>& GetIndices() const { return mIndices; }
+    inline uint32_t GetAliveParticlesCount() const { return mInstanceCount; }
+    inline const CPUParticleData& GetParticles() const { return mParticles; }
+
+private:
+    void Reset();
+
+    CPUEmitterTemplateHandle mTemplateHandle;
+
+    EmitterConstantData mConstantData;
+    EmitterStatusData mStatusData;
+
+    CPUParticleData mParticles;
+    std::vector<uint32_t> mFreeList;
+    std::vector<uint32_t> mIndices;
+    uint32_t mInstanceCount = 0;
+
+    // Results of particle chunks updated in parallel, merged in order so the simulation stays deterministic
+    struct ChunkResult
+    {
+        std::vector<uint32_t> Alive;
+        std::vector<uint32_t> Dead;
+    };
+    std::vector<ChunkResult> mChunkResults;
+
+    bool mDirty = true;
+    bool mEnabled = true;
+
+    uint32_t mInitialSeed = 0;
+};
+
+using CPUEmitterHandle = ObjectHandle<CPUEmitter>;
@@ -0,0 +1,44 @@
+#include "Graphics/cpuemitterkernels.h"
+#include "Utilities/memory.h"
+
+void CPUParticleData::Resize(uint32_t count)
+{
+    const uint32_t paddedCount = Align(count, Simd::Width);
+
+    for (std::vector<float>* attribute : { &PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &LifeTime, &Scale, &ColorR, &ColorG, &ColorB, &ColorA })
+    {
+        attribute->resize(paddedCount);
+    }
+
+    Reset();
+}
+
+void CPUParticleData::Reset()
+{
+    for (std::vector<float>* attribute : { &PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ, &LifeTime, &Scale, &ColorR, &ColorG, &ColorB, &ColorA })
+    {
+        std::fill(attribute->begin(), attribute->end(), 0.0f);
+    }
+}
+
+ParticleData CPUParticleData::GetParticle(uint32_t index) const
+{
+    ParticleData result;
+    result.Position = { PositionX[index], PositionY[index], PositionZ[index] };
+    result.LifeTime = LifeTime[index];
+    result.Velocity = { VelocityX[index], VelocityY[index], VelocityZ[index] };
+    result.Scale = Scale[index];
+    result.Color = { ColorR[index], ColorG[index], ColorB[index], ColorA[index] };
+    return result;
+}
+
+Simd::UInt CPUParticleRandom::GetRandom()
+{
+    mSeed = RngType::xxHash32().GetRandom(mSeed, mParticleIndices);
+    return mSeed;
+}
+
+Simd::Float CPUParticleRandom::GetRandomFloat()
+{
+    return ConvertRandomToFloat(GetRandom());
+}
@@ -0,0 +1,254 @@
+#pragma once
+#include "Graphics/gpuemitter.h"
+#include "Utilities/simd.h"
+
+using ParticleAttributeType = uint8_t;
+
+enum class ParticleAttribute : ParticleAttributeType
+{
+    None     = 0,
+    Position = 1 << 0,
+    Velocity = 1 << 1,
+    LifeTime = 1 << 2,
+    Scale    = 1 << 3,
+    Color    = 1 << 4,
+    All      = Position | Velocity | LifeTime | Scale | Color
+};
+
+constexpr ParticleAttribute operator|(ParticleAttribute lhs, ParticleAttribute rhs) {
+    return static_cast<ParticleAttribute>(static_cast<ParticleAttributeType>(lhs) | static_cast<ParticleAttributeType>(rhs));
+}
+
+constexpr ParticleAttribute operator&(ParticleAttribute lhs, ParticleAttribute rhs) {
+    return static_cast<ParticleAttribute>(static_cast<ParticleAttributeType>(lhs) & static_cast<ParticleAttributeType>(rhs));
+}
+
+constexpr bool HasAttribute(ParticleAttribute attributes, ParticleAttribute attribute) {
+    return (attributes & attribute) == attribute;
+}
+
+// Particles are stored as structure of arrays, every array is padded to the SIMD width
+struct CPUParticleData
+{
+    std::vector<float> PositionX;
+    std::vector<float> PositionY;
+    std::vector<float> PositionZ;
+    std::vector<float> VelocityX;
+    std::vector<float> VelocityY;
+    std::vector<float> VelocityZ;
+    std::vector<float> LifeTime;
+    std::vector<float> Scale;
+    std::vector<float> ColorR;
+    std::vector<float> ColorG;
+    std::vector<float> ColorB;
+    std::vector<float> ColorA;
+
+    void Resize(uint32_t count);
+    void Reset();
+    ParticleData GetParticle(uint32_t index) const;
+};
+
+// SIMD version of ParticleRandomNumberGenerator, every lane behaves like a single GPU thread
+class CPUParticleRandom
+{
+public:
+    CPUParticleRandom(uint32_t emitterSeed, Simd::UInt particleIndices)
+        : mSeed(emitterSeed), mParticleIndices(particleIndices)
+    { }
+
+    Simd::UInt GetRandom();
+    Simd::Float GetRandomFloat();
+
+private:
+    Simd::UInt mSeed;
+    Simd::UInt mParticleIndices;
+};
+
+class CPUEmitterScript;
+
+struct CPUKernelContext
+{
+    const EmitterConstantData& EmitterConstant;
+    uint32_t EmitterSeed;
+    float DeltaTime;
+    const CPUEmitterScript* Script = nullptr;
+};
+
+// Update kernels get a range aligned to the SIMD width and have to leave dead particles untouched
+using CPUUpdateKernel = void(*)(const CPUKernelContext& context, CPUParticleData& particles, uint32_t start, uint32_t count);
+
+// Spawn kernels initialize particles stored under given indices
+using CPUSpawnKernel = void(*)(const CPUKernelContext& context, CPUParticleData& particles, const uint32_t* particleIndices, uint32_t count);
+
+// One SIMD register per particle's component, only attributes from the set are loaded and stored
+template<ParticleAttribute Attributes>
+struct CPUParticleLanes
+{
+    Simd::Float PositionX{ 0.0f };
+    Simd::Float PositionY{ 0.0f };
+    Simd::Float PositionZ{ 0.0f };
+    Simd::Float VelocityX{ 0.0f };
+    Simd::Float VelocityY{ 0.0f };
+    Simd::Float VelocityZ{ 0.0f };
+    Simd::Float LifeTime{ 0.0f };
+    Simd::Float Scale{ 0.0f };
+    Simd::Float ColorR{ 0.0f };
+    Simd::Float ColorG{ 0.0f };
+    Simd::Float ColorB{ 0.0f };
+    Simd::Float ColorA{ 0.0f };
+
+    // Contiguous particles starting at index
+    void Load(const CPUParticleData& particles, uint32_t index)
+    {
+        ForEachComponent([&](Simd::Float& lanes, const std::vector<float>& data) {
+            lanes = Simd::Float::Load(&data[index]);
+            }, *this, particles);
+    }
+
+    // Lanes outside of the mask keep their old values
+    void Store(CPUParticleData& particles, uint32_t index, Simd::Float mask) const
+    {
+        ForEachComponent([&](const Simd::Float& lanes, std::vector<float>& data) {
+            Simd::Select(mask, Simd::Float::Load(&data[index]), lanes).Store(&data[index]);
+            }, *this, particles);
+    }
+
+    // Particles under given indices, only first lanesCount lanes are written
+    void Scatter(CPUParticleData& particles, const uint32_t* indices, uint32_t lanesCount) const
+    {
+        ForEachComponent([&](const Simd::Float& lanes, std::vector<float>& data) {
+            std::array<float, Simd::Width> values;
+            lanes.Store(values.data());
+            for (uint32_t lane = 0; lane < lanesCount; ++lane)
+            {
+                data[indices[lane]] = values[lane];
+            }
+            }, *this, particles);
+    }
+
+private:
+    template<typename Func, typename Lanes, typename Data>
+    static void ForEachComponent(Func&& func, Lanes& lanes, Data& particles)
+    {
+        if constexpr (HasAttribute(Attributes, ParticleAttribute::Position))
+        {
+            func(lanes.PositionX, particles.PositionX);
+            func(lanes.PositionY, particles.PositionY);
+            func(lanes.PositionZ, particles.PositionZ);
+        }
+        if constexpr (HasAttribute(Attributes, ParticleAttribute::Velocity))
+        {
+            func(lanes.VelocityX, particles.VelocityX);
+            func(lanes.VelocityY, particles.VelocityY);
+            func(lanes.VelocityZ, particles.VelocityZ);
+        }
+        if constexpr (HasAttribute(Attributes, ParticleAttribute::LifeTime))
+        {
+            func(lanes.LifeTime, particles.LifeTime);
+        }
+        if constexpr (HasAttribute(Attributes, ParticleAttribute::Scale))
+        {
+            func(lanes.Scale, particles.Scale);
+        }
+        if constexpr (HasAttribute(Attributes, ParticleAttribute::Color))
+        {
+            func(lanes.ColorR, particles.ColorR);
+            func(lanes.ColorG, particles.ColorG);
+            func(lanes.ColorB, particles.ColorB);
+            func(lanes.ColorA, particles.ColorA);
+        }
+    }
+};
+
+// Generates kernels for the emitter's logic type, so the logic can be inlined and vectorized with the loop.
+// Logic has to be default constructible and provide:
+//   static constexpr ParticleAttribute UpdateAttributes, SpawnAttributes - attributes read and written by the logic
+//   void Update(const CPUKernelContext& context, CPUParticleLanes<UpdateAttributes | LifeTime>& particle) const
+//   void Spawn(const CPUKernelContext& context, CPUParticleLanes<SpawnAttributes>& particle, CPUParticleRandom& random) const
+template<typename Logic>
+struct CPUEmitterKernels
+{
+    static constexpr ParticleAttribute UpdateAttributes = Logic::UpdateAttributes | ParticleAttribute::LifeTime;
+    static constexpr ParticleAttribute SpawnAttributes = Logic::SpawnAttributes;
+
+    static void Update(const CPUKernelContext& context, CPUParticleData& particles, uint32_t start, uint32_t count)
+    {
+        const Logic logic{};
+        const Simd::Float zero(0.0f);
+
+        for (uint32_t i = start; i < start + count; i += Simd::Width)
+        {
+            CPUParticleLanes<UpdateAttributes> particle;
+            particle.Load(particles, i);
+
+            const Simd::Float alive = particle.LifeTime > zero;
+            if (alive.Mask() == 0)
+            {
+                continue;
+            }
+
+            logic.Update(context, particle);
+            particle.Store(particles, i, alive);
+        }
+    }
+
+    static void Spawn(const CPUKernelContext& context, CPUParticleData& particles, const uint32_t* particleIndices, uint32_t count)
+    {
+        const Logic logic{};
+
+        for (uint32_t i = 0; i < count; i += Simd::Width)
+        {
+            const uint32_t lanesCount = std::min(Simd::Width, count - i);
+
+            std::array<uint32_t, Simd::Width> indices{};
+            std::copy(particleIndices + i, particleIndices + i + lanesCount, indices.begin());
+
+            CPUParticleRandom random(context.EmitterSeed, Simd::UInt::Load(indices.data()));
+
+            CPUParticleLanes<SpawnAttributes> particle;
+            logic.Spawn(context, particle, random);
+            particle.Scatter(particles, indices.data(), lanesCount);
+        }
+    }
+};
+
+// Same logic as the default shaders of GPUEmitterTemplate
+struct CPUDefaultEmitterLogic
+{
+    static constexpr ParticleAttribute UpdateAttributes = ParticleAttribute::Position | ParticleAttribute::Velocity | ParticleAttribute::Color;
+    static constexpr ParticleAttribute SpawnAttributes = ParticleAttribute::All;
+
+    template<typename Particle>
+    void Update(const CPUKernelContext& context, Particle& particle) const
+    {
+        const Simd::Float deltaTime(context.DeltaTime);
+
+        particle.PositionX += particle.VelocityX * deltaTime;
+        particle.PositionY += particle.VelocityY * deltaTime;
+        particle.PositionZ += particle.VelocityZ * deltaTime;
+        particle.VelocityY += Simd::Float(-9.8f) * deltaTime;
+        particle.ColorA = Simd::Max(Simd::Float(0.0f), particle.LifeTime / Simd::Float(context.EmitterConstant.LifeTime));
+        particle.LifeTime -= deltaTime;
+    }
+
+    template<typename Particle>
+    void Spawn(const CPUKernelContext& context, Particle& particle, CPUParticleRandom& random) const
+    {
+        const EmitterConstantData& emitterConstant = context.EmitterConstant;
+
+        const Simd::Float phi = random.GetRandomFloat() * Simd::Float(3.14f);
+
+        particle.PositionX = Simd::Float(emitterConstant.Position.x);
+        particle.PositionY = Simd::Float(emitterConstant.Position.y);
+        particle.PositionZ = Simd::Float(emitterConstant.Position.z);
+        particle.ColorR = Simd::Float(emitterConstant.Color.x);
+        particle.ColorG = Simd::Float(emitterConstant.Color.y);
+        particle.ColorB = Simd::Float(emitterConstant.Color.z);
+        particle.ColorA = Simd::Float(emitterConstant.Color.w);
+        particle.LifeTime = Simd::Float(emitterConstant.LifeTime);
+        particle.VelocityX = Simd::Cos(phi) * Simd::Float(15.0f);
+        particle.VelocityY = Simd::Sin(phi) * Simd::Float(15.0f);
+        particle.VelocityZ = Simd::Float(0.0f);
+        particle.Scale = Simd::Float(1.0f);
+    }
+};
@@ -0,0 +1,1057 @@
+#include "Graphics/cpuemitterscript.h"
+
+namespace
+{
+    // Same order as ParticleData
+    std::vector<float> CPUParticleData::* const ParticleComponents[] = {
+        &CPUParticleData::PositionX, &CPUParticleData::PositionY, &CPUParticleData::PositionZ,
+        &CPUParticleData::VelocityX, &CPUParticleData::VelocityY, &CPUParticleData::VelocityZ,
+        &CPUParticleData::LifeTime, &CPUParticleData::Scale,
+        &CPUParticleData::ColorR, &CPUParticleData::ColorG, &CPUParticleData::ColorB, &CPUParticleData::ColorA
+    };
+
+    const uint32_t ParticleComponentsCount = static_cast<uint32_t>(std::size(ParticleComponents));
+
+    struct ScriptField
+    {
+        std::string_view Name;
+        uint32_t FirstComponent;
+        uint32_t Size;
+    };
+
+    const ScriptField ParticleFields[] = {
+        { "position", 0, 3 },
+        { "velocity", 3, 3 },
+        { "lifeTime", 6, 1 },
+        { "scale", 7, 1 },
+        { "color", 8, 4 }
+    };
+
+    // Components of EmitterConstantData visible to the script, see GetEmitterConstant
+    const uint32_t EmitterConstantComponentsCount = 11;
+
+    const ScriptField EmitterConstantFields[] = {
+        { "maxParticles", 0, 1 },
+        { "spawnRate", 1, 1 },
+        { "particleLifeTime", 2, 1 },
+        { "color", 3, 4 },
+        { "position", 7, 3 },
+        { "loopTime", 10, 1 }
+    };
+
+    float GetEmitterConstant(const EmitterConstantData& emitterConstant, uint32_t component)
+    {
+        switch (component)
+        {
+        case 0: return static_cast<float>(emitterConstant.MaxParticles);
+        case 1: return emitterConstant.SpawnRate;
+        case 2: return emitterConstant.LifeTime;
+        case 3: return emitterConstant.Color.x;
+        case 4: return emitterConstant.Color.y;
+        case 5: return emitterConstant.Color.z;
+        case 6: return emitterConstant.Color.w;
+        case 7: return emitterConstant.Position.x;
+        case 8: return emitterConstant.Position.y;
+        case 9: return emitterConstant.Position.z;
+        case 10: return emitterConstant.LoopTime;
+        default: Assert(false); return 0.0f;
+        }
+    }
+
+    const ScriptField* FindField(const ScriptField* begin, const ScriptField* end, std::string_view name)
+    {
+        const ScriptField* field = std::find_if(begin, end, [name](const ScriptField& field) { return field.Name == name; });
+        return field != end ? field : nullptr;
+    }
+
+    enum class TokenType
+    {
+        Identifier,
+        Number,
+        Symbol,
+        End
+    };
+
+    struct Token
+    {
+        TokenType Type = TokenType::End;
+        std::string_view Text;
+        uint32_t Line = 1;
+    };
+}
+
+// Single pass compiler, vector expressions are split into scalar instructions while parsing
+class CPUEmitterScriptCompiler
+{
+    static const int32_t InvalidRegister = -1;
+
+    struct Value
+    {
+        std::array<int32_t, 4> Registers = { InvalidRegister, InvalidRegister, InvalidRegister, InvalidRegister };
+        uint32_t Size = 0;
+    };
+
+    // Assignable scalar, particle components are loaded on first read
+    struct Slot
+    {
+        int32_t* Register = nullptr;
+        int32_t ParticleComponent = -1;
+    };
+
+public:
+    CPUEmitterScriptCompiler(std::string_view source, CPUEmitterScriptStage stage)
+        : mSource(source), mStage(stage)
+    {
+        mParticle.fill(InvalidRegister);
+        mParticleWritten.fill(false);
+        mEmitterConstant.fill(InvalidRegister);
+    }
+
+    std::optional<std::string> Compile(CPUEmitterScript& script)
+    {
+        Next();
+        while (!Failed() && mToken.Type != TokenType::End)
+        {
+            ParseStatement();
+        }
+
+        if (Failed())
+        {
+            return mError;
+        }
+
+        for (uint32_t component = 0; component < ParticleComponentsCount; ++component)
+        {
+            if (mParticleWritten[component])
+            {
+                mInstructions.push_back({ CPUEmitterScript::Opcode::StoreParticle, 0, static_cast<uint16_t>(mParticle[component]), static_cast<uint16_t>(component), 0.0f });
+            }
+        }
+
+        script.mUniformInstructions = std::move(mUniformInstructions);
+        script.mInstructions = std::move(mInstructions);
+        script.mRegistersCount = std::max(1U, static_cast<uint32_t>(mUniformRegisters.size()));
+        return std::nullopt;
+    }
+
+private:
+    bool Failed() const { return !mError.empty(); }
+
+    void Error(std::string_view message)
+    {
+        if (!Failed())
+        {
+            mError = "line " + std::to_string(mToken.Line) + ": " + std::string(message);
+        }
+    }
+
+    void Next()
+    {
+        // Skip whitespaces and comments
+        while (mPosition < mSource.size())
+        {
+            const char c = mSource[mPosition];
+            if (c == '\n')
+            {
+                ++mLine;
+                ++mPosition;
+            }
+            else if (std::isspace(static_cast<unsigned char>(c)))
+            {
+                ++mPosition;
+            }
+            else if (mSource.substr(mPosition, 2) == "//")
+            {
+                while (mPosition < mSource.size() && mSource[mPosition] != '\n')
+                {
+                    ++mPosition;
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        mToken.Line = mLine;
+
+        if (mPosition >= mSource.size())
+        {
+            mToken.Type = TokenType::End;
+            mToken.Text = {};
+            return;
+        }
+
+        const size_t start = mPosition;
+        const char c = mSource[mPosition];
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+        {
+            while (mPosition < mSource.size() && (std::isalnum(static_cast<unsigned char>(mSource[mPosition])) || mSource[mPosition] == '_'))
+            {
+                ++mPosition;
+            }
+            mToken.Type = TokenType::Identifier;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && mPosition + 1 < mSource.size() && std::isdigit(static_cast<unsigned char>(mSource[mPosition + 1]))))
+        {
+            while (mPosition < mSource.size() && (std::isdigit(static_cast<unsigned char>(mSource[mPosition])) || mSource[mPosition] == '.'))
+            {
+                ++mPosition;
+            }
+            if (mPosition < mSource.size() && (mSource[mPosition] == 'e' || mSource[mPosition] == 'E'))
+            {
+                ++mPosition;
+                if (mPosition < mSource.size() && (mSource[mPosition] == '-' || mSource[mPosition] == '+'))
+                {
+                    ++mPosition;
+                }
+                while (mPosition < mSource.size() && std::isdigit(static_cast<unsigned char>(mSource[mPosition])))
+                {
+                    ++mPosition;
+                }
+            }
+            if (mPosition < mSource.size() && (mSource[mPosition] == 'f' || mSource[mPosition] == 'F'))
+            {
+                ++mPosition;
+            }
+            mToken.Type = TokenType::Number;
+        }
+        else
+        {
+            // Compound assignments are the only symbols longer than one character
+            const bool compound = mPosition + 1 < mSource.size() && mSource[mPosition + 1] == '=' && std::string_view("+-*/").find(c) != std::string_view::npos;
+            mPosition += compound ? 2 : 1;
+            mToken.Type = TokenType::Symbol;
+        }
+
+        mToken.Text = mSource.substr(start, mPosition - start);
+    }
+
+    std::string Describe(const Token& token) const
+    {
+        return token.Type == TokenType::End ? std::string("end of snippet") : "'" + std::string(token.Text) + "'";
+    }
+
+    bool Accept(std::string_view symbol)
+    {
+        if (mToken.Type == TokenType::Symbol && mToken.Text == symbol)
+        {
+            Next();
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(std::string_view symbol)
+    {
+        if (!Accept(symbol))
+        {
+            Error("expected '" + std::string(symbol) + "' but found " + Describe(mToken));
+        }
+    }
+
+    std::string_view ExpectIdentifier()
+    {
+        if (mToken.Type != TokenType::Identifier)
+        {
+            Error("expected identifier but found " + Describe(mToken));
+            return {};
+        }
+
+        std::string_view name = mToken.Text;
+        Next();
+        return name;
+    }
+
+    static uint32_t GetTypeSize(std::string_view name)
+    {
+        if (name == "float" || name == "float1") { return 1; }
+        if (name == "float2") { return 2; }
+        if (name == "float3") { return 3; }
+        if (name == "float4") { return 4; }
+        return 0;
+    }
+
+    bool IsUniform(int32_t reg) const { return mUniformRegisters[reg]; }
+
+    int32_t Emit(CPUEmitterScript::Opcode op, int32_t a = 0, int32_t b = 0, float value = 0.0f)
+    {
+        using Opcode = CPUEmitterScript::Opcode;
+
+        bool uniform = false;
+        switch (op)
+        {
+        case Opcode::Constant:
+        case Opcode::EmitterConstant:
+        case Opcode::DeltaTime:
+            uniform = true;
+            break;
+        case Opcode::Random:
+        case Opcode::LoadParticle:
+            uniform = false;
+            break;
+        case Opcode::Add:
+        case Opcode::Sub:
+        case Opcode::Mul:
+        case Opcode::Div:
+        case Opcode::Min:
+        case Opcode::Max:
+        case Opcode::Pow:
+            uniform = IsUniform(a) && IsUniform(b);
+            break;
+        default:
+            uniform = IsUniform(a);
+            break;
+        }
+
+        if (mUniformRegisters.size() >= std::numeric_limits<uint16_t>::max())
+        {
+            Error("snippet is too long");
+            return 0;
+        }
+
+        const int32_t dst = static_cast<int32_t>(mUniformRegisters.size());
+        mUniformRegisters.push_back(uniform);
+
+        const CPUEmitterScript::Instruction instruction = { op, static_cast<uint16_t>(dst), static_cast<uint16_t>(a), static_cast<uint16_t>(b), value };
+        (uniform ? mUniformInstructions : mInstructions).push_back(instruction);
+        return dst;
+    }
+
+    int32_t EmitConstant(float value)
+    {
+        auto it = mConstants.find(value);
+        if (it != mConstants.end())
+        {
+            return it->second;
+        }
+
+        const int32_t reg = Emit(CPUEmitterScript::Opcode::Constant, 0, 0, value);
+        mConstants[value] = reg;
+        return reg;
+    }
+
+    int32_t ReadSlot(const Slot& slot)
+    {
+        if (*slot.Register == InvalidRegister)
+        {
+            // Spawned particle isn't initialized, it's undefined in HLSL, zero here
+            *slot.Register = mStage == CPUEmitterScriptStage::Spawn ? EmitConstant(0.0f) : Emit(CPUEmitterScript::Opcode::LoadParticle, slot.ParticleComponent);
+        }
+        return *slot.Register;
+    }
+
+    Value Scalar(int32_t reg)
+    {
+        Value result;
+        result.Registers[0] = reg;
+        result.Size = 1;
+        return result;
+    }
+
+    // Scalars are broadcasted, vectors of different sizes aren't allowed
+    bool Broadcast(Value& a, Value& b)
+    {
+        if (a.Size == b.Size)
+        {
+            return true;
+        }
+
+        if (a.Size != 1 && b.Size != 1)
+        {
+            Error("vector sizes don't match");
+            return false;
+        }
+
+        Value& scalar = a.Size == 1 ? a : b;
+        const uint32_t size = std::max(a.Size, b.Size);
+        scalar.Registers.fill(scalar.Registers[0]);
+        scalar.Size = size;
+        return true;
+    }
+
+    Value Unary(CPUEmitterScript::Opcode op, const Value& a)
+    {
+        Value result;
+        result.Size = a.Size;
+        for (uint32_t i = 0; i < a.Size; ++i)
+        {
+            result.Registers[i] = Emit(op, a.Registers[i]);
+        }
+        return result;
+    }
+
+    Value Binary(CPUEmitterScript::Opcode op, Value a, Value b)
+    {
+        if (!Broadcast(a, b))
+        {
+            return {};
+        }
+
+        Value result;
+        result.Size = a.Size;
+        for (uint32_t i = 0; i < a.Size; ++i)
+        {
+            result.Registers[i] = Emit(op, a.Registers[i], b.Registers[i]);
+        }
+        return result;
+    }
+
+    Value Dot(Value a, Value b)
+    {
+        if (!Broadcast(a, b))
+        {
+            return {};
+        }
+
+        int32_t sum = Emit(CPUEmitterScript::Opcode::Mul, a.Registers[0], b.Registers[0]);
+        for (uint32_t i = 1; i < a.Size; ++i)
+        {
+            sum = Emit(CPUEmitterScript::Opcode::Add, sum, Emit(CPUEmitterScript::Opcode::Mul, a.Registers[i], b.Registers[i]));
+        }
+        return Scalar(sum);
+    }
+
+    Value Length(const Value& a)
+    {
+        return Unary(CPUEmitterScript::Opcode::Sqrt, Dot(a, a));
+    }
+
+    Value Constructor(uint32_t size, const std::vector<Value>& args)
+    {
+        Value result;
+        for (const Value& arg : args)
+        {
+            for (uint32_t i = 0; i < arg.Size; ++i)
+            {
+                if (result.Size == 4)
+                {
+                    Error("too many components in the constructor");
+                    return {};
+                }
+                result.Registers[result.Size++] = arg.Registers[i];
+            }
+        }
+
+        // Single scalar fills the whole vector
+        if (result.Size == 1 && size > 1)
+        {
+            result.Registers.fill(result.Registers[0]);
+            result.Size = size;
+        }
+
+        if (result.Size != size)
+        {
+            Error("wrong number of components in the constructor");
+            return {};
+        }
+
+        return result;
+    }
+
+    Value Call(std::string_view name, const std::vector<Value>& args)
+    {
+        using Opcode = CPUEmitterScript::Opcode;
+
+        auto checkArgs = [&](size_t count) {
+            if (args.size() != count)
+            {
+                Error("wrong number of arguments for '" + std::string(name) + "'");
+                return false;
+            }
+            return true;
+            };
+
+        if (const uint32_t size = GetTypeSize(name))
+        {
+            return Constructor(size, args);
+        }
+
+        if (name == "GetRandomFloat")
+        {
+            return checkArgs(0) ? Scalar(Emit(Opcode::Random)) : Value{};
+        }
+
+        const std::pair<std::string_view, Opcode> unaryFunctions[] = {
+            { "abs", Opcode::Abs }, { "sqrt", Opcode::Sqrt }, { "floor", Opcode::Floor }, { "sin", Opcode::Sin }, { "cos", Opcode::Cos }
+        };
+
+        for (const auto& [functionName, op] : unaryFunctions)
+        {
+            if (name == functionName)
+            {
+                return checkArgs(1) ? Unary(op, args[0]) : Value{};
+            }
+        }
+
+        if (name == "min" || name == "max" || name == "pow")
+        {
+            const Opcode op = name == "min" ? Opcode::Min : (name == "max" ? Opcode::Max : Opcode::Pow);
+            return checkArgs(2) ? Binary(op, args[0], args[1]) : Value{};
+        }
+
+        if (name == "frac")
+        {
+            return checkArgs(1) ? Binary(Opcode::Sub, args[0], Unary(Opcode::Floor, args[0])) : Value{};
+        }
+
+        if (name == "clamp")
+        {
+            return checkArgs(3) ? Binary(Opcode::Min, Binary(Opcode::Max, args[0], args[1]), args[2]) : Value{};
+        }
+
+        if (name == "saturate")
+        {
+            return checkArgs(1) ? Binary(Opcode::Min, Binary(Opcode::Max, args[0], Scalar(EmitConstant(0.0f))), Scalar(EmitConstant(1.0f))) : Value{};
+        }
+
+        if (name == "lerp")
+        {
+            // x + s * (y - x), same as HLSL
+            return checkArgs(3) ? Binary(Opcode::Add, args[0], Binary(Opcode::Mul, args[2], Binary(Opcode::Sub, args[1], args[0]))) : Value{};
+        }
+
+        if (name == "dot")
+        {
+            return checkArgs(2) ? Dot(args[0], args[1]) : Value{};
+        }
+
+        if (name == "length")
+        {
+            return checkArgs(1) ? Length(args[0]) : Value{};
+        }
+
+        if (name == "distance")
+        {
+            return checkArgs(2) ? Length(Binary(Opcode::Sub, args[0], args[1])) : Value{};
+        }
+
+        if (name == "normalize")
+        {
+            return checkArgs(1) ? Binary(Opcode::Div, args[0], Length(args[0])) : Value{};
+        }
+
+        Error("unsupported function '" + std::string(name) + "'");
+        return {};
+    }
+
+    // Resolves particle.x, emitterConstant.x, Constants.x and locals into scalar slots
+    std::vector<Slot> ParseSlots(std::string_view name)
+    {
+        std::vector<Slot> slots;
+
+        if (name == "particle" || name == "emitterConstant" || name == "Constants")
+        {
+            Expect(".");
+            const std::string_view member = ExpectIdentifier();
+            if (Failed())
+            {
+                return {};
+            }
+
+            const ScriptField* field = nullptr;
+            if (name == "particle")
+            {
+                field = FindField(std::begin(ParticleFields), std::end(ParticleFields), member);
+                if (field)
+                {
+                    for (uint32_t i = 0; i < field->Size; ++i)
+                    {
+                        const uint32_t component = field->FirstComponent + i;
+                        slots.push_back({ &mParticle[component], static_cast<int32_t>(component) });
+                    }
+                }
+            }
+            else if (name == "emitterConstant")
+            {
+                field = FindField(std::begin(EmitterConstantFields), std::end(EmitterConstantFields), member);
+                if (field)
+                {
+                    for (uint32_t i = 0; i < field->Size; ++i)
+                    {
+                        const uint32_t component = field->FirstComponent + i;
+                        if (mEmitterConstant[component] == InvalidRegister)
+                        {
+                            mEmitterConstant[component] = Emit(CPUEmitterScript::Opcode::EmitterConstant, component);
+                        }
+                        slots.push_back({ &mEmitterConstant[component], -1 });
+                    }
+                }
+            }
+            else if (member == "deltaTime" && mStage == CPUEmitterScriptStage::Update)
+            {
+                if (mDeltaTime == InvalidRegister)
+                {
+                    mDeltaTime = Emit(CPUEmitterScript::Opcode::DeltaTime);
+                }
+                slots.push_back({ &mDeltaTime, -1 });
+                return slots;
+            }
+
+            if (!field)
+            {
+                Error("unsupported field '" + std::string(name) + "." + std::string(member) + "'");
+            }
+            return slots;
+        }
+
+        auto it = mLocals.find(name);
+        if (it == mLocals.end())
+        {
+            Error("undeclared identifier '" + std::string(name) + "'");
+            return {};
+        }
+
+        for (uint32_t i = 0; i < it->second.Size; ++i)
+        {
+            slots.push_back({ &it->second.Registers[i], -1 });
+        }
+        return slots;
+    }
+
+    // Swizzles like .xy or .rgba
+    std::vector<uint32_t> ParseSwizzle(uint32_t size)
+    {
+        const std::string_view swizzle = ExpectIdentifier();
+        if (Failed())
+        {
+            return {};
+        }
+
+        std::vector<uint32_t> components;
+        for (const char c : swizzle)
+        {
+            const size_t xyzw = std::string_view("xyzw").find(c);
+            const size_t component = xyzw != std::string_view::npos ? xyzw : std::string_view("rgba").find(c);
+
+            if (component >= size || components.size() == 4)
+            {
+                Error("invalid swizzle '" + std::string(swizzle) + "'");
+                return {};
+            }
+            components.push_back(static_cast<uint32_t>(component));
+        }
+        return components;
+    }
+
+    std::vector<Slot> ParseLValue(std::string_view name)
+    {
+        std::vector<Slot> slots = ParseSlots(name);
+
+        while (!Failed() && Accept("."))
+        {
+            std::vector<Slot> swizzled;
+            for (uint32_t component : ParseSwizzle(static_cast<uint32_t>(slots.size())))
+            {
+                swizzled.push_back(slots[component]);
+            }
+            slots = std::move(swizzled);
+        }
+
+        return slots;
+    }
+
+    Value ParsePrimary()
+    {
+        if (mToken.Type == TokenType::Number)
+        {
+            const float number = std::strtof(std::string(mToken.Text).c_str(), nullptr);
+            Next();
+            return Scalar(EmitConstant(number));
+        }
+
+        if (Accept("("))
+        {
+            Value result = ParseExpression();
+            Expect(")");
+            return result;
+        }
+
+        const std::string_view name = ExpectIdentifier();
+        if (Failed())
+        {
+            return {};
+        }
+
+        if (Accept("("))
+        {
+            std::vector<Value> args;
+            if (!Accept(")"))
+            {
+                do
+                {
+                    args.push_back(ParseExpression());
+                } while (!Failed() && Accept(","));
+                Expect(")");
+            }
+
+            return Failed() ? Value{} : Call(name, args);
+        }
+
+        Value result;
+        for (const Slot& slot : ParseSlots(name))
+        {
+            result.Registers[result.Size++] = ReadSlot(slot);
+        }
+        return result;
+    }
+
+    Value ParsePostfix()
+    {
+        Value result = ParsePrimary();
+
+        while (!Failed() && Accept("."))
+        {
+            Value swizzled;
+            for (uint32_t component : ParseSwizzle(result.Size))
+            {
+                swizzled.Registers[swizzled.Size++] = result.Registers[component];
+            }
+            result = swizzled;
+        }
+
+        return result;
+    }
+
+    Value ParseUnary()
+    {
+        if (Accept("-"))
+        {
+            Value value = ParseUnary();
+            return Failed() ? Value{} : Binary(CPUEmitterScript::Opcode::Sub, Scalar(EmitConstant(0.0f)), value);
+        }
+
+        if (Accept("+"))
+        {
+            return ParseUnary();
+        }
+
+        return ParsePostfix();
+    }
+
+    Value ParseTerm()
+    {
+        Value result = ParseUnary();
+
+        while (!Failed())
+        {
+            if (Accept("*"))
+            {
+                Value rhs = ParseUnary();
+                result = Failed() ? Value{} : Binary(CPUEmitterScript::Opcode::Mul, result, rhs);
+            }
+            else if (Accept("/"))
+            {
+                Value rhs = ParseUnary();
+                result = Failed() ? Value{} : Binary(CPUEmitterScript::Opcode::Div, result, rhs);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    Value ParseExpression()
+    {
+        Value result = ParseTerm();
+
+        while (!Failed())
+        {
+            if (Accept("+"))
+            {
+                Value rhs = ParseTerm();
+                result = Failed() ? Value{} : Binary(CPUEmitterScript::Opcode::Add, result, rhs);
+            }
+            else if (Accept("-"))
+            {
+                Value rhs = ParseTerm();
+                result = Failed() ? Value{} : Binary(CPUEmitterScript::Opcode::Sub, result, rhs);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    void ParseStatement()
+    {
+        const std::string_view name = ExpectIdentifier();
+        if (Failed())
+        {
+            return;
+        }
+
+        // Declaration of a local
+        if (const uint32_t size = GetTypeSize(name))
+        {
+            const std::string_view localName = ExpectIdentifier();
+            Expect("=");
+            Value value = ParseExpression();
+            Expect(";");
+
+            if (Failed())
+            {
+                return;
+            }
+
+            if (GetTypeSize(localName) || localName == "particle" || localName == "emitterConstant" || localName == "Constants")
+            {
+                Error("invalid name '" + std::string(localName) + "'");
+                return;
+            }
+
+            if (value.Size != 1 && value.Size != size)
+            {
+                Error("can't initialize '" + std::string(localName) + "' with a value of different size");
+                return;
+            }
+
+            mLocals[std::string(localName)] = Constructor(size, { value });
+            return;
+        }
+
+        std::vector<Slot> slots = ParseLValue(name);
+        if (Failed())
+        {
+            return;
+        }
+
+        if (name == "emitterConstant" || name == "Constants")
+        {
+            Error("'" + std::string(name) + "' is read only");
+            return;
+        }
+
+        std::optional<CPUEmitterScript::Opcode> op;
+        if (Accept("+=")) { op = CPUEmitterScript::Opcode::Add; }
+        else if (Accept("-=")) { op = CPUEmitterScript::Opcode::Sub; }
+        else if (Accept("*=")) { op = CPUEmitterScript::Opcode::Mul; }
+        else if (Accept("/=")) { op = CPUEmitterScript::Opcode::Div; }
+        else { Expect("="); }
+
+        Value value = ParseExpression();
+        Expect(";");
+
+        if (Failed())
+        {
+            return;
+        }
+
+        if (op)
+        {
+            Value current;
+            for (const Slot& slot : slots)
+            {
+                current.Registers[current.Size++] = ReadSlot(slot);
+            }
+            value = Binary(*op, current, value);
+        }
+
+        if (value.Size == 1)
+        {
+            value.Registers.fill(value.Registers[0]);
+        }
+        else if (value.Size != slots.size())
+        {
+            Error("can't assign a value of different size");
+            return;
+        }
+
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            *slots[i].Register = value.Registers[i];
+            if (slots[i].ParticleComponent >= 0)
+            {
+                mParticleWritten[slots[i].ParticleComponent] = true;
+            }
+        }
+    }
+
+    std::string_view mSource;
+    CPUEmitterScriptStage mStage;
+    size_t mPosition = 0;
+    uint32_t mLine = 1;
+    Token mToken;
+    std::string mError;
+
+    std::vector<CPUEmitterScript::Instruction> mUniformInstructions;
+    std::vector<CPUEmitterScript::Instruction> mInstructions;
+    std::vector<bool> mUniformRegisters;
+    std::map<float, int32_t> mConstants;
+
+    std::map<std::string, Value, std::less<>> mLocals;
+    std::array<int32_t, ParticleComponentsCount> mParticle;
+    std::array<bool, ParticleComponentsCount> mParticleWritten;
+    std::array<int32_t, EmitterConstantComponentsCount> mEmitterConstant;
+    int32_t mDeltaTime = InvalidRegister;
+};
+
+std::optional<std::string> CPUEmitterScript::Compile(std::string_view source, CPUEmitterScriptStage stage)
+{
+    CPUEmitterScriptCompiler compiler(source, stage);
+    return compiler.Compile(*this);
+}
+
+void CPUEmitterScript::ExecuteUniform(const CPUKernelContext& context, std::vector<Simd::Float>& registers) const
+{
+    registers.resize(mRegistersCount);
+
+    for (const Instruction& instruction : mUniformInstructions)
+    {
+        Simd::Float& dst = registers[instruction.Dst];
+        const Simd::Float& a = registers[instruction.A];
+        const Simd::Float& b = registers[instruction.B];
+
+        switch (instruction.Op)
+        {
+        case Opcode::Constant: dst = Simd::Float(instruction.Value); break;
+        case Opcode::EmitterConstant: dst = Simd::Float(GetEmitterConstant(context.EmitterConstant, instruction.A)); break;
+        case Opcode::DeltaTime: dst = Simd::Float(context.DeltaTime); break;
+        case Opcode::Add: dst = a + b; break;
+        case Opcode::Sub: dst = a - b; break;
+        case Opcode::Mul: dst = a * b; break;
+        case Opcode::Div: dst = a / b; break;
+        case Opcode::Min: dst = Simd::Min(a, b); break;
+        case Opcode::Max: dst = Simd::Max(a, b); break;
+        case Opcode::Abs: dst = Simd::Abs(a); break;
+        case Opcode::Sqrt: dst = Simd::Sqrt(a); break;
+        case Opcode::Floor: dst = Simd::Floor(a); break;
+        case Opcode::Sin: dst = Simd::Sin(a); break;
+        case Opcode::Cos: dst = Simd::Cos(a); break;
+        case Opcode::Pow: dst = Simd::Pow(a, b); break;
+        default: Assert(false); break;
+        }
+    }
+}
+
+template<typename Accessor>
+void CPUEmitterScript::Execute(std::vector<Simd::Float>& registers, CPUParticleRandom& random, Accessor& accessor) const
+{
+    for (const Instruction& instruction : mInstructions)
+    {
+        Simd::Float& dst = registers[instruction.Dst];
+        const Simd::Float& a = registers[instruction.A];
+        const Simd::Float& b = registers[instruction.B];
+
+        switch (instruction.Op)
+        {
+        case Opcode::Random: dst = random.GetRandomFloat(); break;
+        case Opcode::LoadParticle: dst = accessor.Load(instruction.A); break;
+        case Opcode::StoreParticle: accessor.Store(instruction.B, a); break;
+        case Opcode::Add: dst = a + b; break;
+        case Opcode::Sub: dst = a - b; break;
+        case Opcode::Mul: dst = a * b; break;
+        case Opcode::Div: dst = a / b; break;
+        case Opcode::Min: dst = Simd::Min(a, b); break;
+        case Opcode::Max: dst = Simd::Max(a, b); break;
+        case Opcode::Abs: dst = Simd::Abs(a); break;
+        case Opcode::Sqrt: dst = Simd::Sqrt(a); break;
+        case Opcode::Floor: dst = Simd::Floor(a); break;
+        case Opcode::Sin: dst = Simd::Sin(a); break;
+        case Opcode::Cos: dst = Simd::Cos(a); break;
+        case Opcode::Pow: dst = Simd::Pow(a, b); break;
+        default: Assert(false); break;
+        }
+    }
+}
+
+void CPUEmitterScript::UpdateKernel(const CPUKernelContext& context, CPUParticleData& particles, uint32_t start, uint32_t count)
+{
+    // Contiguous particles, lanes of dead particles are left untouched
+    struct Accessor
+    {
+        CPUParticleData& Particles;
+        uint32_t Index;
+        Simd::Float Alive;
+
+        Simd::Float Load(uint32_t component) const
+        {
+            return Simd::Float::Load(&(Particles.*ParticleComponents[component])[Index]);
+        }
+
+        void Store(uint32_t component, Simd::Float value) const
+        {
+            float* data = &(Particles.*ParticleComponents[component])[Index];
+            Simd::Select(Alive, Simd::Float::Load(data), value).Store(data);
+        }
+    };
+
+    const CPUEmitterScript* script = context.Script;
+    Assert(script && script->IsValid());
+
+    std::vector<Simd::Float> registers;
+    script->ExecuteUniform(context, registers);
+
+    const Simd::Float zero(0.0f);
+    std::array<uint32_t, Simd::Width> indices;
+
+    for (uint32_t i = start; i < start + count; i += Simd::Width)
+    {
+        const Simd::Float alive = Simd::Float::Load(&particles.LifeTime[i]) > zero;
+        if (alive.Mask() == 0)
+        {
+            continue;
+        }
+
+        std::iota(indices.begin(), indices.end(), i);
+        CPUParticleRandom random(context.EmitterSeed, Simd::UInt::Load(indices.data()));
+
+        Accessor accessor{ particles, i, alive };
+        script->Execute(registers, random, accessor);
+    }
+}
+
+void CPUEmitterScript::SpawnKernel(const CPUKernelContext& context, CPUParticleData& particles, const uint32_t* particleIndices, uint32_t count)
+{
+    // Particles under given indices, only first LanesCount lanes are written
+    struct Accessor
+    {
+        CPUParticleData& Particles;
+        const uint32_t* Indices;
+        uint32_t LanesCount;
+
+        Simd::Float Load(uint32_t) const
+        {
+            Assert(false);
+            return Simd::Float(0.0f);
+        }
+
+        void Store(uint32_t component, Simd::Float value) const
+        {
+            std::vector<float>& data = Particles.*ParticleComponents[component];
+
+            std::array<float, Simd::Width> values;
+            value.Store(values.data());
+            for (uint32_t lane = 0; lane < LanesCount; ++lane)
+            {
+                data[Indices[lane]] = values[lane];
+            }
+        }
+    };
+
+    const CPUEmitterScript* script = context.Script;
+    Assert(script && script->IsValid());
+
+    std::vector<Simd::Float> registers;
+    script->ExecuteUniform(context, registers);
+
+    for (uint32_t i = 0; i < count; i += Simd::Width)
+    {
+        const uint32_t lanesCount = std::min(Simd::Width, count - i);
+
+        std::array<uint32_t, Simd::Width> indices{};
+        std::copy(particleIndices + i, particleIndices + i + lanesCount, indices.begin());
+
+        CPUParticleRandom random(context.EmitterSeed, Simd::UInt::Load(indices.data()));
+
+        Accessor accessor{ particles, indices.data(), lanesCount };
+        script->Execute(registers, random, accessor);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "Graphics/cpuemitterkernels.h"
+
+enum class CPUEmitterScriptStage
+{
+    Spawn,
+    Update
+};
+
+// Runs the HLSL snippets of GPUEmitterTemplate on the CPU.
+// Snippet is compiled into a list of scalar SSA instructions, vectors are split into their components,
+// then the instructions are interpreted for Simd::Width particles at once.
+// Supported subset: float/float2/float3/float4 locals, swizzles, arithmetic, compound assignments,
+// float constructors, lerp, clamp, saturate, min, max, abs, sqrt, pow, sin, cos, floor, frac,
+// dot, length, distance, normalize, GetRandomFloat, particle, emitterConstant and Constants.deltaTime fields.
+class CPUEmitterScript
+{
+    friend class CPUEmitterScriptCompiler;
+
+public:
+    enum class Opcode : uint8_t
+    {
+        Constant,
+        EmitterConstant,
+        DeltaTime,
+        Random,
+        LoadParticle,
+        StoreParticle,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Min,
+        Max,
+        Abs,
+        Sqrt,
+        Floor,
+        Sin,
+        Cos,
+        Pow
+    };
+
+    struct Instruction
+    {
+        Opcode Op;
+        uint16_t Dst;
+        uint16_t A;
+        uint16_t B;
+        float Value;
+    };
+
+    // Returns an error message if the snippet can't be compiled, the previous program is kept in that case
+    std::optional<std::string> Compile(std::string_view source, CPUEmitterScriptStage stage);
+
+    inline bool IsValid() const { return mRegistersCount > 0; }
+    inline uint32_t GetInstructionsCount() const { return static_cast<uint32_t>(mUniformInstructions.size() + mInstructions.size()); }
+
+    // Kernels for CPUEmitterTemplate, the script is taken from the context
+    static void UpdateKernel(const CPUKernelContext& context, CPUParticleData& particles, uint32_t start, uint32_t count);
+    static void SpawnKernel(const CPUKernelContext& context, CPUParticleData& particles, const uint32_t* particleIndices, uint32_t count);
+
+private:
+    void ExecuteUniform(const CPUKernelContext& context, std::vector<Simd::Float>& registers) const;
+
+    template<typename Accessor>
+    void Execute(std::vector<Simd::Float>& registers, CPUParticleRandom& random, Accessor& accessor) const;
+
+    // Instructions which give the same result for all particles are executed once per kernel
+    std::vector<Instruction> mUniformInstructions;
+    std::vector<Instruction> mInstructions;
+    uint32_t mRegistersCount = 0;
+};
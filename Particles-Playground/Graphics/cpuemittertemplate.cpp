@@ -0,0 +1,28 @@
+#include "Graphics/cpuemittertemplate.h"
+
+CPUEmitterTemplate::CPUEmitterTemplate()
+{
+    SetLogic<CPUDefaultEmitterLogic>();
+}
+
+std::optional<std::string> CPUEmitterTemplate::SetUpdateShader(std::string_view updateLogic)
+{
+    if (std::optional<std::string> error = mUpdateScript.Compile(updateLogic, CPUEmitterScriptStage::Update))
+    {
+        return error;
+    }
+
+    mUpdateKernel = &CPUEmitterScript::UpdateKernel;
+    return std::nullopt;
+}
+
+std::optional<std::string> CPUEmitterTemplate::SetSpawnShader(std::string_view spawnLogic)
+{
+    if (std::optional<std::string> error = mSpawnScript.Compile(spawnLogic, CPUEmitterScriptStage::Spawn))
+    {
+        return error;
+    }
+
+    mSpawnKernel = &CPUEmitterScript::SpawnKernel;
+    return std::nullopt;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Graphics/cpuemitterscript.h"
+#include "Utilities/objectpool.h"
+
+class CPUEmitterTemplate : public IObject<CPUEmitterTemplate>
+{
+public:
+    CPUEmitterTemplate();
+    ~CPUEmitterTemplate() = default;
+
+    CPUEmitterTemplate(const CPUEmitterTemplate&) = delete;
+    CPUEmitterTemplate(CPUEmitterTemplate&& rhs) = delete;
+    CPUEmitterTemplate& operator=(const CPUEmitterTemplate&) = delete;
+    CPUEmitterTemplate& operator=(CPUEmitterTemplate&& rhs) = delete;
+
+    inline void SetUpdateKernel(CPUUpdateKernel kernel) { mUpdateKernel = kernel; }
+    inline void SetSpawnKernel(CPUSpawnKernel kernel) { mSpawnKernel = kernel; }
+
+    inline CPUUpdateKernel GetUpdateKernel() const { return mUpdateKernel; }
+    inline CPUSpawnKernel GetSpawnKernel() const { return mSpawnKernel; }
+
+    // Same snippets as GPUEmitterTemplate::SetUpdateShader/SetSpawnShader, executed by CPUEmitterScript
+    std::optional<std::string> SetUpdateShader(std::string_view updateLogic);
+    std::optional<std::string> SetSpawnShader(std::string_view spawnLogic);
+
+    inline const CPUEmitterScript& GetUpdateScript() const { return mUpdateScript; }
+    inline const CPUEmitterScript& GetSpawnScript() const { return mSpawnScript; }
+
+    // Kernels specialized for the logic type, see CPUEmitterKernels
+    template<typename Logic>
+    void SetLogic()
+    {
+        mUpdateKernel = &CPUEmitterKernels<Logic>::Update;
+        mSpawnKernel = &CPUEmitterKernels<Logic>::Spawn;
+    }
+
+private:
+    CPUUpdateKernel mUpdateKernel = nullptr;
+    CPUSpawnKernel mSpawnKernel = nullptr;
+
+    CPUEmitterScript mUpdateScript;
+    CPUEmitterScript mSpawnScript;
+};
+
+using CPUEmitterTemplateHandle = ObjectHandle<CPUEmitterTemplate>;
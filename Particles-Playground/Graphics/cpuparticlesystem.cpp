@@ -0,0 +1,239 @@
+#include "Graphics/cpuparticlesystem.h"
+#include "Utilities/memory.h"
+
+CPUParticleSystem::CPUParticleSystem()
+    : mEmitterTemplatesPool(MaxEmitterTemplates)
+    , mEmittersPool(MaxEmitters)
+    , mRNG(0xDEADC0DE)
+{ }
+
+void CPUParticleSystem::Init()
+{
+    mEmittersPool.Init();
+    mEmitterTemplatesPool.Init();
+}
+
+void CPUParticleSystem::Free()
+{
+    mEmitterTemplatesPool.Free();
+    mEmittersPool.Free();
+}
+
+void CPUParticleSystem::Update(float deltaTime)
+{
+    // Reset dirty emitters, like GPUParticleSystemUpdateDirtyEmittersNode and GPUParticleSystemDirtyEmittersFreeIndicesNode
+    for (CPUEmitter* emitter : GetEmitters())
+    {
+        if (emitter->GetDirty())
+        {
+            emitter->Reset();
+        }
+    }
+
+    mActiveEmitters.clear();
+    for (CPUEmitter* emitter : GetActiveEmitters())
+    {
+        mActiveEmitters.push_back(emitter);
+    }
+
+    mThreadPool.ParallelFor(static_cast<uint32_t>(mActiveEmitters.size()), [&](uint32_t index) {
+        UpdateEmitter(mActiveEmitters[index], deltaTime);
+        });
+
+    UpdateParticles(mActiveEmitters, deltaTime);
+    SpawnParticles(mActiveEmitters);
+}
+
+void CPUParticleSystem::UpdateEmitter(CPUEmitter* emitter, float deltaTime)
+{
+    // Mirrors emitterupdate.hlsl
+    EmitterStatusData& emitterStatus = emitter->mStatusData;
+    const EmitterConstantData& emitterConstant = emitter->mConstantData;
+
+    emitterStatus.UpdateTime += deltaTime;
+
+    const uint32_t aliveParticles = emitter->mInstanceCount;
+
+    if (emitterConstant.LoopTime == -1.0f || emitterStatus.UpdateTime <= emitterConstant.LoopTime)
+    {
+        emitterStatus.SpawnAccTime += deltaTime;
+
+        // Update emitter's seed with PCG RNG
+        emitterStatus.CurrentSeed = RngType::PCG().GetRandom(emitterStatus.CurrentSeed);
+
+        const uint32_t freeCount = emitterConstant.MaxParticles - aliveParticles;
+        const uint32_t maxSpawnCount = static_cast<uint32_t>(std::floor(emitterStatus.SpawnAccTime * emitterConstant.SpawnRate));
+
+        emitterStatus.ParticlesToSpawn = std::min(freeCount, maxSpawnCount);
+        emitterStatus.SpawnAccTime -= static_cast<float>(maxSpawnCount) / emitterConstant.SpawnRate;
+
+        emitterStatus.ParticlesToUpdate = aliveParticles;
+        emitterStatus.RequestedParticles = aliveParticles + maxSpawnCount;
+    }
+    else
+    {
+        emitterStatus.ParticlesToSpawn = 0;
+        emitterStatus.ParticlesToUpdate = aliveParticles;
+        emitterStatus.RequestedParticles = aliveParticles;
+
+        // Emitter won't spawn anymore, once all of its particles are dead it can go to sleep
+        if (aliveParticles == 0)
+        {
+            emitterStatus.State = EmitterState::Sleeping;
+        }
+    }
+
+    emitter->mInstanceCount = 0;
+}
+
+void CPUParticleSystem::UpdateParticles(const std::vector<CPUEmitter*>& emitters, float deltaTime)
+{
+    struct ChunkTask
+    {
+        CPUEmitter* Emitter;
+        uint32_t Chunk;
+    };
+
+    std::vector<ChunkTask> tasks;
+    for (CPUEmitter* emitter : emitters)
+    {
+        if (emitter->GetSleeping())
+        {
+            continue;
+        }
+
+        for (uint32_t chunk = 0; chunk < emitter->mChunkResults.size(); ++chunk)
+        {
+            tasks.push_back({ emitter, chunk });
+        }
+    }
+
+    // Chunks of all emitters are updated in parallel, mirrors updateTemplate.hlsl
+    mThreadPool.ParallelFor(static_cast<uint32_t>(tasks.size()), [&](uint32_t index) {
+        CPUEmitter* emitter = tasks[index].Emitter;
+        CPUEmitter::ChunkResult& result = emitter->mChunkResults[tasks[index].Chunk];
+        CPUParticleData& particles = emitter->mParticles;
+
+        const uint32_t start = tasks[index].Chunk * ParticlesChunkSize;
+        const uint32_t end = std::min(start + ParticlesChunkSize, emitter->GetMaxParticles());
+        const uint32_t count = Align(end - start, Simd::Width);
+
+        // Remember which particles were alive, kernel only tells how long they live now
+        std::array<bool, ParticlesChunkSize> wasAlive;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            wasAlive[i - start] = particles.LifeTime[i] > 0;
+        }
+
+        CPUEmitterTemplate* emitterTemplate = GetEmitterTemplate(emitter->GetTemplateHandle());
+        const CPUKernelContext context{ emitter->mConstantData, emitter->mStatusData.CurrentSeed, deltaTime, &emitterTemplate->GetUpdateScript() };
+        emitterTemplate->GetUpdateKernel()(context, particles, start, count);
+
+        result.Alive.clear();
+        result.Dead.clear();
+
+        for (uint32_t i = start; i < end; ++i)
+        {
+            if (!wasAlive[i - start])
+            {
+                continue;
+            }
+
+            if (particles.LifeTime[i] <= 0)
+            {
+                result.Dead.push_back(i);
+            }
+            else
+            {
+                result.Alive.push_back(i);
+            }
+        }
+        });
+
+    // Free list and indices are rebuilt in chunk order, so results don't depend on the scheduling
+    mThreadPool.ParallelFor(static_cast<uint32_t>(emitters.size()), [&](uint32_t index) {
+        CPUEmitter* emitter = emitters[index];
+        if (emitter->GetSleeping())
+        {
+            return;
+        }
+
+        EmitterStatusData& emitterStatus = emitter->mStatusData;
+
+        for (const CPUEmitter::ChunkResult& result : emitter->mChunkResults)
+        {
+            for (uint32_t particleIndex : result.Dead)
+            {
+                emitterStatus.FreeListPointer -= 1;
+                emitter->mFreeList[emitterStatus.FreeListPointer] = particleIndex;
+            }
+
+            for (uint32_t particleIndex : result.Alive)
+            {
+                emitter->mIndices[emitter->mInstanceCount++] = particleIndex;
+            }
+        }
+        });
+}
+
+void CPUParticleSystem::SpawnParticles(const std::vector<CPUEmitter*>& emitters)
+{
+    struct ChunkTask
+    {
+        CPUEmitter* Emitter;
+        uint32_t Start;
+        uint32_t Count;
+    };
+
+    std::vector<ChunkTask> tasks;
+
+    // Take particles from the free list, mirrors spawnTemplate.hlsl
+    for (CPUEmitter* emitter : emitters)
+    {
+        EmitterStatusData& emitterStatus = emitter->mStatusData;
+        if (emitter->GetSleeping() || emitterStatus.ParticlesToSpawn == 0)
+        {
+            continue;
+        }
+
+        const uint32_t spawnStart = emitter->mInstanceCount;
+
+        for (uint32_t i = 0; i < emitterStatus.ParticlesToSpawn; ++i)
+        {
+            const uint32_t freeListIndex = emitterStatus.FreeListPointer + i;
+            emitter->mIndices[spawnStart + i] = emitter->mFreeList[freeListIndex];
+            emitter->mFreeList[freeListIndex] = std::numeric_limits<uint32_t>::max();
+        }
+
+        emitterStatus.FreeListPointer += emitterStatus.ParticlesToSpawn;
+        emitter->mInstanceCount += emitterStatus.ParticlesToSpawn;
+
+        for (uint32_t start = 0; start < emitterStatus.ParticlesToSpawn; start += ParticlesChunkSize)
+        {
+            const uint32_t count = std::min(ParticlesChunkSize, emitterStatus.ParticlesToSpawn - start);
+            tasks.push_back({ emitter, spawnStart + start, count });
+        }
+    }
+
+    mThreadPool.ParallelFor(static_cast<uint32_t>(tasks.size()), [&](uint32_t index) {
+        CPUEmitter* emitter = tasks[index].Emitter;
+        CPUEmitterTemplate* emitterTemplate = GetEmitterTemplate(emitter->GetTemplateHandle());
+
+        const CPUKernelContext context{ emitter->mConstantData, emitter->mStatusData.CurrentSeed, 0.0f, &emitterTemplate->GetSpawnScript() };
+        emitterTemplate->GetSpawnKernel()(context, emitter->mParticles, &emitter->mIndices[tasks[index].Start], tasks[index].Count);
+        });
+}
+
+CPUEmittersView CPUParticleSystem::GetActiveEmitters() const
+{
+    return mEmittersPool.GetObjectsView<bool(*)(CPUEmitter*)>([](CPUEmitter* emitter) {
+        return emitter->GetEnabled() && !emitter->GetSleeping();
+        });
+}
+
+CPUEmittersView CPUParticleSystem::GetEmitters() const
+{
+    return mEmittersPool.GetObjectsView<bool(*)(CPUEmitter*)>([](CPUEmitter*) {
+        return true;
+        });
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Graphics/cpuemitter.h"
+#include "Graphics/cpuemittertemplate.h"
+#include "Utilities/threadpool.h"
+
+// Emitters are iterated directly in the pool, without copying them to a temporary array
+using CPUEmittersView = ObjectPoolView<CPUEmitter, bool(*)(CPUEmitter*)>;
+
+// Runs the same simulation as GPUParticleSystem without a GPU, can be used as a reference or a headless simulator
+class CPUParticleSystem
+{
+public:
+    static const uint32_t MaxEmitters = 4096;
+    static const uint32_t MaxEmitterTemplates = 256;
+    static const uint32_t ParticlesChunkSize = 1024;
+
+    CPUParticleSystem();
+    ~CPUParticleSystem() = default;
+    CPUParticleSystem(const CPUParticleSystem&) = delete;
+    CPUParticleSystem(CPUParticleSystem&&) = delete;
+
+    CPUParticleSystem& operator=(const CPUParticleSystem&) = delete;
+    CPUParticleSystem& operator=(CPUParticleSystem&&) = delete;
+
+    void Init();
+    void Free();
+
+    // Equivalent of all particle system's render graph nodes for a single frame
+    void Update(float deltaTime);
+
+    [[nodiscard]] CPUEmittersView GetActiveEmitters() const;
+    [[nodiscard]] CPUEmittersView GetEmitters() const;
+
+    inline CPUEmitterHandle CreateEmitter(CPUEmitterTemplateHandle emitterTemplate, uint32_t maxParticles) { return mEmittersPool.AllocateObject(this, emitterTemplate, maxParticles); }
+    inline void FreeEmitter(CPUEmitterHandle& handle) { mEmittersPool.FreeObject(handle); }
+    inline CPUEmitter* GetEmitter(CPUEmitterHandle handle) { return mEmittersPool.GetObject(handle); }
+
+    [[nodiscard]] inline CPUEmitterTemplateHandle CreateEmitterTemplate() { return mEmitterTemplatesPool.AllocateObject(); }
+    inline void FreeEmitterTemplate(CPUEmitterTemplateHandle& handle) { mEmitterTemplatesPool.FreeObject(handle); }
+    inline CPUEmitterTemplate* GetEmitterTemplate(CPUEmitterTemplateHandle handle) { return mEmitterTemplatesPool.GetObject(handle); }
+
+    [[nodiscard]] inline uint32_t GetRandomNumber() { return mRNG.GetRandom(); }
+
+    inline ThreadPool& GetThreadPool() { return mThreadPool; }
+
+private:
+    void UpdateEmitter(CPUEmitter* emitter, float deltaTime);
+    void UpdateParticles(const std::vector<CPUEmitter*>& emitters, float deltaTime);
+    void SpawnParticles(const std::vector<CPUEmitter*>& emitters);
+
+    ObjectPool<CPUEmitterTemplate> mEmitterTemplatesPool;
+    ObjectPool<CPUEmitter> mEmittersPool;
+
+    ThreadPool mThreadPool;
+
+    // Parallel passes index emitters, array is refilled every frame without giving back its memory
+    std::vector<CPUEmitter*> mActiveEmitters;
+
+    // Note: Same seed as GPUParticleSystem, so emitters created in the same order get the same seeds
+    RandomNumberGenerator<RngType::xxHash32> mRNG;
+
+};
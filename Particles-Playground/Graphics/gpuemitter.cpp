@@ -4,14 +4,11 @@
 GPUEmitter::GPUEmitter(GPUParticleSystem* particleSystem, GPUEmitterTemplateHandle emitterTemplate, uint32_t maxParticles)
     : mTemplateHandle(emitterTemplate)
     , mParticleSystem(particleSystem)
+    , mMaxParticles(maxParticles)
 {
     Assert(maxParticles > 0);
 
-    mParticleAllocation = mParticleSystem->AllocateParticles(maxParticles);
-
-    mConstantData.MaxParticles = maxParticles;
-    mConstantData.IndicesOffset = static_cast<uint32_t>(mParticleAllocation.Start);
-
+    // Pages are assigned by the particle system before the emitter is used for the first time
     mTemplateHandle = emitterTemplate;
 
     mInitialSeed = mParticleSystem->GetRandomNumber();
@@ -19,7 +16,38 @@ GPUEmitter::GPUEmitter(GPUParticleSystem* particleSystem, GPUEmitterTemplateHand
 
 GPUEmitter::~GPUEmitter()
 {
-    mParticleSystem->FreeParticles(mParticleAllocation);
+    mParticleSystem->FreeParticlePages(mParticlePages, mParticleDataPages);
+}
+
+void GPUEmitter::SetParticlePages(Range pages, Range dataPages)
+{
+    Assert(pages.IsValid() == dataPages.IsValid());
+
+    // Remember where live particles have been stored so they can be moved to the new pages
+    mPreviousIndicesOffset = mConstantData.IndicesOffset;
+    mPreviousParticlesOffset = mConstantData.ParticlesOffset;
+    mPreviousParticleCapacity = mConstantData.MaxParticles;
+
+    mParticlePages = pages;
+    mParticleDataPages = dataPages;
+
+    if (mParticlePages.IsValid())
+    {
+        const uint32_t pageSize = GPUParticleSystem::ParticlesPageSize;
+        const uint32_t dataCapacity = static_cast<uint32_t>(mParticleDataPages.Size) * pageSize / GetParticleBlocksCount(mConstantData.Encoding);
+
+        mConstantData.IndicesOffset = static_cast<uint32_t>(mParticlePages.Start) * pageSize;
+        mConstantData.ParticlesOffset = static_cast<uint32_t>(mParticleDataPages.Start) * pageSize;
+        mConstantData.MaxParticles = std::min({ static_cast<uint32_t>(mParticlePages.Size) * pageSize, dataCapacity, mMaxParticles });
+    }
+    else
+    {
+        mConstantData.IndicesOffset = 0;
+        mConstantData.ParticlesOffset = 0;
+        mConstantData.MaxParticles = 0;
+    }
+
+    mDirty = true;
 }
 
 GPUEmitter& GPUEmitter::SetSpawnRate(float spawnRate)
@@ -56,3 +84,61 @@ GPUEmitter& GPUEmitter::SetLoopTime(float loopTime)
     SetDitry();
     return *this;
 }
+
+GPUEmitter& GPUEmitter::SetPriority(EmitterPriority priority)
+{
+    mPriority = priority;
+    return *this;
+}
+
+GPUEmitter& GPUEmitter::SetParticleEncoding(ParticleEncoding encoding)
+{
+    mConstantData.Encoding = encoding;
+    SetDitry();
+    return *this;
+}
+
+ParticleBlocks EncodeParticle(const ParticleData& particle, ParticleEncoding encoding, float particleLifeTime)
+{
+    ParticleBlocks blocks{};
+
+    if (encoding == ParticleEncoding::Compact)
+    {
+        uint32_t position[3];
+        memcpy(position, &particle.Position, sizeof(position));
+
+        const uint32_t scale = PackedVector::XMConvertFloatToHalf(particle.Scale);
+        const uint32_t velocityZ = PackedVector::XMConvertFloatToHalf(particle.Velocity.z);
+
+        blocks[0].A = XMUINT4(position[0], position[1], position[2], PackLifeTime(particle.LifeTime, particleLifeTime) | (scale << 16));
+        blocks[0].B = XMUINT2(PackHalf2(XMFLOAT2(particle.Velocity.x, particle.Velocity.y)), velocityZ | (PackUnorm4x4(particle.Color) << 16));
+    }
+    else
+    {
+        memcpy(blocks.data(), &particle, sizeof(ParticleData));
+    }
+
+    return blocks;
+}
+
+ParticleData DecodeParticle(const ParticleBlocks& blocks, ParticleEncoding encoding, float particleLifeTime)
+{
+    ParticleData particle;
+
+    if (encoding == ParticleEncoding::Compact)
+    {
+        memcpy(&particle.Position, &blocks[0].A, sizeof(XMFLOAT3));
+        particle.LifeTime = UnpackLifeTime(blocks[0].A.w, particleLifeTime);
+        particle.Scale = PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(blocks[0].A.w >> 16));
+
+        const XMFLOAT2 velocityXY = UnpackHalf2(blocks[0].B.x);
+        particle.Velocity = XMFLOAT3(velocityXY.x, velocityXY.y, PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(blocks[0].B.y)));
+        particle.Color = UnpackUnorm4x4(blocks[0].B.y >> 16);
+    }
+    else
+    {
+        memcpy(&particle, blocks.data(), sizeof(ParticleData));
+    }
+
+    return particle;
+}
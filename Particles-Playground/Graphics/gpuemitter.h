@@ -12,6 +12,22 @@ struct ParticleData
     XMFLOAT4 Color;
 };
 
+// See particleencoding.hlsli for the layout of blocks in both encodings
+struct ParticleBlock
+{
+    XMUINT4 A;
+    XMUINT2 B;
+};
+
+static_assert(sizeof(ParticleBlock) == ParticleBlockSize);
+static_assert(sizeof(ParticleData) == FullParticleBlocks * ParticleBlockSize);
+
+using ParticleBlocks = std::array<ParticleBlock, FullParticleBlocks>;
+
+// Same packing as the shaders use, life time of compact particles is relative to emitter's particle life time
+ParticleBlocks EncodeParticle(const ParticleData& particle, ParticleEncoding encoding, float particleLifeTime);
+ParticleData DecodeParticle(const ParticleBlocks& blocks, ParticleEncoding encoding, float particleLifeTime);
+
 struct EmitterConstantData
 {
     uint32_t MaxParticles = 0;
@@ -21,6 +37,21 @@ struct EmitterConstantData
     XMFLOAT4 Color = { 1, 1, 1, 1 };
     XMFLOAT3 Position = { 0, 0, 0 };
     float LoopTime = -1;
+    ParticleEncoding Encoding = ParticleEncoding::Full;
+    uint32_t ParticlesOffset = 0; // First block of emitter's particles data
+};
+
+enum class EmitterPriority : uint8_t
+{
+    Low = 0,
+    Normal,
+    High
+};
+
+enum class EmitterState : uint32_t
+{
+    Active = 0,
+    Sleeping
 };
 
 struct EmitterStatusData
@@ -31,6 +62,10 @@ struct EmitterStatusData
     uint32_t ParticlesToUpdate = 0;
     float SpawnAccTime = 0;
     float UpdateTime = 0;
+    EmitterState State = EmitterState::Active;
+    uint32_t RequestedParticles = 0;
+    uint32_t SpawnGroupOffset = 0; // First thread group of the emitter in the uber spawn dispatch
+    uint32_t ClaimedSlots = 0; // Dead slots taken by the fused kernel in the current frame
 };
 
 class GPUParticleSystem;
@@ -53,6 +88,10 @@ public:
     GPUEmitter& SetParticleColor(const XMFLOAT4& color);
     GPUEmitter& SetPosition(const XMFLOAT3& position);
     GPUEmitter& SetLoopTime(float loopTime);
+    GPUEmitter& SetPriority(EmitterPriority priority);
+
+    // Follows emitter's template, particles stored in the previous encoding are dropped
+    GPUEmitter& SetParticleEncoding(ParticleEncoding encoding);
 
     inline const EmitterConstantData& GetConstantData() const { return mConstantData; }
     inline const EmitterStatusData GetDefaultStatusData() const { return EmitterStatusData{ mInitialSeed }; }
@@ -60,17 +99,39 @@ public:
     inline bool GetEnabled() const { return mEnabled; }
     inline void SetEnabled(bool value) { mEnabled = value; }
 
+    // Dirty emitters have to upload their constant data, emitters which also require a reset start from scratch
     inline bool GetDirty() const { return mDirty; }
-    inline void SetDitry() { mDirty = true; }
-    inline void ClearDirty() { mDirty = false; }
+    inline bool GetResetRequired() const { return mResetRequired; }
+    inline void SetDitry() { mDirty = true; mResetRequired = true; mSleeping = false; }
+    inline void ClearDirty(uint64_t frameNumber) { mDirty = false; mResetRequired = false; mStatusResetFrameNumber = frameNumber; }
+
+    // Sleeping emitters finished their work on the GPU and are skipped until they become dirty again
+    inline bool GetSleeping() const { return mSleeping; }
+    inline void SetSleeping(bool value) { mSleeping = value; }
+    inline uint64_t GetStatusResetFrameNumber() const { return mStatusResetFrameNumber; }
 
     inline void SetTemplateHandle(GPUEmitterTemplateHandle handle) { mTemplateHandle = handle; }
     inline GPUEmitterTemplateHandle GetTemplateHandle() const { return mTemplateHandle; }
 
-    inline Range GetParticleAllocation() const { return mParticleAllocation; }
+    inline EmitterPriority GetPriority() const { return mPriority; }
+
+    // Index pages hold emitter's slots in the index buffers, data pages hold its particles' blocks, as many per slot as the encoding needs.
+    // Both are allocated from the particle system's pools, the capacity grows on demand up to max particles.
+    void SetParticlePages(Range pages, Range dataPages);
+    inline Range GetParticlePages() const { return mParticlePages; }
+    inline Range GetParticleDataPages() const { return mParticleDataPages; }
+    inline uint32_t GetIndicesOffset() const { return mConstantData.IndicesOffset; }
+    inline uint32_t GetParticlesOffset() const { return mConstantData.ParticlesOffset; }
+    inline uint32_t GetParticleCapacity() const { return mConstantData.MaxParticles; }
+    inline uint32_t GetPreviousIndicesOffset() const { return mPreviousIndicesOffset; }
+    inline uint32_t GetPreviousParticlesOffset() const { return mPreviousParticlesOffset; }
+    inline uint32_t GetPreviousParticleCapacity() const { return mPreviousParticleCapacity; }
+
+    inline uint32_t GetRequestedParticles() const { return mRequestedParticles; }
+    inline void SetRequestedParticles(uint32_t value) { mRequestedParticles = value; }
 
     inline uint32_t GetEmitterIndexGPU() const { return GetIndex(); }
-    inline uint32_t GetMaxParticles() const { return mConstantData.MaxParticles; }
+    inline uint32_t GetMaxParticles() const { return mMaxParticles; }
 
 private:
     GPUEmitterTemplateHandle mTemplateHandle;
@@ -78,10 +139,22 @@ private:
 
     EmitterConstantData mConstantData;
 
-    Range mParticleAllocation;
+    Range mParticlePages;
+    Range mParticleDataPages;
+    uint32_t mMaxParticles = 0;
+    uint32_t mRequestedParticles = 0;
+    uint32_t mPreviousIndicesOffset = 0;
+    uint32_t mPreviousParticlesOffset = 0;
+    uint32_t mPreviousParticleCapacity = 0;
+
+    EmitterPriority mPriority = EmitterPriority::Normal;
 
     bool mDirty = true;
+    bool mResetRequired = true;
     bool mEnabled = true;
+    bool mSleeping = false;
+
+    uint64_t mStatusResetFrameNumber = 0;
 
     uint32_t mInitialSeed = 0;
 };
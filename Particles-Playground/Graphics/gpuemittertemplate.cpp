@@ -1,4 +1,7 @@
 #include "Graphics/gpuemittertemplate.h"
+#include "Graphics/gpuemitter.h"
+#include "System/graphic.h"
+#include "Utilities/debug.h"
 
 const char* defaultUpdateLogic = "particle.position += particle.velocity * Constants.deltaTime;\n\
 particle.velocity += float3(0, -9.8f, 0) * Constants.deltaTime;\n\
@@ -12,7 +15,18 @@ particle.lifeTime = emitterConstant.particleLifeTime;\n\
 particle.velocity = float3(cos(phi), sin(phi), 0) * 15.0f;\n\
 particle.scale = 1.0f;\n";
 
-GPUEmitterTemplate::GPUEmitterTemplate() 
+// Order in which the update and spawn nodes bind template shaders' parameters, fused kernels are bound like the update
+static const ShaderParameterNames updateParameters = { "Constants", "EmitterConstant", "Particles", "EmitterStatus", "Indices", "FreeList", "DrawIndirectArgs" };
+static const ShaderParameterNames spawnParameters = { "Constants", "EmitterConstant", "Particles", "FreeList", "Indices", "DrawIndirectArgs", "EmitterStatus" };
+
+// Versions are unique among all templates, so a template created in a freed slot never matches the old one
+static uint32_t GetNextLogicVersion()
+{
+    static std::atomic<uint32_t> logicVersion = 0;
+    return ++logicVersion;
+}
+
+GPUEmitterTemplate::GPUEmitterTemplate()
 {
     Assert(SetUpdateShader(defaultUpdateLogic) == std::nullopt);
     Assert(SetSpawnShader(defaultSpawnLogic) == std::nullopt);
@@ -20,42 +34,339 @@ GPUEmitterTemplate::GPUEmitterTemplate()
 
 GPUEmitterTemplate::~GPUEmitterTemplate()
 {
+    FreeSpecializations();
+
     ShaderManager::Get().FreeShader(mUpdateShader);
     ShaderManager::Get().FreeShader(mSpawnShader);
+    ShaderManager::Get().FreeShader(mFusedShader);
 }
 
 std::optional<std::string> GPUEmitterTemplate::SetUpdateShader(std::string_view updateLogic)
 {
-    ShaderToken updateToken = { "TOKEN_UPDATE_LOGIC", updateLogic };
-    ShaderCompilationResult result = ShaderManager::Get().CompileShader(L"updateTemplate", ShaderType::Compute, L"main", { updateToken });
+    std::string previousLogic = std::move(mUpdateLogic);
+    mUpdateLogic = updateLogic;
+
+    ShaderCompilationResult result = CompileUpdateShader("");
 
     if (result.IsValid())
     {
         ShaderManager::Get().FreeShader(mUpdateShader);
         mUpdateShader = result.GetHandle();
+        mLogicVersion = GetNextLogicVersion();
     }
     else
     {
+        mUpdateLogic = std::move(previousLogic);
         return std::optional<std::string>(result.GetError());
     }
 
+    // Existing variants are rebuilt with the new logic, emitters using them are not revisited
+    for (Specialization& specialization : mSpecializations)
+    {
+        if (!specialization.SeparateCompiled)
+        {
+            continue;
+        }
+
+        ShaderManager::Get().FreeShader(specialization.UpdateShader);
+
+        ShaderCompilationResult variant = CompileUpdateShader(GetSpecializationCode(specialization.Key));
+        specialization.UpdateShader = variant.IsValid() ? variant.GetHandle() : ShaderHandle{};
+    }
+
+    FreeFusedShaders();
+
     return std::nullopt;
 }
 
 std::optional<std::string> GPUEmitterTemplate::SetSpawnShader(std::string_view spawnLogic)
 {
-    ShaderToken spawnToken = { "TOKEN_SPAWN_LOGIC", spawnLogic };
-    ShaderCompilationResult result = ShaderManager::Get().CompileShader(L"spawnTemplate", ShaderType::Compute, L"main", { spawnToken });
+    std::string previousLogic = std::move(mSpawnLogic);
+    mSpawnLogic = spawnLogic;
+
+    ShaderCompilationResult result = CompileSpawnShader("");
 
     if (result.IsValid())
     {
         ShaderManager::Get().FreeShader(mSpawnShader);
         mSpawnShader = result.GetHandle();
+        mLogicVersion = GetNextLogicVersion();
     }
     else
     {
+        mSpawnLogic = std::move(previousLogic);
         return std::optional<std::string>(result.GetError());
     }
 
+    for (Specialization& specialization : mSpecializations)
+    {
+        if (!specialization.SeparateCompiled)
+        {
+            continue;
+        }
+
+        ShaderManager::Get().FreeShader(specialization.SpawnShader);
+
+        ShaderCompilationResult variant = CompileSpawnShader(GetSpecializationCode(specialization.Key));
+        specialization.SpawnShader = variant.IsValid() ? variant.GetHandle() : ShaderHandle{};
+    }
+
+    FreeFusedShaders();
+
     return std::nullopt;
 }
+
+void GPUEmitterTemplate::SetSpecializedConstants(EmitterConstantField fields)
+{
+    if (mSpecializedConstants == fields)
+    {
+        return;
+    }
+
+    // Keys of existing variants don't match anymore, they are compiled again by the next Specialize calls
+    FreeSpecializations();
+    mSpecializedConstants = fields;
+}
+
+void GPUEmitterTemplate::Specialize(const EmitterConstantData& constantData, ParticleKernelMode mode)
+{
+    if (mode == ParticleKernelMode::Fused && !mFusedCompiled)
+    {
+        PrepareFusedShader();
+    }
+
+    if (mSpecializedConstants == EmitterConstantField::None || mode == ParticleKernelMode::Uber)
+    {
+        return;
+    }
+
+    const uint64_t frameNumber = Graphic::Get().GetCurrentFrameNumber();
+    const SpecializationKey key = GetSpecializationKey(constantData);
+
+    auto specializationIt = std::find_if(mSpecializations.begin(), mSpecializations.end(), [&key](const Specialization& specialization) {
+        return specialization.Key == key;
+        });
+
+    if (specializationIt == mSpecializations.end())
+    {
+        if (mSpecializations.size() < MaxSpecializations)
+        {
+            specializationIt = mSpecializations.emplace(mSpecializations.end());
+        }
+        else
+        {
+            // Permutations are bounded, only a variant which has been idle for a while is replaced, so emitters
+            // with too many distinct constants use generic shaders instead of compiling new variants every frame
+            specializationIt = std::min_element(mSpecializations.begin(), mSpecializations.end(), [](const Specialization& lhs, const Specialization& rhs) {
+                return lhs.LastUsedFrame < rhs.LastUsedFrame;
+                });
+
+            if (specializationIt->LastUsedFrame + SpecializationIdleFrames > frameNumber)
+            {
+                return;
+            }
+
+            FreeSpecialization(*specializationIt);
+        }
+
+        specializationIt->Key = key;
+    }
+
+    specializationIt->LastUsedFrame = frameNumber;
+    CompileSpecialization(*specializationIt, mode);
+}
+
+ShaderHandle GPUEmitterTemplate::GetUpdateShader(const EmitterConstantData& constantData) const
+{
+    const Specialization* specialization = FindSpecialization(constantData);
+    if (!specialization || specialization->UpdateShader.GetHandle() == ShaderHandle::Invalid)
+    {
+        return mUpdateShader;
+    }
+
+    return specialization->UpdateShader;
+}
+
+ShaderHandle GPUEmitterTemplate::GetSpawnShader(const EmitterConstantData& constantData) const
+{
+    const Specialization* specialization = FindSpecialization(constantData);
+    if (!specialization || specialization->SpawnShader.GetHandle() == ShaderHandle::Invalid)
+    {
+        return mSpawnShader;
+    }
+
+    return specialization->SpawnShader;
+}
+
+ShaderHandle GPUEmitterTemplate::GetFusedShader(const EmitterConstantData& constantData) const
+{
+    const Specialization* specialization = FindSpecialization(constantData);
+    if (!specialization || specialization->FusedShader.GetHandle() == ShaderHandle::Invalid)
+    {
+        return mFusedShader;
+    }
+
+    return specialization->FusedShader;
+}
+
+GPUEmitterTemplate::SpecializationKey GPUEmitterTemplate::GetSpecializationKey(const EmitterConstantData& constantData) const
+{
+    SpecializationKey key{};
+
+    if (HasField(mSpecializedConstants, EmitterConstantField::LifeTime))
+    {
+        std::memcpy(&key[0], &constantData.LifeTime, sizeof(float));
+    }
+    if (HasField(mSpecializedConstants, EmitterConstantField::Color))
+    {
+        std::memcpy(&key[1], &constantData.Color, sizeof(XMFLOAT4));
+    }
+
+    return key;
+}
+
+std::string GPUEmitterTemplate::GetSpecializationCode(const SpecializationKey& key) const
+{
+    // Values are written as raw bits, so the shader sees exactly the same numbers as the constant buffer holds
+    std::string code;
+    std::array<char, 128> line;
+
+    if (HasField(mSpecializedConstants, EmitterConstantField::LifeTime))
+    {
+        std::snprintf(line.data(), line.size(), "emitterConstant.particleLifeTime = asfloat(0x%08Xu);\n", key[0]);
+        code += line.data();
+    }
+    if (HasField(mSpecializedConstants, EmitterConstantField::Color))
+    {
+        std::snprintf(line.data(), line.size(), "emitterConstant.color = asfloat(uint4(0x%08Xu, 0x%08Xu, 0x%08Xu, 0x%08Xu));\n", key[1], key[2], key[3], key[4]);
+        code += line.data();
+    }
+
+    return code;
+}
+
+const GPUEmitterTemplate::Specialization* GPUEmitterTemplate::FindSpecialization(const EmitterConstantData& constantData) const
+{
+    if (mSpecializations.empty())
+    {
+        return nullptr;
+    }
+
+    const SpecializationKey key = GetSpecializationKey(constantData);
+
+    auto specializationIt = std::find_if(mSpecializations.begin(), mSpecializations.end(), [&key](const Specialization& specialization) {
+        return specialization.Key == key;
+        });
+
+    return specializationIt != mSpecializations.end() ? &*specializationIt : nullptr;
+}
+
+ShaderCompilationResult GPUEmitterTemplate::CompileUpdateShader(std::string_view specializationCode) const
+{
+    ShaderToken updateToken = { "TOKEN_UPDATE_LOGIC", mUpdateLogic };
+    ShaderToken specializationToken = { "TOKEN_EMITTER_SPECIALIZATION", specializationCode };
+    return ShaderManager::Get().CompileShader(L"updateTemplate", ShaderType::Compute, L"main", { specializationToken, updateToken }, updateParameters);
+}
+
+ShaderCompilationResult GPUEmitterTemplate::CompileSpawnShader(std::string_view specializationCode) const
+{
+    ShaderToken spawnToken = { "TOKEN_SPAWN_LOGIC", mSpawnLogic };
+    ShaderToken specializationToken = { "TOKEN_EMITTER_SPECIALIZATION", specializationCode };
+    return ShaderManager::Get().CompileShader(L"spawnTemplate", ShaderType::Compute, L"main", { specializationToken, spawnToken }, spawnParameters);
+}
+
+ShaderCompilationResult GPUEmitterTemplate::CompileFusedShader(std::string_view specializationCode) const
+{
+    ShaderToken updateToken = { "TOKEN_UPDATE_LOGIC", mUpdateLogic };
+    ShaderToken spawnToken = { "TOKEN_SPAWN_LOGIC", mSpawnLogic };
+    ShaderToken specializationToken = { "TOKEN_EMITTER_SPECIALIZATION", specializationCode };
+    return ShaderManager::Get().CompileShader(L"fusedTemplate", ShaderType::Compute, L"main", { specializationToken, updateToken, spawnToken }, updateParameters);
+}
+
+void GPUEmitterTemplate::PrepareFusedShader()
+{
+    // Both logics compiled on their own, emitters fall back to separate update and spawn if this still fails.
+    // Failure is remembered too, so it isn't compiled again every frame until the logic changes.
+    ShaderCompilationResult result = CompileFusedShader("");
+    mFusedShader = result.IsValid() ? result.GetHandle() : ShaderHandle{};
+    mFusedCompiled = true;
+
+    if (!result.IsValid())
+    {
+        OutputDebugMessage("Emitter template fused kernel failed to compile, separate update and spawn are used instead\n");
+    }
+}
+
+void GPUEmitterTemplate::FreeFusedShaders()
+{
+    // Fused kernels are compiled again with the new logic by the next Specialize call in fused mode
+    ShaderManager::Get().FreeShader(mFusedShader);
+    mFusedShader = {};
+    mFusedCompiled = false;
+
+    for (Specialization& specialization : mSpecializations)
+    {
+        ShaderManager::Get().FreeShader(specialization.FusedShader);
+        specialization.FusedShader = {};
+        specialization.FusedCompiled = false;
+    }
+}
+
+void GPUEmitterTemplate::CompileSpecialization(Specialization& specialization, ParticleKernelMode mode)
+{
+    const bool compileSeparate = mode == ParticleKernelMode::PerTemplate && !specialization.SeparateCompiled;
+    const bool compileFused = mode == ParticleKernelMode::Fused && !specialization.FusedCompiled;
+
+    if (!compileSeparate && !compileFused)
+    {
+        return;
+    }
+
+    const std::string specializationCode = GetSpecializationCode(specialization.Key);
+    bool compiled = true;
+
+    if (compileSeparate)
+    {
+        ShaderCompilationResult updateResult = CompileUpdateShader(specializationCode);
+        ShaderCompilationResult spawnResult = CompileSpawnShader(specializationCode);
+
+        specialization.UpdateShader = updateResult.IsValid() ? updateResult.GetHandle() : ShaderHandle{};
+        specialization.SpawnShader = spawnResult.IsValid() ? spawnResult.GetHandle() : ShaderHandle{};
+        specialization.SeparateCompiled = true;
+        compiled = updateResult.IsValid() && spawnResult.IsValid();
+    }
+
+    if (compileFused)
+    {
+        ShaderCompilationResult fusedResult = CompileFusedShader(specializationCode);
+
+        specialization.FusedShader = fusedResult.IsValid() ? fusedResult.GetHandle() : ShaderHandle{};
+        specialization.FusedCompiled = true;
+        compiled = fusedResult.IsValid();
+    }
+
+    // Generic shaders compiled fine, so this is not expected, failures are remembered to not compile them every frame
+    if (!compiled)
+    {
+        OutputDebugMessage("Emitter template specialization failed to compile, generic shaders are used instead\n");
+    }
+}
+
+void GPUEmitterTemplate::FreeSpecialization(Specialization& specialization)
+{
+    ShaderManager::Get().FreeShader(specialization.UpdateShader);
+    ShaderManager::Get().FreeShader(specialization.SpawnShader);
+    ShaderManager::Get().FreeShader(specialization.FusedShader);
+
+    specialization = {};
+}
+
+void GPUEmitterTemplate::FreeSpecializations()
+{
+    for (Specialization& specialization : mSpecializations)
+    {
+        FreeSpecialization(specialization);
+    }
+
+    mSpecializations.clear();
+}
@@ -1,10 +1,62 @@
 #pragma once
 #include "System/shadermanager.h"
 #include "Utilities/objectpool.h"
+#include "Shaders/particleencoding.hlsli"
+
+struct EmitterConstantData;
+
+using EmitterConstantFieldType = uint8_t;
+
+// Emitter's constant fields which can be baked into template's shaders.
+// Position isn't one of them, moving emitters change it every frame and each new value would need its own variant.
+enum class EmitterConstantField : EmitterConstantFieldType
+{
+    None     = 0,
+    LifeTime = 1 << 0,
+    Color    = 1 << 1,
+    All      = LifeTime | Color
+};
+
+constexpr EmitterConstantField operator|(EmitterConstantField lhs, EmitterConstantField rhs) {
+    return static_cast<EmitterConstantField>(static_cast<EmitterConstantFieldType>(lhs) | static_cast<EmitterConstantFieldType>(rhs));
+}
+
+constexpr EmitterConstantField operator&(EmitterConstantField lhs, EmitterConstantField rhs) {
+    return static_cast<EmitterConstantField>(static_cast<EmitterConstantFieldType>(lhs) & static_cast<EmitterConstantFieldType>(rhs));
+}
+
+constexpr bool HasField(EmitterConstantField fields, EmitterConstantField field) {
+    return (fields & field) == field;
+}
+
+// Per template mode binds template's own shaders for every emitter, uber mode runs logic of all templates in a single dispatch.
+// Fused mode spawns new particles into dead slots while updating, so every emitter needs only one pass over its particles.
+enum class ParticleKernelMode : uint8_t
+{
+    PerTemplate = 0,
+    Uber,
+    Fused
+};
+
+// Compact particles keep full precision only for the position, see particleencoding.hlsli
+enum class ParticleEncoding : uint32_t
+{
+    Full = ParticleEncodingFull,
+    Compact = ParticleEncodingCompact
+};
+
+constexpr uint32_t GetParticleBlocksCount(ParticleEncoding encoding) {
+    return encoding == ParticleEncoding::Compact ? CompactParticleBlocks : FullParticleBlocks;
+}
 
 class GPUEmitterTemplate : public IObject<GPUEmitterTemplate>
 {
 public:
+    static const uint32_t MaxSpecializations = 8;
+
+    // Variants which weren't used for this many frames can be replaced by new ones
+    static const uint32_t SpecializationIdleFrames = 120;
+
     GPUEmitterTemplate();
     ~GPUEmitterTemplate();
 
@@ -16,12 +68,79 @@ public:
     std::optional<std::string> SetUpdateShader(std::string_view updateLogic);
     std::optional<std::string> SetSpawnShader(std::string_view spawnLogic);
 
+    // Generic shaders read all constants from the emitter constant buffer
     inline ShaderHandle GetUpdateShader() const { return mUpdateShader; }
     inline ShaderHandle GetSpawnShader() const { return mSpawnShader; }
 
+    // Update and spawn logic in one kernel, compiled by the first Specialize call in fused mode, invalid until then
+    inline ShaderHandle GetFusedShader() const { return mFusedShader; }
+
+    // Logic is also compiled into uber kernels, version changes with every successful Set*Shader call
+    inline std::string_view GetUpdateLogic() const { return mUpdateLogic; }
+    inline std::string_view GetSpawnLogic() const { return mSpawnLogic; }
+    inline uint32_t GetLogicVersion() const { return mLogicVersion; }
+
+    // Selected fields are compiled into shader variants as literals, so the compiler can fold them into the logic.
+    // Every distinct set of values gets its own variant, up to MaxSpecializations per template, least recently used idle ones are replaced.
+    void SetSpecializedConstants(EmitterConstantField fields);
+    inline EmitterConstantField GetSpecializedConstants() const { return mSpecializedConstants; }
+
+    // Has to be called every frame for every emitter using the template. Only shaders of the given kernel mode are compiled,
+    // uber kernels ignore specialized constants, so nothing is compiled for them.
+    void Specialize(const EmitterConstantData& constantData, ParticleKernelMode mode);
+
+    // Variants for given constants, generic shaders are returned if there are none
+    ShaderHandle GetUpdateShader(const EmitterConstantData& constantData) const;
+    ShaderHandle GetSpawnShader(const EmitterConstantData& constantData) const;
+    ShaderHandle GetFusedShader(const EmitterConstantData& constantData) const;
+
+    inline uint32_t GetSpecializationsCount() const { return static_cast<uint32_t>(mSpecializations.size()); }
+
+    // Emitters pick the encoding up in the particle system's PreUpdate, switching it resets them
+    inline void SetParticleEncoding(ParticleEncoding encoding) { mParticleEncoding = encoding; }
+    inline ParticleEncoding GetParticleEncoding() const { return mParticleEncoding; }
+
 private:
+    // Raw bits of specialized fields, the rest is left zeroed
+    using SpecializationKey = std::array<uint32_t, 5>;
+
+    // Shaders are compiled once per kernel mode, failed ones stay invalid and generic shaders are used instead
+    struct Specialization
+    {
+        SpecializationKey Key = {};
+        ShaderHandle UpdateShader;
+        ShaderHandle SpawnShader;
+        ShaderHandle FusedShader;
+        bool SeparateCompiled = false;
+        bool FusedCompiled = false;
+        uint64_t LastUsedFrame = 0;
+    };
+
+    SpecializationKey GetSpecializationKey(const EmitterConstantData& constantData) const;
+    std::string GetSpecializationCode(const SpecializationKey& key) const;
+    const Specialization* FindSpecialization(const EmitterConstantData& constantData) const;
+    void CompileSpecialization(Specialization& specialization, ParticleKernelMode mode);
+    void FreeSpecialization(Specialization& specialization);
+
+    ShaderCompilationResult CompileUpdateShader(std::string_view specializationCode) const;
+    ShaderCompilationResult CompileSpawnShader(std::string_view specializationCode) const;
+    ShaderCompilationResult CompileFusedShader(std::string_view specializationCode) const;
+    void PrepareFusedShader();
+    void FreeFusedShaders();
+    void FreeSpecializations();
+
     ShaderHandle mUpdateShader;
     ShaderHandle mSpawnShader;
+    ShaderHandle mFusedShader;
+    bool mFusedCompiled = false;
+
+    std::string mUpdateLogic;
+    std::string mSpawnLogic;
+    uint32_t mLogicVersion = 0;
+
+    EmitterConstantField mSpecializedConstants = EmitterConstantField::None;
+    ParticleEncoding mParticleEncoding = ParticleEncoding::Full;
+    std::vector<Specialization> mSpecializations;
 };
 
 using GPUEmitterTemplateHandle = ObjectHandle<GPUEmitterTemplate>;
@@ -4,78 +4,533 @@
 GPUParticleSystem::GPUParticleSystem() 
     : mEmitterTemplatesPool(MaxEmitterTemplates)
     , mEmittersPool(MaxEmitters)
-    , mParticlesAllocator(0, MaxParticles)
     , mRNG(0xDEADC0DE)
 { }
 
-void GPUParticleSystem::Init()
+void GPUParticleSystem::Init(uint32_t maxParticles)
 {
+    Assert(maxParticles >= ParticlesPageSize);
+    Assert(static_cast<uint64_t>(maxParticles) * sizeof(ParticleData) <= std::numeric_limits<uint32_t>::max()); // Pool is too big for a single buffer
+
     mEmittersPool.Init();
     mEmitterTemplatesPool.Init();
 
-    mParticlesDataBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(ParticleData)), MaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    // Data is sized for max particles in the full encoding, index slots are sized for the same data filled with compact particles
+    const uint32_t dataPagesCount = maxParticles / ParticlesPageSize * FullParticleBlocks;
+    const uint32_t pagesCount = dataPagesCount / CompactParticleBlocks;
+    Assert(dataPagesCount * ParticlesPageSize < CompactParticleEntryFlag); // Index entries can't address all blocks
+
+    mMaxParticles = pagesCount * ParticlesPageSize;
+    mBudgetPages = dataPagesCount;
+    mAllocatedPages = 0;
+    mParticlesAllocator = std::make_unique<FreeListAllocator<FirstFitStrategy>>(0, pagesCount);
+    mParticleDataAllocator = std::make_unique<FreeListAllocator<FirstFitStrategy>>(0, dataPagesCount);
+
+    // Data is accessed in blocks, so emitters can store their particles in different encodings
+    mParticlesDataBuffer = std::make_unique<GPUBuffer>(ParticleBlockSize, dataPagesCount * ParticlesPageSize, BufferUsage::Structured | BufferUsage::UnorderedAccess);
     mParticlesDataBuffer->SetDebugName(L"ParticlesDataBuffer");
 
-    mFreeIndicesBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(int32_t)), MaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    mFreeIndicesBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(int32_t)), mMaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
     mFreeIndicesBuffer->SetDebugName(L"FreeIndicesBuffer");
 
+    mIndicesBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(int32_t)), mMaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    mIndicesBuffer->SetDebugName(L"IndicesBuffer");
+
+    mSortKeysBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(uint32_t)), mMaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    mSortKeysBuffer->SetDebugName(L"SortKeysBuffer");
+
+    mSortValuesBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(uint32_t)), mMaxParticles, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    mSortValuesBuffer->SetDebugName(L"SortValuesBuffer");
+
     mEmitterIndexBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(uint32_t)), MaxEmitters, BufferUsage::Structured | BufferUsage::UnorderedAccess);
     mEmitterIndexBuffer->SetDebugName(L"EmitterIndexBuffer");
 
+    mEmitterWorkBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(EmitterWorkItem)), MaxEmitters, BufferUsage::Structured | BufferUsage::CopyDst);
+    mEmitterWorkBuffer->SetDebugName(L"EmitterWorkBuffer");
+
+    // Emitter never spawns more particles than its capacity, so spawn groups of all emitters fit into the pool's groups plus one partial group per emitter
+    const uint32_t maxSpawnGroups = Align(mMaxParticles, 64) / 64 + MaxEmitters;
+    mSpawnGroupTableBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(uint32_t)), maxSpawnGroups, BufferUsage::Structured | BufferUsage::UnorderedAccess);
+    mSpawnGroupTableBuffer->SetDebugName(L"SpawnGroupTableBuffer");
+
     mEmitterConstantBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(EmitterConstantData)), MaxEmitters, BufferUsage::Structured | BufferUsage::CopyDst);
     mEmitterConstantBuffer->SetDebugName(L"EmitterConstantBuffer");
 
-    mEmitterStatusBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(EmitterStatusData)), MaxEmitters, BufferUsage::Structured | BufferUsage::UnorderedAccess | BufferUsage::CopyDst);
+    mEmitterStatusBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(EmitterStatusData)), MaxEmitters, BufferUsage::Structured | BufferUsage::UnorderedAccess | BufferUsage::CopyDst | BufferUsage::CopySrc);
     mEmitterStatusBuffer->SetDebugName(L"EmitterStatusBuffer");
 
-    mDrawIndirectBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) + sizeof(uint32_t)), MaxEmitters, BufferUsage::Indirect | BufferUsage::UnorderedAccess | BufferUsage::CopyDst);
+    mEmitterStatusReadbackBuffer = std::make_unique<GPUReadbackBuffer>(mEmitterStatusBuffer->GetBufferSize());
+    mEmitterStatusReadbackBuffer->SetDebugName(L"EmitterStatusReadbackBuffer");
+
+    mDrawIndirectBuffer = std::make_unique<GPUBuffer>(static_cast<uint32_t>(sizeof(D3D12_DRAW_INDEXED_ARGUMENTS)), MaxEmitters, BufferUsage::Structured | BufferUsage::UnorderedAccess | BufferUsage::CopyDst);
     mDrawIndirectBuffer->SetDebugName(L"DrawIndirectBuffer");
 }
 
 void GPUParticleSystem::Free()
 {
+    FreeUberShaders();
+
     mEmitterTemplatesPool.Free();
     mEmittersPool.Free();
 
     mDrawIndirectBuffer.reset();
     mEmitterConstantBuffer.reset();
+    mEmitterStatusReadbackBuffer.reset();
     mEmitterStatusBuffer.reset();
+    mSpawnGroupTableBuffer.reset();
+    mEmitterWorkBuffer.reset();
     mEmitterIndexBuffer.reset();
+    mSortValuesBuffer.reset();
+    mSortKeysBuffer.reset();
+    mIndicesBuffer.reset();
     mFreeIndicesBuffer.reset();
     mParticlesDataBuffer.reset();
+
+    for (auto& [pages, dataPages] : mPendingPagesFrees)
+    {
+        FreeParticlePages(pages, dataPages);
+    }
+    mPendingPagesFrees.clear();
+    mParticleDataAllocator.reset();
+    mParticlesAllocator.reset();
+}
+
+void GPUParticleSystem::PreUpdate()
+{
+    // Emitters created and freed since the last frame
+    mEmittersPool.ProcessPendingObjects();
+
+    // Templates freed last frame may have left whole pages empty, emitters' pages are kept as they are allocated lock-free
+    mEmitterTemplatesPool.ReleaseEmptyPages();
+
+    UpdateParticleEncodings();
+    SpecializeEmitterTemplates();
+    UpdateUberShaders();
+    ReadbackEmittersStatus();
+    UpdateParticleBudgets();
+    CompactParticlePages();
 }
 
 void GPUParticleSystem::PostUpdate()
 {
-    std::vector<GPUEmitter*> dirtyEmitters = GetDirtyEmitters();
+    GPUEmittersView dirtyEmitters = GetDirtyEmitters();
 
+    const uint64_t frameNumber = Graphic::Get().GetCurrentFrameNumber();
     for (GPUEmitter* emitter : dirtyEmitters)
     {
-        emitter->ClearDirty();
+        emitter->ClearDirty(frameNumber);
     }
+
+    // Pages that particles have been moved from can be reused once this frame's commands have been recorded
+    for (auto& [pages, dataPages] : mPendingPagesFrees)
+    {
+        FreeParticlePages(pages, dataPages);
+    }
+    mPendingPagesFrees.clear();
 }
 
-std::vector<GPUEmitter*> GPUParticleSystem::GetEnabledEmitters() const
+void GPUParticleSystem::FreeParticlePages(Range& pages, Range& dataPages)
 {
-    return mEmittersPool.GetObjects([](GPUEmitter* emitter) {
-        return emitter->GetEnabled();
+    // Freed pages leave holes in the pools which may be filled by moving other emitters.
+    // Compaction may move only one of emitter's ranges, so either of them can be missing.
+    if (pages.IsValid())
+    {
+        mParticlesAllocator->Free(pages);
+        mCompactionRequired = true;
+    }
+
+    if (dataPages.IsValid())
+    {
+        Assert(mAllocatedPages >= dataPages.Size);
+        mAllocatedPages -= static_cast<uint32_t>(dataPages.Size);
+        mParticleDataAllocator->Free(dataPages);
+        mCompactionRequired = true;
+    }
+}
+
+void GPUParticleSystem::SetParticlesBudget(uint32_t particlesBudget)
+{
+    const uint32_t dataPagesCount = mMaxParticles * CompactParticleBlocks / ParticlesPageSize;
+    const uint32_t budgetBlocks = Align(particlesBudget, ParticlesPageSize) * FullParticleBlocks;
+    mBudgetPages = std::min(budgetBlocks / ParticlesPageSize, dataPagesCount);
+}
+
+void GPUParticleSystem::UpdateParticleEncodings()
+{
+    // Emitters which changed their encoding are reset before any of their particles are read.
+    // Their data pages no longer match the number of blocks per particle, so they get new pages in UpdateParticleBudgets.
+    for (GPUEmitter* emitter : GetEmitters())
+    {
+        const ParticleEncoding encoding = GetEmitterTemplate(emitter->GetTemplateHandle())->GetParticleEncoding();
+        if (emitter->GetConstantData().Encoding != encoding)
+        {
+            Range pages = emitter->GetParticlePages();
+            Range dataPages = emitter->GetParticleDataPages();
+            emitter->SetParticleEncoding(encoding);
+            emitter->SetParticlePages(Range{}, Range{});
+            FreeParticlePages(pages, dataPages);
+        }
+    }
+}
+
+void GPUParticleSystem::SpecializeEmitterTemplates()
+{
+    // Variants are compiled before any commands are recorded, only for the current kernel mode.
+    // Templates without specialized constants return right away, variants not used for a while can be replaced.
+    for (GPUEmitter* emitter : GetEnabledEmitters())
+    {
+        GPUEmitterTemplate* emitterTemplate = GetEmitterTemplate(emitter->GetTemplateHandle());
+        emitterTemplate->Specialize(emitter->GetConstantData(), mKernelMode);
+    }
+}
+
+void GPUParticleSystem::UpdateUberShaders()
+{
+    if (mKernelMode != ParticleKernelMode::Uber)
+    {
+        return;
+    }
+
+    auto emitterTemplates = mEmitterTemplatesPool.GetObjectsView();
+
+    std::vector<std::pair<uint32_t, uint32_t>> uberTemplates;
+    uberTemplates.reserve(mEmitterTemplatesPool.GetObjectsCount());
+    for (const GPUEmitterTemplate* emitterTemplate : emitterTemplates)
+    {
+        uberTemplates.push_back({ emitterTemplate->GetIndex(), emitterTemplate->GetLogicVersion() });
+    }
+    std::sort(uberTemplates.begin(), uberTemplates.end());
+
+    if (uberTemplates == mUberTemplates)
+    {
+        return;
+    }
+
+    // Result is remembered even if compilation fails, so it isn't repeated every frame
+    mUberTemplates = std::move(uberTemplates);
+    FreeUberShaders();
+
+    if (emitterTemplates.empty())
+    {
+        return;
+    }
+
+    // Every template becomes a case of a switch on the template index, logic is scoped so its locals don't collide
+    std::string updateCases;
+    std::string spawnCases;
+    for (const GPUEmitterTemplate* emitterTemplate : emitterTemplates)
+    {
+        const std::string caseLabel = "case " + std::to_string(emitterTemplate->GetIndex()) + ":\n{\n";
+        updateCases += caseLabel;
+        updateCases += emitterTemplate->GetUpdateLogic();
+        updateCases += "\n}\nbreak;\n";
+        spawnCases += caseLabel;
+        spawnCases += emitterTemplate->GetSpawnLogic();
+        spawnCases += "\n}\nbreak;\n";
+    }
+
+    // Parameters in the order the update and spawn nodes bind them
+    ShaderToken updateToken = { "TOKEN_UPDATE_LOGIC_CASES", updateCases };
+    ShaderCompilationResult updateResult = ShaderManager::Get().CompileShader(L"updateUber", ShaderType::Compute, L"main", { updateToken },
+        { "Constants", "EmitterConstant", "WorkItems", "Particles", "EmitterStatus", "Indices", "FreeList", "DrawIndirectArgs" });
+
+    ShaderToken spawnToken = { "TOKEN_SPAWN_LOGIC_CASES", spawnCases };
+    ShaderCompilationResult spawnResult = ShaderManager::Get().CompileShader(L"spawnUber", ShaderType::Compute, L"main", { spawnToken },
+        { "Constants", "EmitterConstant", "WorkItems", "SpawnGroupTable", "Particles", "FreeList", "Indices", "DrawIndirectArgs", "EmitterStatus" });
+
+    if (!updateResult.IsValid() || !spawnResult.IsValid())
+    {
+        OutputDebugMessage("Uber kernels failed to compile, per template shaders are used instead\n");
+        if (updateResult.IsValid()) { ShaderManager::Get().FreeShader(updateResult.GetHandle()); }
+        if (spawnResult.IsValid()) { ShaderManager::Get().FreeShader(spawnResult.GetHandle()); }
+        return;
+    }
+
+    mUberUpdateShader = updateResult.GetHandle();
+    mUberSpawnShader = spawnResult.GetHandle();
+}
+
+void GPUParticleSystem::FreeUberShaders()
+{
+    ShaderManager::Get().FreeShader(mUberUpdateShader);
+    ShaderManager::Get().FreeShader(mUberSpawnShader);
+    mUberUpdateShader = {};
+    mUberSpawnShader = {};
+}
+
+void GPUParticleSystem::ReadbackEmittersStatus()
+{
+    // Status data is read back with a latency of frames in flight
+    const uint8_t* data = mEmitterStatusReadbackBuffer->Map();
+    if (!data)
+    {
+        return;
+    }
+
+    const uint64_t readableFrameNumber = mEmitterStatusReadbackBuffer->GetReadableFrameNumber();
+    const EmitterStatusData* statusData = reinterpret_cast<const EmitterStatusData*>(data);
+
+    GPUEmittersView activeEmitters = GetActiveEmitters();
+
+    for (GPUEmitter* emitter : activeEmitters)
+    {
+        // Ignore data that was copied before emitter's status has been reset
+        if (emitter->GetDirty() || readableFrameNumber < emitter->GetStatusResetFrameNumber())
+        {
+            continue;
+        }
+
+        const EmitterStatusData& status = statusData[emitter->GetEmitterIndexGPU()];
+        if (status.State == EmitterState::Sleeping)
+        {
+            emitter->SetSleeping(true);
+        }
+        emitter->SetRequestedParticles(status.RequestedParticles);
+    }
+
+    mEmitterStatusReadbackBuffer->Unmap();
+}
+
+void GPUParticleSystem::UpdateParticleBudgets()
+{
+    GPUEmittersView emitters = GetEmitters();
+
+    // Sleeping emitters don't have any alive particles, so their pages can be returned to the pool
+    for (GPUEmitter* emitter : emitters)
+    {
+        if (emitter->GetSleeping() && emitter->GetParticlePages().IsValid())
+        {
+            Range pages = emitter->GetParticlePages();
+            Range dataPages = emitter->GetParticleDataPages();
+            emitter->SetParticlePages(Range{}, Range{});
+            FreeParticlePages(pages, dataPages);
+        }
+    }
+
+    std::vector<std::pair<GPUEmitter*, uint32_t>> requests;
+    for (GPUEmitter* emitter : emitters)
+    {
+        if (!emitter->GetEnabled() || emitter->GetSleeping())
+        {
+            continue;
+        }
+
+        const Range pages = emitter->GetParticlePages();
+        const uint32_t currentPages = pages.IsValid() ? static_cast<uint32_t>(pages.Size) : 0;
+        const uint32_t requiredPages = GetRequiredPages(emitter);
+
+        if (requiredPages > currentPages)
+        {
+            requests.push_back({ emitter, requiredPages });
+        }
+    }
+
+    // Higher priority emitters are served first, so lower priority ones are throttled when the pool is under pressure
+    std::stable_sort(requests.begin(), requests.end(), [](const std::pair<GPUEmitter*, uint32_t>& lhs, const std::pair<GPUEmitter*, uint32_t>& rhs) {
+        return lhs.first->GetPriority() > rhs.first->GetPriority();
         });
+
+    for (const auto& [emitter, pagesCount] : requests)
+    {
+        ResizeParticlePages(emitter, pagesCount);
+    }
 }
 
-std::vector<GPUEmitter*> GPUParticleSystem::GetDirtyEmitters() const
+bool GPUParticleSystem::ResizeParticlePages(GPUEmitter* emitter, uint32_t pagesCount)
 {
-    return mEmittersPool.GetObjects([](GPUEmitter* emitter) {
+    const Range currentPages = emitter->GetParticlePages();
+    const uint32_t currentPagesCount = currentPages.IsValid() ? static_cast<uint32_t>(currentPages.Size) : 0;
+
+    // Every index page needs a data page per block of emitter's encoding
+    const uint32_t blocksCount = GetParticleBlocksCount(emitter->GetConstantData().Encoding);
+
+    // Clamp the request to what is left within the budget for emitter's priority
+    const uint32_t limit = GetPagesLimit(emitter->GetPriority());
+    if (mAllocatedPages >= limit)
+    {
+        return false;
+    }
+    pagesCount = std::min(pagesCount, currentPagesCount + (limit - mAllocatedPages) / blocksCount);
+
+    if (pagesCount <= currentPagesCount)
+    {
+        return false;
+    }
+
+    Range newPages = mParticlesAllocator->Allocate(pagesCount);
+    if (!newPages.IsValid())
+    {
+        // There may be enough free pages in total, but not in a single range
+        mCompactionRequired = true;
+        return false;
+    }
+
+    Range newDataPages = mParticleDataAllocator->Allocate(pagesCount * blocksCount);
+    if (!newDataPages.IsValid())
+    {
+        mParticlesAllocator->Free(newPages);
+        mCompactionRequired = true;
+        return false;
+    }
+    mAllocatedPages += pagesCount * blocksCount;
+
+    // Old pages are still read during this frame while particles are moved to the new ones
+    if (currentPages.IsValid())
+    {
+        mPendingPagesFrees.push_back({ currentPages, emitter->GetParticleDataPages() });
+    }
+
+    emitter->SetParticlePages(newPages, newDataPages);
+    return true;
+}
+
+// First fit returns the lowest free range, so it's only worth moving when it is in front of the current one
+static Range AllocateLowerPages(FreeListAllocator<FirstFitStrategy>& allocator, const Range& currentPages)
+{
+    Range newPages = allocator.Allocate(static_cast<uint32_t>(currentPages.Size));
+    if (newPages.IsValid() && newPages.Start > currentPages.Start)
+    {
+        allocator.Free(newPages);
+        return Range{};
+    }
+
+    return newPages;
+}
+
+void GPUParticleSystem::CompactParticlePages()
+{
+    if (!mCompactionRequired)
+    {
+        return;
+    }
+
+    std::vector<GPUEmitter*> emitters;
+    for (GPUEmitter* emitter : GetEmitters())
+    {
+        if (emitter->GetParticlePages().IsValid())
+        {
+            emitters.push_back(emitter);
+        }
+    }
+
+    // Emitters are moved from the start of the pool, so free pages gather at its end
+    std::sort(emitters.begin(), emitters.end(), [](const GPUEmitter* lhs, const GPUEmitter* rhs) {
+        return lhs->GetParticlePages().Start < rhs->GetParticlePages().Start;
+        });
+
+    uint32_t copiedParticles = 0;
+    bool compactionFinished = true;
+
+    for (GPUEmitter* emitter : emitters)
+    {
+        // Emitters that have been resized or reset this frame are already being moved
         if (emitter->GetDirty())
         {
-            Assert(emitter->GetParticleAllocation().IsValid());
-            return true;
+            compactionFinished = false;
+            continue;
         }
-        return false;
+
+        // Index and data pages are moved separately, a range which can't move lower stays where it is
+        Range currentPages = emitter->GetParticlePages();
+        Range currentDataPages = emitter->GetParticleDataPages();
+        Range newPages = AllocateLowerPages(*mParticlesAllocator, currentPages);
+        Range newDataPages = AllocateLowerPages(*mParticleDataAllocator, currentDataPages);
+
+        if (!newPages.IsValid() && !newDataPages.IsValid())
+        {
+            continue;
+        }
+
+        // Always allow at least one move per frame, otherwise emitters bigger than the budget would never be moved
+        const uint32_t capacity = emitter->GetParticleCapacity();
+        if (copiedParticles > 0 && copiedParticles + capacity > mCompactionBudget)
+        {
+            if (newPages.IsValid())
+            {
+                mParticlesAllocator->Free(newPages);
+            }
+            if (newDataPages.IsValid())
+            {
+                mParticleDataAllocator->Free(newDataPages);
+            }
+            compactionFinished = false;
+            break;
+        }
+
+        copiedParticles += capacity;
+
+        // Only ranges which have been moved are freed at the end of the frame
+        Range movedPages;
+        if (newPages.IsValid())
+        {
+            movedPages = currentPages;
+            currentPages = newPages;
+        }
+
+        Range movedDataPages;
+        if (newDataPages.IsValid())
+        {
+            mAllocatedPages += static_cast<uint32_t>(newDataPages.Size);
+            movedDataPages = currentDataPages;
+            currentDataPages = newDataPages;
+        }
+
+        mPendingPagesFrees.push_back({ movedPages, movedDataPages });
+
+        emitter->SetParticlePages(currentPages, currentDataPages);
+        compactionFinished = false;
+    }
+
+    mCompactionRequired = !compactionFinished;
+}
+
+uint32_t GPUParticleSystem::GetRequiredPages(const GPUEmitter* emitter) const
+{
+    // Leave some headroom so emitters with a growing demand don't have to be resized every frame
+    const uint32_t requested = emitter->GetRequestedParticles();
+    const uint32_t requiredParticles = std::min(requested + requested / 4, emitter->GetMaxParticles());
+
+    return std::max(Align(requiredParticles, ParticlesPageSize) / ParticlesPageSize, 1U);
+}
+
+uint32_t GPUParticleSystem::GetPagesLimit(EmitterPriority priority) const
+{
+    // Lower priority emitters can grow only while the pool isn't under pressure
+    switch (priority)
+    {
+    case EmitterPriority::Low:
+        return mBudgetPages / 2;
+    case EmitterPriority::Normal:
+        return mBudgetPages - mBudgetPages / 8;
+    default:
+        return mBudgetPages;
+    }
+}
+
+GPUEmittersView GPUParticleSystem::GetEnabledEmitters() const
+{
+    return mEmittersPool.GetObjectsView<bool(*)(GPUEmitter*)>([](GPUEmitter* emitter) {
+        return emitter->GetEnabled();
         });
 }
 
-std::vector<GPUEmitter*> GPUParticleSystem::GetEmitters() const
+GPUEmittersView GPUParticleSystem::GetActiveEmitters() const
 {
-    return mEmittersPool.GetObjects();
+    return mEmittersPool.GetObjectsView<bool(*)(GPUEmitter*)>([](GPUEmitter* emitter) {
+        return emitter->GetEnabled() && !emitter->GetSleeping();
+        });
 }
 
+GPUEmittersView GPUParticleSystem::GetDirtyEmitters() const
+{
+    return mEmittersPool.GetObjectsView<bool(*)(GPUEmitter*)>([](GPUEmitter* emitter) {
+        return emitter->GetDirty();
+        });
+}
+
+GPUEmittersView GPUParticleSystem::GetEmitters() const
+{
+    return mEmittersPool.GetObjectsView<bool(*)(GPUEmitter*)>([](GPUEmitter*) {
+        return true;
+        });
+}
@@ -1,36 +1,64 @@
 #pragma once
 #include "Utilities/freelistallocator.h"
+#include "Utilities/concurrentobjectpool.h"
 #include "Graphics/gpuemitter.h"
 #include "Graphics/gpuemittertemplate.h"
+#include "Graphics/particlesort.h"
 
 class GPUBuffer;
+class GPUReadbackBuffer;
 class CommandList;
 class Texture2D;
 
+// Single indirect draw command, sets emitter's particles offset as a root constant before drawing
+struct DrawParticlesCommand
+{
+    uint32_t IndicesOffset;
+    D3D12_DRAW_INDEXED_ARGUMENTS DrawArgs;
+};
+
+// Emitter's entry in the flattened work list of uber kernels, spawn groups are reserved on the GPU by the emitter update.
+// Update groups are laid out by the CPU in work items' order, spawn groups are mapped to work items by the spawn group table.
+struct EmitterWorkItem
+{
+    uint32_t EmitterIndex;
+    uint32_t TemplateIndex;
+    uint32_t GroupOffset;
+    uint32_t GroupsCount;
+};
+
+// Emitters are iterated directly in the pool, without copying them to a temporary array
+using GPUEmittersView = ObjectPoolView<GPUEmitter, bool(*)(GPUEmitter*)>;
+
 class GPUParticleSystem
 {
 public:
-    static const uint32_t MaxParticles = 4096;
-    static const uint32_t MaxEmitters = 64;
-    static const uint32_t MaxEmitterTemplates = 16;
+    static const uint32_t DefaultMaxParticles = 1024 * 1024;
+    static const uint32_t ParticlesPageSize = 256;
+    static const uint32_t DefaultCompactionBudget = 64 * 1024;
+    static const uint32_t MaxEmitters = 1U << ParticleSort::EmitterRankBits; // Every active emitter needs its own rank in the sort keys
+    static const uint32_t MaxEmitterTemplates = 256;
 
     GPUParticleSystem();
     ~GPUParticleSystem() = default;
     GPUParticleSystem(const GPUParticleSystem&) = delete;
-    GPUParticleSystem(GPUParticleSystem&&) = default;
+    GPUParticleSystem(GPUParticleSystem&&) = delete;
 
     GPUParticleSystem& operator=(const GPUParticleSystem&) = delete;
-    GPUParticleSystem& operator=(GPUParticleSystem&&) = default;
+    GPUParticleSystem& operator=(GPUParticleSystem&&) = delete;
 
-    void Init();
+    void Init(uint32_t maxParticles = DefaultMaxParticles);
     void Free();
 
+    void PreUpdate();
     void PostUpdate();
 
-    [[nodiscard]] std::vector<GPUEmitter*> GetEnabledEmitters() const;
-    [[nodiscard]] std::vector<GPUEmitter*> GetDirtyEmitters() const;
-    [[nodiscard]] std::vector<GPUEmitter*> GetEmitters() const;
+    [[nodiscard]] GPUEmittersView GetEnabledEmitters() const;
+    [[nodiscard]] GPUEmittersView GetActiveEmitters() const;
+    [[nodiscard]] GPUEmittersView GetDirtyEmitters() const;
+    [[nodiscard]] GPUEmittersView GetEmitters() const;
 
+    // Emitters can be created and freed from any thread, changes are applied to the pool in PreUpdate
     inline GPUEmitterHandle CreateEmitter(GPUEmitterTemplateHandle emitterTemplate, uint32_t maxParticles) { return mEmittersPool.AllocateObject(this, emitterTemplate, maxParticles); }
     inline void FreeEmitter(GPUEmitterHandle& handle) { mEmittersPool.FreeObject(handle); }
     inline GPUEmitter* GetEmitter(GPUEmitterHandle handle) { return mEmittersPool.GetObject(handle); }
@@ -39,38 +67,102 @@ public:
     inline void FreeEmitterTemplate(GPUEmitterTemplateHandle& handle) { mEmitterTemplatesPool.FreeObject(handle); }
     inline GPUEmitterTemplate* GetEmitterTemplate(GPUEmitterTemplateHandle handle) { return mEmitterTemplatesPool.GetObject(handle); }
 
-    inline Range AllocateParticles(uint32_t maxParticles) { return mParticlesAllocator.Allocate(maxParticles); }
-    inline void FreeParticles(Range& allocation) { return mParticlesAllocator.Free(allocation); }
+    void FreeParticlePages(Range& pages, Range& dataPages);
+
+    // Global budget limits how much particle data can be allocated from the pool by all emitters.
+    // It is counted in full particles, compact particles take half as much data, so twice as many of them fit.
+    void SetParticlesBudget(uint32_t particlesBudget);
+    inline uint32_t GetParticlesBudget() const { return mBudgetPages * ParticlesPageSize / FullParticleBlocks; }
+    inline uint32_t GetAllocatedParticles() const { return mAllocatedPages * ParticlesPageSize / FullParticleBlocks; }
+
+    // Index slots of the pool, enough for the pool's data filled only with compact particles
+    inline uint32_t GetMaxParticles() const { return mMaxParticles; }
+
+    // Compaction moves emitters to lower pages to fight pool fragmentation, budget limits how many particles are copied per frame
+    // Sorted particles are drawn back to front, which is required for correct alpha blending
+    inline void SetSortMode(ParticleSortMode mode) { mSortMode = mode; }
+    inline ParticleSortMode GetSortMode() const { return mSortMode; }
+
+    inline void SetCompactionBudget(uint32_t particlesBudget) { mCompactionBudget = particlesBudget; }
+    inline uint32_t GetCompactionBudget() const { return mCompactionBudget; }
+
+    // Uber kernels are rebuilt in PreUpdate whenever templates change, per template shaders are used until they are ready.
+    // Specialized constants of templates are ignored in uber mode.
+    inline void SetKernelMode(ParticleKernelMode mode) { mKernelMode = mode; }
+    inline ParticleKernelMode GetKernelMode() const { return mKernelMode; }
+    inline bool IsUberKernelReady() const { return mKernelMode == ParticleKernelMode::Uber && mUberUpdateShader.GetHandle() != ShaderHandle::Invalid && mUberSpawnShader.GetHandle() != ShaderHandle::Invalid; }
+    inline ShaderHandle GetUberUpdateShader() const { return mUberUpdateShader; }
+    inline ShaderHandle GetUberSpawnShader() const { return mUberSpawnShader; }
 
     [[nodiscard]] inline uint32_t GetRandomNumber() { return mRNG.GetRandom(); }
 
     inline GPUBuffer* GetParticlesDataBuffer() const { return mParticlesDataBuffer.get(); }
     inline GPUBuffer* GetFreeIndicesBuffer() const { return mFreeIndicesBuffer.get(); }
+    inline GPUBuffer* GetIndicesBuffer() const { return mIndicesBuffer.get(); }
+    inline GPUBuffer* GetSortKeysBuffer() const { return mSortKeysBuffer.get(); }
+    inline GPUBuffer* GetSortValuesBuffer() const { return mSortValuesBuffer.get(); }
     inline GPUBuffer* GetEmitterIndexBuffer() const { return mEmitterIndexBuffer.get(); }
+    inline GPUBuffer* GetEmitterWorkBuffer() const { return mEmitterWorkBuffer.get(); }
+    inline GPUBuffer* GetSpawnGroupTableBuffer() const { return mSpawnGroupTableBuffer.get(); }
     inline GPUBuffer* GetEmitterConstantBuffer() const { return mEmitterConstantBuffer.get(); }
     inline GPUBuffer* GetEmitterStatusBuffer() const { return mEmitterStatusBuffer.get(); }
     inline GPUBuffer* GetDrawIndirectBuffer() const { return mDrawIndirectBuffer.get(); }
+    inline GPUReadbackBuffer* GetEmitterStatusReadbackBuffer() const { return mEmitterStatusReadbackBuffer.get(); }
 
 private:
+    void UpdateParticleEncodings();
+    void SpecializeEmitterTemplates();
+    void UpdateUberShaders();
+    void FreeUberShaders();
+    void ReadbackEmittersStatus();
+    void UpdateParticleBudgets();
+    bool ResizeParticlePages(GPUEmitter* emitter, uint32_t pagesCount);
+    void CompactParticlePages();
+    uint32_t GetRequiredPages(const GPUEmitter* emitter) const;
+    uint32_t GetPagesLimit(EmitterPriority priority) const;
+
     void UpdateDirtyEmitters(CommandList& commandList);
     void UpdateEmitters(CommandList& commandList, const std::vector<GPUEmitter*>& enabledEmitters);
     void SpawnParticles(CommandList& commandList, const std::vector<GPUEmitter*>& enabledEmitters);
     void UpdateParticles(CommandList& commandList, const std::vector<GPUEmitter*>& enabledEmitters);
 
     ObjectPool<GPUEmitterTemplate> mEmitterTemplatesPool;
-    ObjectPool<GPUEmitter> mEmittersPool;
+    ConcurrentObjectPool<GPUEmitter> mEmittersPool;
+
+    // Both allocators work in pages, index pages hold ParticlesPageSize slots, data pages hold ParticlesPageSize blocks.
+    // Budget and allocated pages count only data pages, index slots never run out before the data does.
+    std::unique_ptr<FreeListAllocator<FirstFitStrategy>> mParticlesAllocator;
+    std::unique_ptr<FreeListAllocator<FirstFitStrategy>> mParticleDataAllocator;
+    std::vector<std::pair<Range, Range>> mPendingPagesFrees; // Index and data pages
+    uint32_t mMaxParticles = 0;
+    uint32_t mBudgetPages = 0;
+    uint32_t mAllocatedPages = 0;
+    uint32_t mCompactionBudget = DefaultCompactionBudget;
+    bool mCompactionRequired = false;
 
-    FreeListAllocator<FirstFitStrategy> mParticlesAllocator;
     std::unique_ptr<GPUBuffer> mParticlesDataBuffer;
     std::unique_ptr<GPUBuffer> mFreeIndicesBuffer;
+    std::unique_ptr<GPUBuffer> mIndicesBuffer;
+
+    ParticleKernelMode mKernelMode = ParticleKernelMode::PerTemplate;
+    ShaderHandle mUberUpdateShader;
+    ShaderHandle mUberSpawnShader;
+    std::vector<std::pair<uint32_t, uint32_t>> mUberTemplates; // Index and logic version of templates compiled into uber kernels
+
+    ParticleSortMode mSortMode = ParticleSortMode::None;
+    std::unique_ptr<GPUBuffer> mSortKeysBuffer;
+    std::unique_ptr<GPUBuffer> mSortValuesBuffer;
 
     std::unique_ptr<GPUBuffer> mEmitterIndexBuffer;
+    std::unique_ptr<GPUBuffer> mEmitterWorkBuffer;
+    std::unique_ptr<GPUBuffer> mSpawnGroupTableBuffer;
     std::unique_ptr<GPUBuffer> mEmitterConstantBuffer;
     std::unique_ptr<GPUBuffer> mEmitterStatusBuffer;
+    std::unique_ptr<GPUReadbackBuffer> mEmitterStatusReadbackBuffer;
 
     std::unique_ptr<GPUBuffer> mDrawIndirectBuffer;
 
     // Note: Use different RNG than EmitterUpdate shader
-    RandomNumberGenerator<RngType::xxHash32> mRNG;
+    AtomicRandomNumberGenerator<RngType::xxHash32> mRNG;
 
 };
@@ -0,0 +1,106 @@
+#include "Graphics/particlefusedkernel.h"
+
+void ParticleFusedKernel::Execute(FusedKernelEmitterData& data, const ParticleLogic& update, const ParticleLogic& spawn, const std::vector<uint32_t>& slotsOrder)
+{
+    const uint32_t capacity = static_cast<uint32_t>(data.Particles.size());
+    Assert(data.FreeList.size() == capacity && data.Indices.size() == capacity);
+    Assert(data.InstanceCount == 0 && data.Status.ClaimedSlots == 0);
+    Assert(data.Status.ParticlesToSpawn <= capacity - data.Status.FreeListPointer);
+
+    if (data.Status.State == EmitterState::Sleeping)
+    {
+        return;
+    }
+
+    if (slotsOrder.empty())
+    {
+        for (uint32_t particleIndex = 0; particleIndex < capacity; ++particleIndex)
+        {
+            ExecuteSlot(data, particleIndex, update, spawn);
+        }
+    }
+    else
+    {
+        Assert(slotsOrder.size() == capacity);
+
+        for (uint32_t particleIndex : slotsOrder)
+        {
+            ExecuteSlot(data, particleIndex, update, spawn);
+        }
+    }
+}
+
+bool ParticleFusedKernel::Validate(const FusedKernelEmitterData& data)
+{
+    const uint32_t capacity = static_cast<uint32_t>(data.Particles.size());
+
+    if (data.Status.FreeListPointer != data.InstanceCount || data.InstanceCount > capacity)
+    {
+        return false;
+    }
+
+    // Every slot has to be listed exactly once, either as an alive instance or as a free one
+    std::vector<bool> listed(capacity, false);
+
+    auto listSlot = [&](uint32_t particleIndex, bool alive) {
+        if (particleIndex >= capacity || listed[particleIndex] || (data.Particles[particleIndex].LifeTime > 0) != alive)
+        {
+            return false;
+        }
+
+        listed[particleIndex] = true;
+        return true;
+        };
+
+    for (uint32_t i = 0; i < data.InstanceCount; ++i)
+    {
+        if (!listSlot(data.Indices[i], true)) { return false; }
+    }
+
+    for (uint32_t i = data.Status.FreeListPointer; i < capacity; ++i)
+    {
+        if (!listSlot(data.FreeList[i], false)) { return false; }
+    }
+
+    return true;
+}
+
+void ParticleFusedKernel::ExecuteSlot(FusedKernelEmitterData& data, uint32_t particleIndex, const ParticleLogic& update, const ParticleLogic& spawn)
+{
+    const uint32_t capacity = static_cast<uint32_t>(data.Particles.size());
+    ParticleData& particle = data.Particles[particleIndex];
+
+    const bool wasAlive = particle.LifeTime > 0;
+    bool isAlive = wasAlive;
+
+    if (wasAlive)
+    {
+        update(particle);
+        isAlive = particle.LifeTime > 0;
+    }
+
+    if (!isAlive)
+    {
+        const uint32_t claimIndex = data.Status.ClaimedSlots++;
+
+        if (claimIndex < data.Status.ParticlesToSpawn)
+        {
+            spawn(particle);
+            isAlive = true;
+        }
+        else
+        {
+            data.FreeList[capacity - 1 - (claimIndex - data.Status.ParticlesToSpawn)] = particleIndex;
+        }
+    }
+
+    if (wasAlive != isAlive)
+    {
+        data.Status.FreeListPointer += isAlive ? 1 : -1;
+    }
+
+    if (isAlive)
+    {
+        data.Indices[data.InstanceCount++] = particleIndex;
+    }
+}
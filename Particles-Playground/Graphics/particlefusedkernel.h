@@ -0,0 +1,31 @@
+#pragma once
+#include "Graphics/gpuemitter.h"
+
+// Buffers of a single emitter as seen by the fused kernel, sized by emitter's particle capacity
+struct FusedKernelEmitterData
+{
+    std::vector<ParticleData> Particles;
+    std::vector<uint32_t> FreeList;
+    std::vector<uint32_t> Indices;
+    uint32_t InstanceCount = 0;
+    EmitterStatusData Status;
+};
+
+// CPU reference of the fused spawn+update kernel, does exactly the same slot bookkeeping as the shader.
+// GPU threads claim dead slots in any order, so the order in which slots are processed can be given explicitly.
+class ParticleFusedKernel
+{
+public:
+    using ParticleLogic = std::function<void(ParticleData&)>;
+
+    // Expects the emitter update to be done already, so ParticlesToSpawn is set and counters are reset
+    static void Execute(FusedKernelEmitterData& data, const ParticleLogic& update, const ParticleLogic& spawn, const std::vector<uint32_t>& slotsOrder = {});
+
+    // Invariants shared with separate update and spawn: alive particles are listed once in indices,
+    // dead ones once in the free list above the free list pointer, which matches the number of alive particles
+    static bool Validate(const FusedKernelEmitterData& data);
+
+private:
+    static void ExecuteSlot(FusedKernelEmitterData& data, uint32_t particleIndex, const ParticleLogic& update, const ParticleLogic& spawn);
+
+};
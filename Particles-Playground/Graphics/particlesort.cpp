@@ -0,0 +1,84 @@
+#include "Graphics/particlesort.h"
+#include "Utilities/memory.h"
+
+uint32_t ParticleSort::GetDepthKey(float viewDepth)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &viewDepth, sizeof(uint32_t));
+
+    // Flip float's bits so they can be compared as unsigned integers
+    const uint32_t sortable = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    return ~sortable;
+}
+
+uint32_t ParticleSort::GetSortKey(float viewDepth, uint32_t emitterRank, ParticleSortMode mode)
+{
+    const uint32_t depthKey = GetDepthKey(viewDepth);
+
+    if (mode == ParticleSortMode::PerEmitter)
+    {
+        // Emitter's rank takes the highest bits, so the depth loses some of its precision
+        Assert(emitterRank < (1U << EmitterRankBits));
+        return (emitterRank << (32 - EmitterRankBits)) | (depthKey >> EmitterRankBits);
+    }
+
+    return depthKey;
+}
+
+void ParticleSort::Sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values)
+{
+    Assert(keys.size() == values.size());
+
+    const uint32_t count = static_cast<uint32_t>(keys.size());
+    const uint32_t sortSize = NextPow2(count);
+
+    for (uint32_t height = 2; height <= sortSize; height *= 2)
+    {
+        Flip(keys, values, height);
+
+        for (uint32_t disperseHeight = height / 2; disperseHeight > 1; disperseHeight /= 2)
+        {
+            Disperse(keys, values, disperseHeight);
+        }
+    }
+}
+
+void ParticleSort::Flip(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t height)
+{
+    const uint32_t count = static_cast<uint32_t>(keys.size());
+    const uint32_t halfHeight = height / 2;
+
+    for (uint32_t t = 0; t < NextPow2(count) / 2; ++t)
+    {
+        const uint32_t blockStart = (t / halfHeight) * height;
+        const uint32_t offset = t % halfHeight;
+        CompareAndSwap(keys, values, blockStart + offset, blockStart + height - 1 - offset);
+    }
+}
+
+void ParticleSort::Disperse(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t height)
+{
+    const uint32_t count = static_cast<uint32_t>(keys.size());
+    const uint32_t halfHeight = height / 2;
+
+    for (uint32_t t = 0; t < NextPow2(count) / 2; ++t)
+    {
+        const uint32_t i = (t / halfHeight) * height + t % halfHeight;
+        CompareAndSwap(keys, values, i, i + halfHeight);
+    }
+}
+
+void ParticleSort::CompareAndSwap(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t i, uint32_t j)
+{
+    // Padding never moves, so pairs which reach past the end can be skipped
+    if (j >= keys.size())
+    {
+        return;
+    }
+
+    if (keys[i] > keys[j])
+    {
+        std::swap(keys[i], keys[j]);
+        std::swap(values[i], values[j]);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+enum class ParticleSortMode : uint32_t
+{
+    None = 0,
+    PerEmitter, // Emitters are drawn back to front, particles are sorted only within their emitter
+    Global      // All particles are sorted together regardless of their emitter
+};
+
+// CPU reference of the GPU particle sort, produces exactly the same keys and ordering as the shaders
+class ParticleSort
+{
+public:
+    static const uint32_t EmitterRankBits = 10;
+    static const uint32_t LocalSortSize = 1024;
+
+    // Keys are sorted in ascending order, so farther particles have to get smaller keys
+    static uint32_t GetDepthKey(float viewDepth);
+    static uint32_t GetSortKey(float viewDepth, uint32_t emitterRank, ParticleSortMode mode);
+
+    // Bitonic network over the next power of two, elements past the end behave like the biggest possible keys
+    static void Sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values);
+
+private:
+    static void Flip(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t height);
+    static void Disperse(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t height);
+    static void CompareAndSwap(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, uint32_t i, uint32_t j);
+
+};
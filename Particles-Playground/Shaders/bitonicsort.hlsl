@@ -0,0 +1,141 @@
+#include "particlesort.hlsli"
+
+static const uint BitonicSortModeLocalSort = 0;
+static const uint BitonicSortModeFlip = 1;
+static const uint BitonicSortModeDisperse = 2;
+static const uint BitonicSortModeLocalDisperse = 3;
+
+struct BitonicSortConstants
+{
+    uint mode;
+    uint height;
+};
+
+ConstantBuffer<BitonicSortConstants> Constants : register(b0, space0);
+StructuredBuffer<uint> SortCount : register(t0, space0);
+RWStructuredBuffer<uint> SortKeys : register(u0, space0);
+RWStructuredBuffer<uint> SortValues : register(u1, space0);
+
+groupshared uint LocalKeys[LocalSortSize];
+groupshared uint LocalValues[LocalSortSize];
+
+// Elements past the end behave like the biggest keys, so they never move and pairs reaching them can be skipped
+void CompareAndSwapGlobal(uint i, uint j, uint count)
+{
+    if (j >= count)
+    {
+        return;
+    }
+
+    uint keyI = SortKeys[i];
+    uint keyJ = SortKeys[j];
+
+    if (keyI > keyJ)
+    {
+        uint valueI = SortValues[i];
+        SortKeys[i] = keyJ;
+        SortKeys[j] = keyI;
+        SortValues[i] = SortValues[j];
+        SortValues[j] = valueI;
+    }
+}
+
+void CompareAndSwapLocal(uint i, uint j)
+{
+    if (LocalKeys[i] > LocalKeys[j])
+    {
+        uint key = LocalKeys[i];
+        uint value = LocalValues[i];
+        LocalKeys[i] = LocalKeys[j];
+        LocalValues[i] = LocalValues[j];
+        LocalKeys[j] = key;
+        LocalValues[j] = value;
+    }
+}
+
+void FlipLocal(uint t, uint height)
+{
+    uint halfHeight = height / 2;
+    uint blockStart = (t / halfHeight) * height;
+    uint offset = t % halfHeight;
+    CompareAndSwapLocal(blockStart + offset, blockStart + height - 1 - offset);
+}
+
+void DisperseLocal(uint t, uint height)
+{
+    uint halfHeight = height / 2;
+    uint i = (t / halfHeight) * height + t % halfHeight;
+    CompareAndSwapLocal(i, i + halfHeight);
+}
+
+// Each thread handles a single pair of elements
+[numthreads(LocalSortSize / 2, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint3 groupThreadID : SV_GroupThreadID, uint3 groupID : SV_GroupID)
+{
+    uint count = SortCount[0];
+    uint t = id.x;
+    uint mode = Constants.mode;
+    uint height = Constants.height;
+
+    if (mode == BitonicSortModeFlip)
+    {
+        uint halfHeight = height / 2;
+        uint blockStart = (t / halfHeight) * height;
+        uint offset = t % halfHeight;
+        CompareAndSwapGlobal(blockStart + offset, blockStart + height - 1 - offset, count);
+        return;
+    }
+
+    if (mode == BitonicSortModeDisperse)
+    {
+        uint halfHeight = height / 2;
+        uint i = (t / halfHeight) * height + t % halfHeight;
+        CompareAndSwapGlobal(i, i + halfHeight, count);
+        return;
+    }
+
+    // Steps which stay within LocalSortSize elements are done in shared memory
+    uint localT = groupThreadID.x;
+    uint groupStart = groupID.x * LocalSortSize;
+
+    for (uint load = localT; load < LocalSortSize; load += LocalSortSize / 2)
+    {
+        uint index = groupStart + load;
+        LocalKeys[load] = index < count ? SortKeys[index] : 0xFFFFFFFF;
+        LocalValues[load] = index < count ? SortValues[index] : 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (mode == BitonicSortModeLocalSort)
+    {
+        for (uint h = 2; h <= LocalSortSize; h *= 2)
+        {
+            FlipLocal(localT, h);
+            GroupMemoryBarrierWithGroupSync();
+
+            for (uint dh = h / 2; dh > 1; dh /= 2)
+            {
+                DisperseLocal(localT, dh);
+                GroupMemoryBarrierWithGroupSync();
+            }
+        }
+    }
+    else
+    {
+        for (uint dh = height; dh > 1; dh /= 2)
+        {
+            DisperseLocal(localT, dh);
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+
+    for (uint store = localT; store < LocalSortSize; store += LocalSortSize / 2)
+    {
+        uint index = groupStart + store;
+        if (index < count)
+        {
+            SortKeys[index] = LocalKeys[store];
+            SortValues[index] = LocalValues[store];
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#include "default.hlsli"
+#include "particlesort.hlsli"
+
+struct BuildSortKeysConstants
+{
+    uint emitterIndex;
+    uint emitterRank;
+    uint sortMode;
+};
+
+struct SceneCB
+{
+    float4x4 proj;
+    float4x4 view;
+};
+
+ConstantBuffer<BuildSortKeysConstants> Constants : register(b0, space0);
+StructuredBuffer<SceneCB> Camera : register(t0, space0);
+StructuredBuffer<EmitterConstantData> EmitterConstant : register(t1, space0);
+StructuredBuffer<ParticleBlock> Particles : register(t2, space0);
+StructuredBuffer<uint> Indices : register(t3, space0);
+StructuredBuffer<DrawIndirectArgs> DrawIndirectArgs : register(t4, space0);
+RWStructuredBuffer<uint> SortKeys : register(u0, space0);
+RWStructuredBuffer<uint> SortValues : register(u1, space0);
+RWStructuredBuffer<uint> SortCount : register(u2, space0);
+
+groupshared uint GroupCount;
+groupshared uint GroupStartIndex;
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID, uint3 groupThreadID : SV_GroupThreadID)
+{
+    uint emitterIndex = Constants.emitterIndex;
+    bool isAlive = id.x < DrawIndirectArgs[emitterIndex].instanceCount;
+
+    if (groupThreadID.x == 0)
+    {
+        GroupCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Reserve slots in shared memory first, so there is only one global atomic per group
+    uint groupIndex = 0;
+    if (isAlive)
+    {
+        InterlockedAdd(GroupCount, 1, groupIndex);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupThreadID.x == 0 && GroupCount > 0)
+    {
+        InterlockedAdd(SortCount[0], GroupCount, GroupStartIndex);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (!isAlive)
+    {
+        return;
+    }
+
+    uint offset = EmitterConstant[emitterIndex].indicesOffset;
+    uint particleEntry = Indices[offset + id.x];
+
+    float3 position = LoadParticleEntry(Particles, particleEntry).position;
+    float viewDepth = mul(Camera[0].view, float4(position, 1)).z;
+
+    uint sortIndex = GroupStartIndex + groupIndex;
+    SortKeys[sortIndex] = GetParticleSortKey(viewDepth, Constants.emitterRank, Constants.sortMode);
+    SortValues[sortIndex] = particleEntry;
+}
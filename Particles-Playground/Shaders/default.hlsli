@@ -1,3 +1,5 @@
+#include "particleencoding.hlsli"
+
 
 struct VSInput
 {
@@ -22,6 +24,12 @@ struct DrawIndirectArgs
     uint startInstanceLocation;
 };
 
+struct DrawParticlesCommand
+{
+    uint indicesOffset;
+    DrawIndirectArgs drawArgs;
+};
+
 struct DispatchIndirectArgs
 {
     uint threadGroupCountX;
@@ -38,6 +46,13 @@ struct ParticlesData
     float4 color;
 };
 
+// See particleencoding.hlsli for the layout of blocks in both encodings
+struct ParticleBlock
+{
+    uint4 a;
+    uint2 b;
+};
+
 struct EmitterConstantData
 {
     uint maxParticles;
@@ -47,8 +62,13 @@ struct EmitterConstantData
     float4 color;
     float3 position;
     float loopTime;
+    uint particleEncoding;
+    uint particlesOffset;
 };
 
+static const uint EmitterStateActive = 0;
+static const uint EmitterStateSleeping = 1;
+
 struct EmitterStatusData
 {
     uint currentSeed;
@@ -57,8 +77,93 @@ struct EmitterStatusData
     uint particlesToUpdate;
     float spawnAccTime;
     float updateTime;
+    uint state;
+    uint requestedParticles;
+    uint spawnGroupOffset;
+    uint claimedSlots;
+};
+
+// Emitter's entry in the flattened work list of uber kernels
+struct EmitterWorkItem
+{
+    uint emitterIndex;
+    uint templateIndex;
+    uint groupOffset;
+    uint groupsCount;
 };
 
+// First block of particle's data, particles offset is emitter's first block in the pool
+uint GetParticleBlockIndex(uint particlesOffset, uint particleIndex, bool compact)
+{
+    return particlesOffset + particleIndex * (compact ? CompactParticleBlocks : FullParticleBlocks);
+}
+
+// Index entries point directly to particle's data, so draws and sorting can read particles without emitter's constants
+uint GetParticleEntry(EmitterConstantData emitterConstant, uint particleIndex)
+{
+    bool compact = emitterConstant.particleEncoding == ParticleEncodingCompact;
+    uint blockIndex = GetParticleBlockIndex(emitterConstant.particlesOffset, particleIndex, compact);
+    return compact ? (blockIndex | CompactParticleEntryFlag) : blockIndex;
+}
+
+ParticlesData DecodeParticle(ParticleBlock blocks[FullParticleBlocks], bool compact, float particleLifeTime)
+{
+    ParticlesData particle;
+
+    if (compact)
+    {
+        particle.position = asfloat(blocks[0].a.xyz);
+        particle.lifeTime = UnpackLifeTime(blocks[0].a.w, particleLifeTime);
+        particle.scale = f16tof32(blocks[0].a.w >> 16);
+        particle.velocity = float3(UnpackHalf2(blocks[0].b.x), f16tof32(blocks[0].b.y));
+        particle.color = UnpackUnorm4x4(blocks[0].b.y >> 16);
+    }
+    else
+    {
+        particle.position = asfloat(blocks[0].a.xyz);
+        particle.lifeTime = asfloat(blocks[0].a.w);
+        particle.velocity = asfloat(uint3(blocks[0].b, blocks[1].a.x));
+        particle.scale = asfloat(blocks[1].a.y);
+        particle.color = asfloat(uint4(blocks[1].a.zw, blocks[1].b));
+    }
+
+    return particle;
+}
+
+void EncodeParticle(ParticlesData particle, bool compact, float particleLifeTime, out ParticleBlock blocks[FullParticleBlocks])
+{
+    if (compact)
+    {
+        blocks[0].a = uint4(asuint(particle.position), PackLifeTime(particle.lifeTime, particleLifeTime) | (f32tof16(particle.scale) << 16));
+        blocks[0].b = uint2(PackHalf2(particle.velocity.xy), f32tof16(particle.velocity.z) | (PackUnorm4x4(particle.color) << 16));
+        blocks[1] = (ParticleBlock)0;
+    }
+    else
+    {
+        blocks[0].a = uint4(asuint(particle.position), asuint(particle.lifeTime));
+        blocks[0].b = asuint(particle.velocity.xy);
+        blocks[1].a = uint4(asuint(particle.velocity.z), asuint(particle.scale), asuint(particle.color.xy));
+        blocks[1].b = asuint(particle.color.zw);
+    }
+}
+
+// Read only access for passes which only have index entries, life time isn't known there
+ParticlesData LoadParticleEntry(StructuredBuffer<ParticleBlock> particles, uint entry)
+{
+    bool compact = (entry & CompactParticleEntryFlag) != 0;
+    uint blockIndex = entry & ~CompactParticleEntryFlag;
+
+    ParticleBlock blocks[FullParticleBlocks];
+    blocks[0] = particles[blockIndex];
+    blocks[1] = (ParticleBlock)0;
+    if (!compact)
+    {
+        blocks[1] = particles[blockIndex + 1];
+    }
+
+    return DecodeParticle(blocks, compact, 0);
+}
+
 uint GetRandomPCG(uint seed)
 {
     uint state = seed * 747796405U + 2891336453U;
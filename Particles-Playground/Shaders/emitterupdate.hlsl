@@ -4,6 +4,8 @@ struct EmitterUpdateConstants
 {
     uint emittersCount;
     float deltaTime;
+    uint spawnArgsIndex;
+    uint buildSpawnGroupTable;
 };
 
 ConstantBuffer<EmitterUpdateConstants> Constants : register(b0, space0);
@@ -12,24 +14,18 @@ StructuredBuffer<uint> EmitterIndexBuffer : register(t1, space0);
 RWStructuredBuffer<EmitterStatusData> EmitterStatus : register(u1, space0);
 RWStructuredBuffer<DrawIndirectArgs> DrawIndirectBuffer : register(u2, space0);
 RWStructuredBuffer<DispatchIndirectArgs> SpawnIndirectBuffer : register(u3, space0);
+RWStructuredBuffer<uint> SpawnGroupTable : register(u4, space0);
 
-[numthreads(64, 1, 1)]
-void main( uint3 id : SV_DispatchThreadID )
+void UpdateEmitter(uint workItemIndex, uint emitterIndex)
 {
-    if (id.x >= Constants.emittersCount)
-    {
-        return;
-    }
-
-    // Indirection to emitter's contant and status buffer
-    uint emitterIndex = EmitterIndexBuffer[id.x];
-
     // Update emitter data
     EmitterStatusData emitterStatus = EmitterStatus[emitterIndex];
     EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
 
     emitterStatus.updateTime += Constants.deltaTime;
-    
+
+    uint aliveParticles = DrawIndirectBuffer[emitterIndex].instanceCount;
+
     if (emitterConstant.loopTime == -1.0f || emitterStatus.updateTime <= emitterConstant.loopTime)
     {
         emitterStatus.spawnAccTime += Constants.deltaTime;
@@ -37,8 +33,6 @@ void main( uint3 id : SV_DispatchThreadID )
         // Update emitter's seed with PCG RNG
         emitterStatus.currentSeed = GetRandomPCG(emitterStatus.currentSeed);
 
-        uint aliveParticles = DrawIndirectBuffer[emitterIndex].instanceCount;
-
         uint freeCount = EmitterConstant[emitterIndex].maxParticles - aliveParticles;
         uint maxSpawnCount = floor(emitterStatus.spawnAccTime * EmitterConstant[emitterIndex].spawnRate);
 
@@ -46,20 +40,56 @@ void main( uint3 id : SV_DispatchThreadID )
         emitterStatus.spawnAccTime -= float(maxSpawnCount) / EmitterConstant[emitterIndex].spawnRate;
 
         emitterStatus.particlesToUpdate = aliveParticles;
+
+        // Let the CPU know how many particles emitter needs, so it can grow emitter's particle pages
+        emitterStatus.requestedParticles = aliveParticles + maxSpawnCount;
     }
     else
     {
         emitterStatus.particlesToSpawn = 0;
-    }
+        emitterStatus.particlesToUpdate = aliveParticles;
+        emitterStatus.requestedParticles = aliveParticles;
 
-    EmitterStatus[emitterIndex] = emitterStatus;
+        // Emitter won't spawn anymore, once all of its particles are dead it can go to sleep
+        if (aliveParticles == 0)
+        {
+            emitterStatus.state = EmitterStateSleeping;
+        }
+    }
 
-    // Preapre spawn indirect buffer
-    uint spawnDispatchNum = (emitterStatus.particlesToSpawn + 63) / 64;
+    // Preapre spawn indirect buffer, sleeping emitters don't spawn anything
+    uint spawnDispatchNum = emitterStatus.state == EmitterStateSleeping ? 0 : (emitterStatus.particlesToSpawn + 63) / 64;
     SpawnIndirectBuffer[emitterIndex].threadGroupCountX = spawnDispatchNum;
     SpawnIndirectBuffer[emitterIndex].threadGroupCountY = 1;
     SpawnIndirectBuffer[emitterIndex].threadGroupCountZ = 1;
 
+    // Reserve a range of groups in the uber spawn dispatch, its arguments are stored after all emitters and reset by the CPU
+    InterlockedAdd(SpawnIndirectBuffer[Constants.spawnArgsIndex].threadGroupCountX, spawnDispatchNum, emitterStatus.spawnGroupOffset);
+
+    // Groups are reserved in any order, so the uber spawn finds its work item through the table instead of searching for it
+    if (Constants.buildSpawnGroupTable != 0)
+    {
+        for (uint groupIndex = 0; groupIndex < spawnDispatchNum; ++groupIndex)
+        {
+            SpawnGroupTable[emitterStatus.spawnGroupOffset + groupIndex] = workItemIndex;
+        }
+    }
+
+    // Fused kernel counts dead slots it hands out from zero every frame
+    emitterStatus.claimedSlots = 0;
+
+    EmitterStatus[emitterIndex] = emitterStatus;
+
     // Reset draw indirect buffer
     DrawIndirectBuffer[emitterIndex].instanceCount = 0;
 }
+
+[numthreads(64, 1, 1)]
+void main( uint3 id : SV_DispatchThreadID )
+{
+    if (id.x < Constants.emittersCount)
+    {
+        // Indirection to emitter's contant and status buffer, emitters are listed in the order of uber kernels' work items
+        UpdateEmitter(id.x, EmitterIndexBuffer[id.x]);
+    }
+}
@@ -0,0 +1,95 @@
+#include "particlecommon.hlsli"
+
+struct FusedConstants
+{
+    uint emitterIndex;
+    float deltaTime;
+};
+
+ConstantBuffer<FusedConstants> Constants : register(b0, space0);
+StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
+RWStructuredBuffer<EmitterStatusData> EmitterStatus : register(u1, space0);
+RWStructuredBuffer<uint> Indices : register(u2, space0);
+RWStructuredBuffer<uint> FreeList : register(u3, space0);
+RWStructuredBuffer<DrawIndirectArgs> DrawIndirectArgs : register(u4, space0);
+
+// Update and spawn in a single pass over emitter's slots, see ParticleFusedKernel for the CPU reference
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint emitterIndex = Constants.emitterIndex;
+    EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
+
+    // Constants baked by the emitter template's specialization
+    TOKEN_EMITTER_SPECIALIZATION
+
+    uint particleIndex = id.x;
+    if (particleIndex >= emitterConstant.maxParticles || EmitterStatus[emitterIndex].state == EmitterStateSleeping)
+    {
+        return;
+    }
+
+    uint offset = emitterConstant.indicesOffset;
+    ParticlesData particle = LoadParticle(Particles, emitterConstant, particleIndex);
+
+    bool wasAlive = particle.lifeTime > 0;
+    bool isAlive = wasAlive;
+
+    if (wasAlive)
+    {
+        Internal_InitRandom(EmitterStatus[emitterIndex].currentSeed, particleIndex);
+
+        // Update logic
+        {
+            TOKEN_UPDATE_LOGIC
+        }
+
+        isAlive = particle.lifeTime > 0;
+    }
+
+    if (!isAlive)
+    {
+        // Dead slots are claimed in any order, first particlesToSpawn of them get new particles.
+        // There are always enough of them, emitter update never spawns more than there were dead slots at the start.
+        uint claimIndex;
+        InterlockedAdd(EmitterStatus[emitterIndex].claimedSlots, 1, claimIndex);
+
+        uint particlesToSpawn = EmitterStatus[emitterIndex].particlesToSpawn;
+        if (claimIndex < particlesToSpawn)
+        {
+            Internal_InitRandom(EmitterStatus[emitterIndex].currentSeed, particleIndex);
+
+            // Spawn logic
+            {
+                TOKEN_SPAWN_LOGIC
+            }
+
+            isAlive = true;
+        }
+        else
+        {
+            // Remaining dead slots rebuild the free list from its end, so it ends up right above the alive particles
+            FreeList[offset + emitterConstant.maxParticles - 1 - (claimIndex - particlesToSpawn)] = particleIndex;
+        }
+    }
+
+    if (wasAlive || isAlive)
+    {
+        StoreParticle(Particles, emitterConstant, particleIndex, particle);
+    }
+
+    // Free list pointer has to match the number of alive particles, only slots which changed their state move it
+    if (wasAlive != isAlive)
+    {
+        InterlockedAdd(EmitterStatus[emitterIndex].freeListPointer, isAlive ? 1 : -1);
+    }
+
+    if (isAlive)
+    {
+        int index;
+        InterlockedAdd(DrawIndirectArgs[emitterIndex].instanceCount, 1, index);
+        Indices[offset + index] = GetParticleEntry(emitterConstant, particleIndex);
+    }
+
+}
@@ -21,3 +21,35 @@ float GetRandomFloat()
     random |= 0x3F800000U; // Set exponent to 127, this will result in float [1;2)
     return asfloat(random) - 1.0f;
 }
+
+// Particles of emitter's range, encoded as its template requires
+ParticlesData LoadParticle(RWStructuredBuffer<ParticleBlock> particles, EmitterConstantData emitterConstant, uint particleIndex)
+{
+    bool compact = emitterConstant.particleEncoding == ParticleEncodingCompact;
+    uint blockIndex = GetParticleBlockIndex(emitterConstant.particlesOffset, particleIndex, compact);
+
+    ParticleBlock blocks[FullParticleBlocks];
+    blocks[0] = particles[blockIndex];
+    blocks[1] = (ParticleBlock)0;
+    if (!compact)
+    {
+        blocks[1] = particles[blockIndex + 1];
+    }
+
+    return DecodeParticle(blocks, compact, emitterConstant.particleLifeTime);
+}
+
+void StoreParticle(RWStructuredBuffer<ParticleBlock> particles, EmitterConstantData emitterConstant, uint particleIndex, ParticlesData particle)
+{
+    bool compact = emitterConstant.particleEncoding == ParticleEncodingCompact;
+    uint blockIndex = GetParticleBlockIndex(emitterConstant.particlesOffset, particleIndex, compact);
+
+    ParticleBlock blocks[FullParticleBlocks];
+    EncodeParticle(particle, compact, emitterConstant.particleLifeTime, blocks);
+
+    particles[blockIndex] = blocks[0];
+    if (!compact)
+    {
+        particles[blockIndex + 1] = blocks[1];
+    }
+}
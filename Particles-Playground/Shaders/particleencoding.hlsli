@@ -0,0 +1,119 @@
+#ifndef __PARTICLE_ENCODING_HLSL__
+#define __PARTICLE_ENCODING_HLSL__
+
+// Shared by shaders and C++, so particles packed on one side can be read on the other
+
+static const uint32_t ParticleEncodingFull = 0;
+static const uint32_t ParticleEncodingCompact = 1;
+
+// Particles are stored in 24 byte blocks, emitters get as many blocks per particle as their encoding needs.
+// Full:    position, lifeTime, velocity.xy | velocity.z, scale, color
+// Compact: position, lifeTime (unorm16) and scale (half), velocity (half3), color (RGBA4)
+static const uint32_t ParticleBlockSize = 24;
+static const uint32_t FullParticleBlocks = 2;
+static const uint32_t CompactParticleBlocks = 1;
+
+// Index entries are particles' first blocks in the whole pool, compact ones are flagged so passes without emitter's constants know how to read them
+static const uint32_t CompactParticleEntryFlag = 0x80000000;
+
+// Alive particles never decode as dead, otherwise their slots would be lost
+static const float CompactMinLifeTime = 1.0e-6f;
+
+#ifdef __hlsl_dx_compiler
+
+uint PackHalf2(float2 value)
+{
+    return f32tof16(value.x) | (f32tof16(value.y) << 16);
+}
+
+float2 UnpackHalf2(uint packed)
+{
+    return float2(f16tof32(packed), f16tof32(packed >> 16));
+}
+
+uint PackUnorm4x4(float4 value)
+{
+    uint4 nibbles = uint4(round(saturate(value) * 15.0f));
+    return nibbles.x | (nibbles.y << 4) | (nibbles.z << 8) | (nibbles.w << 12);
+}
+
+float4 UnpackUnorm4x4(uint packed)
+{
+    return float4(packed & 0xF, (packed >> 4) & 0xF, (packed >> 8) & 0xF, (packed >> 12) & 0xF) / 15.0f;
+}
+
+// Life time is normalized by emitter's particle life time, longer ones are clamped
+uint PackLifeTime(float lifeTime, float particleLifeTime)
+{
+    if (lifeTime <= 0)
+    {
+        return 0;
+    }
+
+    return max(uint(round(saturate(lifeTime / particleLifeTime) * 65535.0f)), 1);
+}
+
+float UnpackLifeTime(uint packed, float particleLifeTime)
+{
+    uint normalized = packed & 0xFFFF;
+    if (normalized == 0)
+    {
+        return 0;
+    }
+
+    return max(normalized / 65535.0f * particleLifeTime, CompactMinLifeTime);
+}
+
+#else
+
+#include <DirectXPackedVector.h>
+
+inline uint32_t PackHalf2(const XMFLOAT2& value)
+{
+    return PackedVector::XMConvertFloatToHalf(value.x) | (static_cast<uint32_t>(PackedVector::XMConvertFloatToHalf(value.y)) << 16);
+}
+
+inline XMFLOAT2 UnpackHalf2(uint32_t packed)
+{
+    return XMFLOAT2(PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(packed)), PackedVector::XMConvertHalfToFloat(static_cast<PackedVector::HALF>(packed >> 16)));
+}
+
+inline uint32_t PackUnorm4x4(const XMFLOAT4& value)
+{
+    auto toNibble = [](float channel) {
+        return static_cast<uint32_t>(std::round(std::clamp(channel, 0.0f, 1.0f) * 15.0f));
+        };
+
+    return toNibble(value.x) | (toNibble(value.y) << 4) | (toNibble(value.z) << 8) | (toNibble(value.w) << 12);
+}
+
+inline XMFLOAT4 UnpackUnorm4x4(uint32_t packed)
+{
+    return XMFLOAT4((packed & 0xF) / 15.0f, ((packed >> 4) & 0xF) / 15.0f, ((packed >> 8) & 0xF) / 15.0f, ((packed >> 12) & 0xF) / 15.0f);
+}
+
+inline uint32_t PackLifeTime(float lifeTime, float particleLifeTime)
+{
+    if (lifeTime <= 0)
+    {
+        return 0;
+    }
+
+    const float normalized = particleLifeTime > 0 ? std::min(lifeTime / particleLifeTime, 1.0f) : 1.0f;
+    return std::max(static_cast<uint32_t>(std::round(normalized * 65535.0f)), 1U);
+}
+
+inline float UnpackLifeTime(uint32_t packed, float particleLifeTime)
+{
+    const uint32_t normalized = packed & 0xFFFF;
+    if (normalized == 0)
+    {
+        return 0;
+    }
+
+    return std::max(normalized / 65535.0f * particleLifeTime, CompactMinLifeTime);
+}
+
+#endif
+
+#endif // __PARTICLE_ENCODING_HLSL__
@@ -0,0 +1,27 @@
+// Keep in sync with ParticleSort on the CPU side
+static const uint SortModeNone = 0;
+static const uint SortModePerEmitter = 1;
+static const uint SortModeGlobal = 2;
+
+static const uint EmitterRankBits = 10;
+static const uint LocalSortSize = 1024;
+
+// Keys are sorted in ascending order, so farther particles have to get smaller keys
+uint GetDepthSortKey(float viewDepth)
+{
+    uint bits = asuint(viewDepth);
+    uint sortable = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+    return ~sortable;
+}
+
+uint GetParticleSortKey(float viewDepth, uint emitterRank, uint sortMode)
+{
+    uint depthKey = GetDepthSortKey(viewDepth);
+
+    if (sortMode == SortModePerEmitter)
+    {
+        return (emitterRank << (32 - EmitterRankBits)) | (depthKey >> EmitterRankBits);
+    }
+
+    return depthKey;
+}
@@ -0,0 +1,54 @@
+#include "default.hlsli"
+#include "particlesort.hlsli"
+
+struct PrepareDrawConstants
+{
+    uint emittersCount;
+    uint sortMode;
+};
+
+ConstantBuffer<PrepareDrawConstants> Constants : register(b0, space0);
+StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
+StructuredBuffer<uint> EmitterIndexBuffer : register(t1, space0);
+StructuredBuffer<DrawIndirectArgs> DrawIndirectBuffer : register(t2, space0);
+StructuredBuffer<uint> SortCount : register(t3, space0);
+RWStructuredBuffer<DrawParticlesCommand> DrawCommands : register(u0, space0);
+RWStructuredBuffer<uint> DrawCount : register(u1, space0);
+
+// Emitters are spread over many groups, draw count is reset on the CPU side before the dispatch
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    // Sorted particles of all emitters are drawn at once, indices already point to the global particle slots
+    if (Constants.sortMode != SortModeNone)
+    {
+        if (id.x == 0)
+        {
+            uint sortedCount = SortCount[0];
+            if (sortedCount > 0)
+            {
+                DrawCommands[0].indicesOffset = 0;
+                DrawCommands[0].drawArgs = DrawIndirectBuffer[EmitterIndexBuffer[0]];
+                DrawCommands[0].drawArgs.instanceCount = sortedCount;
+            }
+            DrawCount[0] = sortedCount > 0 ? 1 : 0;
+        }
+        return;
+    }
+
+    if (id.x < Constants.emittersCount)
+    {
+        uint emitterIndex = EmitterIndexBuffer[id.x];
+        DrawIndirectArgs drawArgs = DrawIndirectBuffer[emitterIndex];
+
+        // Emitters without alive particles don't produce a draw
+        if (drawArgs.instanceCount > 0)
+        {
+            uint commandIndex;
+            InterlockedAdd(DrawCount[0], 1, commandIndex);
+
+            DrawCommands[commandIndex].indicesOffset = EmitterConstant[emitterIndex].indicesOffset;
+            DrawCommands[commandIndex].drawArgs = drawArgs;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "default.hlsli"
+
+struct RelocateConstants
+{
+    uint srcOffset;
+    uint dstOffset;
+    uint copyCount;
+    uint capacity;
+    uint particleEncoding;
+    uint srcParticlesOffset;
+    uint dstParticlesOffset;
+};
+
+ConstantBuffer<RelocateConstants> Constants : register(b0, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
+RWStructuredBuffer<uint> FreeList : register(u1, space0);
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint index = id.x;
+    if (index >= Constants.capacity)
+    {
+        return;
+    }
+
+    bool compact = Constants.particleEncoding == ParticleEncodingCompact;
+    uint blocksCount = compact ? CompactParticleBlocks : FullParticleBlocks;
+    uint srcBlock = GetParticleBlockIndex(Constants.srcParticlesOffset, index, compact);
+    uint dstBlock = GetParticleBlockIndex(Constants.dstParticlesOffset, index, compact);
+
+    if (index < Constants.copyCount)
+    {
+        // Move particle and its free list entry to the emitter's new pages, either of them may stay where it was
+        for (uint block = 0; block < blocksCount; ++block)
+        {
+            Particles[dstBlock + block] = Particles[srcBlock + block];
+        }
+        FreeList[Constants.dstOffset + index] = FreeList[Constants.srcOffset + index];
+    }
+    else
+    {
+        // New slots start dead and are appended at the end of the free list, zeroed data is dead in both encodings
+        for (uint block = 0; block < blocksCount; ++block)
+        {
+            Particles[dstBlock + block] = (ParticleBlock)0;
+        }
+        FreeList[Constants.dstOffset + index] = index;
+    }
+}
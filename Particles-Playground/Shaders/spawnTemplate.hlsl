@@ -14,7 +14,7 @@ struct SpawnInput
 
 ConstantBuffer<SpawnConstants> Constants : register(b0, space0);
 StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
-RWStructuredBuffer<ParticlesData> Particles : register(u0, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
 RWStructuredBuffer<uint> FreeList : register(u1, space0);
 RWStructuredBuffer<uint> Indices : register(u2, space0);
 RWStructuredBuffer<DrawIndirectArgs> DrawIndirectArgs : register(u3, space0);
@@ -37,6 +37,9 @@ void main(SpawnInput input)
 
     EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
 
+    // Constants baked by the emitter template's specialization
+    TOKEN_EMITTER_SPECIALIZATION
+
     // Allocate indicies for new particles and slots for alive instances
     if (input.groupThreadID.x == 0)
     {
@@ -55,7 +58,7 @@ void main(SpawnInput input)
 
     // Setup instance index for current particle
     uint instanceOffset = offset + InstanceStartIndex + spawnGroupIndex;
-    Indices[instanceOffset] = particleIndex;
+    Indices[instanceOffset] = GetParticleEntry(emitterConstant, particleIndex);
 
     Internal_InitRandom(EmitterStatus[emitterIndex].currentSeed, particleIndex);
 
@@ -66,5 +69,5 @@ void main(SpawnInput input)
         TOKEN_SPAWN_LOGIC
     }
 
-    Particles[offset + particleIndex] = particle;
+    StoreParticle(Particles, emitterConstant, particleIndex, particle);
 }
@@ -0,0 +1,83 @@
+#include "particlecommon.hlsli"
+
+struct SpawnConstants
+{
+    uint emittersCount;
+};
+
+struct SpawnInput
+{
+    uint3 groupThreadID : SV_GroupThreadID;
+    uint3 groupID : SV_GroupID;
+};
+
+ConstantBuffer<SpawnConstants> Constants : register(b0, space0);
+StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
+StructuredBuffer<EmitterWorkItem> WorkItems : register(t1, space0);
+StructuredBuffer<uint> SpawnGroupTable : register(t2, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
+RWStructuredBuffer<uint> FreeList : register(u1, space0);
+RWStructuredBuffer<uint> Indices : register(u2, space0);
+RWStructuredBuffer<DrawIndirectArgs> DrawIndirectArgs : register(u3, space0);
+RWStructuredBuffer<EmitterStatusData> EmitterStatus : register(u4, space0);
+
+groupshared uint FreeListStartIndex;
+groupshared uint InstanceStartIndex;
+
+[numthreads(64, 1, 1)]
+void main(SpawnInput input)
+{
+    uint spawnGroupIndex = input.groupThreadID.x;
+
+    // Groups of emitters were reserved by the emitter update, which also recorded their work items
+    uint workItemIndex = SpawnGroupTable[input.groupID.x];
+    if (workItemIndex >= Constants.emittersCount)
+    {
+        return;
+    }
+
+    EmitterWorkItem workItem = WorkItems[workItemIndex];
+
+    uint emitterIndex = workItem.emitterIndex;
+    uint emitterGroupID = input.groupID.x - EmitterStatus[emitterIndex].spawnGroupOffset;
+    uint spawnIndex = emitterGroupID * 64 + spawnGroupIndex;
+
+    if (spawnIndex >= EmitterStatus[emitterIndex].particlesToSpawn)
+    {
+        return;
+    }
+
+    EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
+
+    // Allocate indicies for new particles and slots for alive instances
+    if (spawnGroupIndex == 0)
+    {
+        uint groupParticlesCount = min(64 * (emitterGroupID + 1), EmitterStatus[emitterIndex].particlesToSpawn) - (emitterGroupID * 64);
+        InterlockedAdd(EmitterStatus[emitterIndex].freeListPointer, groupParticlesCount, FreeListStartIndex);
+        InterlockedAdd(DrawIndirectArgs[emitterIndex].instanceCount, groupParticlesCount, InstanceStartIndex);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint offset = emitterConstant.indicesOffset;
+
+    // Get index for current particle
+    uint freeListOffset = offset + FreeListStartIndex + spawnGroupIndex;
+    uint particleIndex = FreeList[freeListOffset];
+    FreeList[freeListOffset] = -1;
+
+    // Setup instance index for current particle
+    uint instanceOffset = offset + InstanceStartIndex + spawnGroupIndex;
+    Indices[instanceOffset] = GetParticleEntry(emitterConstant, particleIndex);
+
+    Internal_InitRandom(EmitterStatus[emitterIndex].currentSeed, particleIndex);
+
+    ParticlesData particle;
+
+    // Spawn logic of all templates, whole group runs the same case
+    switch (workItem.templateIndex)
+    {
+        TOKEN_SPAWN_LOGIC_CASES
+    }
+
+    StoreParticle(Particles, emitterConstant, particleIndex, particle);
+}
@@ -8,7 +8,7 @@ struct UpdateConstants
 
 ConstantBuffer<UpdateConstants> Constants : register(b0, space0);
 StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
-RWStructuredBuffer<ParticlesData> Particles : register(u0, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
 RWStructuredBuffer<EmitterStatusData> EmitterStatus : register(u1, space0);
 RWStructuredBuffer<uint> Indices : register(u2, space0);
 RWStructuredBuffer<uint> FreeList : register(u3, space0);
@@ -20,14 +20,17 @@ void main(uint3 id : SV_DispatchThreadID)
     uint emitterIndex = Constants.emitterIndex;
     EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
 
+    // Constants baked by the emitter template's specialization
+    TOKEN_EMITTER_SPECIALIZATION
+
     uint particleIndex = id.x;
-    if (particleIndex >= emitterConstant.maxParticles)
+    if (particleIndex >= emitterConstant.maxParticles || EmitterStatus[emitterIndex].state == EmitterStateSleeping)
     {
         return;
     }
 
     uint offset = emitterConstant.indicesOffset;
-    ParticlesData particle = Particles[offset + particleIndex];
+    ParticlesData particle = LoadParticle(Particles, emitterConstant, particleIndex);
 
     if (particle.lifeTime > 0)
     {
@@ -38,7 +41,7 @@ void main(uint3 id : SV_DispatchThreadID)
             TOKEN_UPDATE_LOGIC
         }
 
-        Particles[offset + particleIndex] = particle;
+        StoreParticle(Particles, emitterConstant, particleIndex, particle);
 
         if (particle.lifeTime <= 0)
         {
@@ -52,7 +55,7 @@ void main(uint3 id : SV_DispatchThreadID)
         {
             int index;
             InterlockedAdd(DrawIndirectArgs[emitterIndex].instanceCount, 1, index);
-            Indices[offset + index] = particleIndex;
+            Indices[offset + index] = GetParticleEntry(emitterConstant, particleIndex);
         }
 
     }
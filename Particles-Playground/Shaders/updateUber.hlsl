@@ -0,0 +1,89 @@
+#include "particlecommon.hlsli"
+
+struct UpdateConstants
+{
+    uint emittersCount;
+    float deltaTime;
+};
+
+ConstantBuffer<UpdateConstants> Constants : register(b0, space0);
+StructuredBuffer<EmitterConstantData> EmitterConstant : register(t0, space0);
+StructuredBuffer<EmitterWorkItem> WorkItems : register(t1, space0);
+RWStructuredBuffer<ParticleBlock> Particles : register(u0, space0);
+RWStructuredBuffer<EmitterStatusData> EmitterStatus : register(u1, space0);
+RWStructuredBuffer<uint> Indices : register(u2, space0);
+RWStructuredBuffer<uint> FreeList : register(u3, space0);
+RWStructuredBuffer<DrawIndirectArgs> DrawIndirectArgs : register(u4, space0);
+
+// Work items are sorted by their group offsets, the group belongs to the last one starting at or before it.
+// Emitters without particles have no groups and share the offset with the next one, so they are never picked.
+uint FindWorkItem(uint groupID)
+{
+    uint first = 0;
+    uint count = Constants.emittersCount;
+
+    while (count > 0)
+    {
+        uint step = count / 2;
+        if (WorkItems[first + step].groupOffset <= groupID)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first - 1;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    // Same for the whole group, so the search is uniform
+    EmitterWorkItem workItem = WorkItems[FindWorkItem(groupID.x)];
+
+    uint emitterIndex = workItem.emitterIndex;
+    EmitterConstantData emitterConstant = EmitterConstant[emitterIndex];
+
+    uint particleIndex = (groupID.x - workItem.groupOffset) * 64 + groupIndex;
+    if (particleIndex >= emitterConstant.maxParticles || EmitterStatus[emitterIndex].state == EmitterStateSleeping)
+    {
+        return;
+    }
+
+    uint offset = emitterConstant.indicesOffset;
+    ParticlesData particle = LoadParticle(Particles, emitterConstant, particleIndex);
+
+    if (particle.lifeTime > 0)
+    {
+        Internal_InitRandom(EmitterStatus[emitterIndex].currentSeed, particleIndex);
+
+        // Update logic of all templates, whole group runs the same case
+        switch (workItem.templateIndex)
+        {
+            TOKEN_UPDATE_LOGIC_CASES
+        }
+
+        StoreParticle(Particles, emitterConstant, particleIndex, particle);
+
+        if (particle.lifeTime <= 0)
+        {
+            uint freeListIndex;
+            InterlockedAdd(EmitterStatus[emitterIndex].freeListPointer, -1, freeListIndex);
+            freeListIndex -= 1;
+
+            FreeList[offset + freeListIndex] = particleIndex;
+        }
+        else
+        {
+            int index;
+            InterlockedAdd(DrawIndirectArgs[emitterIndex].instanceCount, 1, index);
+            Indices[offset + index] = GetParticleEntry(emitterConstant, particleIndex);
+        }
+
+    }
+
+}
@@ -1,19 +1,22 @@
 #include "commandlist.h"
 #include "graphic.h"
+#include "commandlistpool.h"
 
 CommandList::CommandList(QueueType type)
     : mType(type)
 {
-    ID3D12CommandAllocator* allocator = Graphic::Get().GetCurrentCommandAllocator(type);
-    const D3D12_COMMAND_LIST_TYPE commandListType = Graphic::GetCommandListType(type);
-    Graphic::Get().GetDevice()->CreateCommandList(0, commandListType, allocator, nullptr, IID_PPV_ARGS(&mCommandList));
+    mCommandList = Graphic::Get().GetCommandListPool()->Acquire(type);
 }
 
 CommandList::~CommandList()
 {
     if (!mCommandList) { return; }
 
-    mCommandList->Release();
+    // Pooled list has to be closed before it can be reset again
+    if (!mClosed)
+    {
+        mCommandList->Close();
+    }
     mCommandList = nullptr;
 }
 
@@ -32,13 +35,321 @@ void CommandList::Submit()
     if (!mCommandList) { return; }
 
     mCommandList->Close();
+    mClosed = true;
     Graphic::Get().GetQueue(mType)->ExecuteCommandLists(1, reinterpret_cast<ID3D12CommandList**>(&mCommandList));
 }
 
 CommandList& CommandList::operator=(CommandList&& rhs)
 {
+    mType = rhs.mType;
     mCommandList = rhs.mCommandList;
+    mClosed = rhs.mClosed;
     rhs.mCommandList = nullptr;
 
+    mGraphicsRootArguments = rhs.mGraphicsRootArguments;
+    mComputeRootArguments = rhs.mComputeRootArguments;
+    mPipelineState = rhs.mPipelineState;
+    mDescriptorHeaps = rhs.mDescriptorHeaps;
+    mVertexBuffers = rhs.mVertexBuffers;
+    mIndexBuffer = rhs.mIndexBuffer;
+    mTopology = rhs.mTopology;
+    mViewports = rhs.mViewports;
+    mScissorRects = rhs.mScissorRects;
+    mViewportsCount = rhs.mViewportsCount;
+    mScissorRectsCount = rhs.mScissorRectsCount;
+    mStats = rhs.mStats;
+
     return *this;
 }
+
+void CommandList::SetGraphicsRootSignature(ID3D12RootSignature* rootSignature)
+{
+    if (Filter(UpdateRootSignature(mGraphicsRootArguments, rootSignature)))
+    {
+        mCommandList->SetGraphicsRootSignature(rootSignature);
+    }
+}
+
+void CommandList::SetComputeRootSignature(ID3D12RootSignature* rootSignature)
+{
+    if (Filter(UpdateRootSignature(mComputeRootArguments, rootSignature)))
+    {
+        mCommandList->SetComputeRootSignature(rootSignature);
+    }
+}
+
+void CommandList::SetPipelineState(ID3D12PipelineState* pipelineState)
+{
+    if (Filter(mPipelineState != pipelineState))
+    {
+        mPipelineState = pipelineState;
+        mCommandList->SetPipelineState(pipelineState);
+    }
+}
+
+void CommandList::SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps)
+{
+    Assert(count <= mDescriptorHeaps.size());
+
+    std::array<ID3D12DescriptorHeap*, 2> descriptorHeaps = {};
+    std::copy(heaps, heaps + count, descriptorHeaps.begin());
+
+    if (Filter(mDescriptorHeaps != descriptorHeaps))
+    {
+        // Descriptor tables point to the previous heaps, they have to be set again
+        mDescriptorHeaps = descriptorHeaps;
+        mGraphicsRootArguments.DescriptorTables = {};
+        mComputeRootArguments.DescriptorTables = {};
+        mCommandList->SetDescriptorHeaps(count, const_cast<ID3D12DescriptorHeap**>(heaps));
+    }
+}
+
+void CommandList::SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* data)
+{
+    if (Filter(UpdateRootConstants(mGraphicsRootArguments, rootIndex, count, data)))
+    {
+        mCommandList->SetGraphicsRoot32BitConstants(rootIndex, count, data, 0);
+    }
+}
+
+void CommandList::SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* data)
+{
+    if (Filter(UpdateRootConstants(mComputeRootArguments, rootIndex, count, data)))
+    {
+        mCommandList->SetComputeRoot32BitConstants(rootIndex, count, data, 0);
+    }
+}
+
+void CommandList::SetGraphicsRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+{
+    if (Filter(UpdateDescriptorTable(mGraphicsRootArguments, rootIndex, handle)))
+    {
+        mCommandList->SetGraphicsRootDescriptorTable(rootIndex, handle);
+    }
+}
+
+void CommandList::SetComputeRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+{
+    if (Filter(UpdateDescriptorTable(mComputeRootArguments, rootIndex, handle)))
+    {
+        mCommandList->SetComputeRootDescriptorTable(rootIndex, handle);
+    }
+}
+
+void CommandList::SetGraphicsRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mGraphicsRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetGraphicsRootConstantBufferView(rootIndex, address);
+    }
+}
+
+void CommandList::SetComputeRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mComputeRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetComputeRootConstantBufferView(rootIndex, address);
+    }
+}
+
+void CommandList::SetGraphicsRootShaderResourceView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mGraphicsRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetGraphicsRootShaderResourceView(rootIndex, address);
+    }
+}
+
+void CommandList::SetComputeRootShaderResourceView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mComputeRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetComputeRootShaderResourceView(rootIndex, address);
+    }
+}
+
+void CommandList::SetGraphicsRootUnorderedAccessView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mGraphicsRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetGraphicsRootUnorderedAccessView(rootIndex, address);
+    }
+}
+
+void CommandList::SetComputeRootUnorderedAccessView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    if (Filter(UpdateRootDescriptor(mComputeRootArguments, rootIndex, address)))
+    {
+        mCommandList->SetComputeRootUnorderedAccessView(rootIndex, address);
+    }
+}
+
+void CommandList::IASetVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views)
+{
+    bool changed = startSlot + count > MaxVertexBuffers;
+    for (uint32_t i = 0; i < count && !changed; ++i)
+    {
+        changed = std::memcmp(&mVertexBuffers[startSlot + i], &views[i], sizeof(D3D12_VERTEX_BUFFER_VIEW)) != 0;
+    }
+
+    if (Filter(changed))
+    {
+        // Slots past the shadowed ones are never filtered
+        for (uint32_t i = 0; i < count && startSlot + i < MaxVertexBuffers; ++i)
+        {
+            mVertexBuffers[startSlot + i] = views[i];
+        }
+        mCommandList->IASetVertexBuffers(startSlot, count, views);
+    }
+}
+
+void CommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+{
+    if (Filter(std::memcmp(&mIndexBuffer, view, sizeof(D3D12_INDEX_BUFFER_VIEW)) != 0))
+    {
+        mIndexBuffer = *view;
+        mCommandList->IASetIndexBuffer(view);
+    }
+}
+
+void CommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    if (Filter(mTopology != topology))
+    {
+        mTopology = topology;
+        mCommandList->IASetPrimitiveTopology(topology);
+    }
+}
+
+void CommandList::RSSetViewports(uint32_t count, const D3D12_VIEWPORT* viewports)
+{
+    Assert(count <= mViewports.size());
+
+    const bool changed = mViewportsCount != count || std::memcmp(mViewports.data(), viewports, count * sizeof(D3D12_VIEWPORT)) != 0;
+    if (Filter(changed))
+    {
+        mViewportsCount = count;
+        std::copy(viewports, viewports + count, mViewports.begin());
+        mCommandList->RSSetViewports(count, viewports);
+    }
+}
+
+void CommandList::RSSetScissorRects(uint32_t count, const D3D12_RECT* rects)
+{
+    Assert(count <= mScissorRects.size());
+
+    const bool changed = mScissorRectsCount != count || std::memcmp(mScissorRects.data(), rects, count * sizeof(D3D12_RECT)) != 0;
+    if (Filter(changed))
+    {
+        mScissorRectsCount = count;
+        std::copy(rects, rects + count, mScissorRects.begin());
+        mCommandList->RSSetScissorRects(count, rects);
+    }
+}
+
+void CommandList::ExecuteIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount, ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer, uint64_t countBufferOffset)
+{
+    mCommandList->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset, countBuffer, countBufferOffset);
+
+    // Keep root signatures, but force all root arguments to be set again
+    for (RootArgumentsState* state : { &mGraphicsRootArguments, &mComputeRootArguments })
+    {
+        ID3D12RootSignature* rootSignature = state->RootSignature;
+        *state = {};
+        state->RootSignature = rootSignature;
+    }
+
+    // Vertex buffers, index buffer and topology can be changed by the command signature too
+    mVertexBuffers = {};
+    mIndexBuffer = {};
+    mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+bool CommandList::Filter(bool changed)
+{
+    if (changed)
+    {
+        ++mStats.IssuedCalls;
+    }
+    else
+    {
+        ++mStats.FilteredCalls;
+    }
+    return changed;
+}
+
+bool CommandList::UpdateRootSignature(RootArgumentsState& state, ID3D12RootSignature* rootSignature)
+{
+    if (state.RootSignature == rootSignature)
+    {
+        return false;
+    }
+
+    // All root arguments are undefined after the root signature changes
+    state = {};
+    state.RootSignature = rootSignature;
+    return true;
+}
+
+bool CommandList::UpdateRootConstants(RootArgumentsState& state, uint32_t rootIndex, uint32_t count, const void* data)
+{
+    Assert(rootIndex < MaxRootParameters);
+
+    if (state.ConstantsCount[rootIndex] == UntrackedConstants)
+    {
+        return true;
+    }
+
+    if (state.ConstantsCount[rootIndex] == 0)
+    {
+        // Parameter's constants which don't fit are never filtered
+        if (state.UsedConstants + count > MaxRootConstants)
+        {
+            state.ConstantsCount[rootIndex] = UntrackedConstants;
+            return true;
+        }
+
+        state.ConstantsOffset[rootIndex] = static_cast<uint8_t>(state.UsedConstants);
+        state.ConstantsCount[rootIndex] = static_cast<uint8_t>(count);
+        state.UsedConstants += count;
+    }
+    else if (state.ConstantsCount[rootIndex] != count)
+    {
+        // Parameter is set with a different size than before, stop shadowing it
+        state.ConstantsCount[rootIndex] = UntrackedConstants;
+        return true;
+    }
+    else if (std::memcmp(&state.Constants[state.ConstantsOffset[rootIndex]], data, count * sizeof(uint32_t)) == 0)
+    {
+        return false;
+    }
+
+    std::memcpy(&state.Constants[state.ConstantsOffset[rootIndex]], data, count * sizeof(uint32_t));
+    return true;
+}
+
+bool CommandList::UpdateDescriptorTable(RootArgumentsState& state, uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle)
+{
+    Assert(rootIndex < MaxRootParameters);
+
+    if (state.DescriptorTables[rootIndex].ptr == handle.ptr)
+    {
+        return false;
+    }
+
+    state.DescriptorTables[rootIndex] = handle;
+    return true;
+}
+
+bool CommandList::UpdateRootDescriptor(RootArgumentsState& state, uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    Assert(rootIndex < MaxRootParameters);
+
+    if (state.RootDescriptors[rootIndex] == address)
+    {
+        return false;
+    }
+
+    state.RootDescriptors[rootIndex] = address;
+    return true;
+}
@@ -2,8 +2,35 @@
 
 enum class QueueType;
 
+// Number of state changing calls which were sent to the driver and which were dropped because they wouldn't change anything
+struct CommandListStats
+{
+    uint32_t IssuedCalls = 0;
+    uint32_t FilteredCalls = 0;
+};
+
+// Wraps a command list taken from Graphic's CommandListPool, the list goes back to the pool with the frame
 class CommandList
 {
+    static const uint32_t MaxRootParameters = 64;
+    static const uint32_t MaxRootConstants = 64;
+    static const uint32_t MaxVertexBuffers = 4;
+    static const uint8_t UntrackedConstants = std::numeric_limits<uint8_t>::max();
+
+    // Root arguments are shadowed separately for graphics and compute, changing the root signature resets them
+    struct RootArgumentsState
+    {
+        ID3D12RootSignature* RootSignature = nullptr;
+        std::array<D3D12_GPU_DESCRIPTOR_HANDLE, MaxRootParameters> DescriptorTables = {};
+        std::array<D3D12_GPU_VIRTUAL_ADDRESS, MaxRootParameters> RootDescriptors = {};
+
+        // Constants of all parameters are packed together, offset and count are kept per parameter
+        std::array<uint32_t, MaxRootConstants> Constants = {};
+        std::array<uint8_t, MaxRootParameters> ConstantsOffset = {};
+        std::array<uint8_t, MaxRootParameters> ConstantsCount = {};
+        uint32_t UsedConstants = 0;
+    };
+
 public:
     CommandList(QueueType type);
     ~CommandList();
@@ -18,10 +45,58 @@ public:
 
     void Submit();
 
+    // Setters below skip calls which don't change the currently bound state, they have to be used instead of the raw list's ones
+    void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature);
+    void SetComputeRootSignature(ID3D12RootSignature* rootSignature);
+    void SetPipelineState(ID3D12PipelineState* pipelineState);
+    void SetDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps);
+    void SetGraphicsRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* data);
+    void SetComputeRoot32BitConstants(uint32_t rootIndex, uint32_t count, const void* data);
+    void SetGraphicsRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+    void SetComputeRootDescriptorTable(uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+    void SetGraphicsRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetComputeRootConstantBufferView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetGraphicsRootShaderResourceView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetComputeRootShaderResourceView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetGraphicsRootUnorderedAccessView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void SetComputeRootUnorderedAccessView(uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+    void IASetVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views);
+    void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view);
+    void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+    void RSSetViewports(uint32_t count, const D3D12_VIEWPORT* viewports);
+    void RSSetScissorRects(uint32_t count, const D3D12_RECT* rects);
+
+    // Command signature can change root arguments, so they are forgotten afterwards
+    void ExecuteIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount, ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer, uint64_t countBufferOffset);
+
     inline ID3D12GraphicsCommandList* Get() { return mCommandList; }
+    inline const CommandListStats& GetStats() const { return mStats; }
 
 private:
+    bool Filter(bool changed);
+    bool UpdateRootSignature(RootArgumentsState& state, ID3D12RootSignature* rootSignature);
+    bool UpdateRootConstants(RootArgumentsState& state, uint32_t rootIndex, uint32_t count, const void* data);
+    bool UpdateDescriptorTable(RootArgumentsState& state, uint32_t rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+    bool UpdateRootDescriptor(RootArgumentsState& state, uint32_t rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+
     QueueType mType;
     ID3D12GraphicsCommandList* mCommandList = nullptr;
+    bool mClosed = false;
+
+    RootArgumentsState mGraphicsRootArguments;
+    RootArgumentsState mComputeRootArguments;
+    ID3D12PipelineState* mPipelineState = nullptr;
+    std::array<ID3D12DescriptorHeap*, 2> mDescriptorHeaps = {};
+
+    std::array<D3D12_VERTEX_BUFFER_VIEW, MaxVertexBuffers> mVertexBuffers = {};
+    D3D12_INDEX_BUFFER_VIEW mIndexBuffer = {};
+    D3D12_PRIMITIVE_TOPOLOGY mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+    std::array<D3D12_VIEWPORT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE> mViewports = {};
+    std::array<D3D12_RECT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE> mScissorRects = {};
+    uint32_t mViewportsCount = 0;
+    uint32_t mScissorRectsCount = 0;
+
+    CommandListStats mStats;
 
 };
@@ -0,0 +1,61 @@
+#include "commandlistpool.h"
+
+CommandListPool::~CommandListPool()
+{
+    for (auto& queuePools : mPools)
+    {
+        for (FramePool& framePool : queuePools)
+        {
+            for (PooledCommandList& pooled : framePool.CommandLists)
+            {
+                pooled.CommandList->Release();
+                pooled.Allocator->Release();
+            }
+        }
+    }
+}
+
+ID3D12GraphicsCommandList* CommandListPool::Acquire(QueueType type)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    FramePool& framePool = mPools[static_cast<uint32_t>(type)][Graphic::Get().GetCurrentFrameIndex()];
+
+    if (framePool.UsedNum < framePool.CommandLists.size())
+    {
+        // List has been closed when it was submitted, allocator has been reset together with the frame
+        PooledCommandList& pooled = framePool.CommandLists[framePool.UsedNum++];
+        pooled.CommandList->Reset(pooled.Allocator, nullptr);
+        return pooled.CommandList;
+    }
+
+    ID3D12Device* const device = Graphic::Get().GetDevice();
+    const D3D12_COMMAND_LIST_TYPE commandListType = Graphic::GetCommandListType(type);
+
+    PooledCommandList pooled;
+    HRESULT hr = device->CreateCommandAllocator(commandListType, IID_PPV_ARGS(&pooled.Allocator));
+    Assert(SUCCEEDED(hr));
+
+    hr = device->CreateCommandList(0, commandListType, pooled.Allocator, nullptr, IID_PPV_ARGS(&pooled.CommandList));
+    Assert(SUCCEEDED(hr));
+
+    framePool.CommandLists.push_back(pooled);
+    ++framePool.UsedNum;
+
+    return pooled.CommandList;
+}
+
+void CommandListPool::Reset(uint32_t frameIndex)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto& queuePools : mPools)
+    {
+        FramePool& framePool = queuePools[frameIndex];
+        for (uint32_t i = 0; i < framePool.UsedNum; ++i)
+        {
+            framePool.CommandLists[i].Allocator->Reset();
+        }
+        framePool.UsedNum = 0;
+    }
+}
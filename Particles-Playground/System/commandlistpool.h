@@ -0,0 +1,42 @@
+#pragma once
+#include "graphic.h"
+
+// Keeps command lists of every queue and frame in flight, so they are reset instead of created every frame.
+// Every list has its own allocator, which allows recording many lists of the same frame on different threads.
+class CommandListPool
+{
+    static const uint32_t QueueTypeNum = 3;
+
+    struct PooledCommandList
+    {
+        ID3D12CommandAllocator* Allocator = nullptr;
+        ID3D12GraphicsCommandList* CommandList = nullptr;
+    };
+
+    struct FramePool
+    {
+        std::vector<PooledCommandList> CommandLists;
+        uint32_t UsedNum = 0;
+    };
+
+public:
+    CommandListPool() = default;
+    ~CommandListPool();
+
+    CommandListPool(const CommandListPool&) = delete;
+    CommandListPool(CommandListPool&&) = delete;
+
+    CommandListPool& operator=(const CommandListPool&) = delete;
+    CommandListPool& operator=(CommandListPool&&) = delete;
+
+    // Returns a list in the recording state for the current frame, thread-safe
+    ID3D12GraphicsCommandList* Acquire(QueueType type);
+
+    // Lists acquired during the frame can be reused, GPU has to be done with the frame
+    void Reset(uint32_t frameIndex);
+
+private:
+    std::array<std::array<FramePool, Graphic::GetFrameCount()>, QueueTypeNum> mPools;
+    std::mutex mMutex;
+
+};
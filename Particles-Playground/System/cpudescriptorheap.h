@@ -1,5 +1,5 @@
 #pragma once
-#include "Utilities/freelistallocator.h"
+#include "Utilities/bitmapallocator.h"
 
 class CPUDescriptorHandle
 {
@@ -41,6 +41,6 @@ public:
 private:
     D3D12_DESCRIPTOR_HEAP_TYPE mType;
     ID3D12DescriptorHeap* mHeap = nullptr;
-    FreeListAllocator<FirstFitStrategy> mAllocator;
+    BitmapAllocator mAllocator;
 
 };
@@ -22,6 +22,8 @@ void Engine::PreUpdate()
 {
     Window::Get().PreUpdate();
     Graphic::Get().PreUpdate();
+    ShaderManager::Get().PreUpdate();
+    PSOManager::Get().PreUpdate();
     GPUBufferUploadManager::Get().PreUpdate();
 }
 
@@ -5,6 +5,7 @@
 #include "System/meshmanager.h"
 #include "System/commandlist.h"
 #include "System/gpubuffer.h"
+#include "System/gpureadbackbuffer.h"
 #include "System/texture.h"
 #include "System/sampler.h"
 #include "System/cpudescriptorheap.h"
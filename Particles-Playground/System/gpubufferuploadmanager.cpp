@@ -1,4 +1,5 @@
 #include "gpubufferuploadmanager.h"
+#include "../Utilities/memory.h"
 
 uint8_t* UploadBufferTemporaryRange::Map()
 {
@@ -38,6 +39,8 @@ bool GPUBufferUploadManager::Startup()
     res = device->CreatePlacedResource(mHeap, 0, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mUploadRes));
     Assert(SUCCEEDED(res));
 
+    BeginFrameSegment();
+
     return true;
 }
 
@@ -46,41 +49,50 @@ bool GPUBufferUploadManager::Shutdown()
     if (mHeap) { mHeap->Release(); }
     if (mUploadRes) { mUploadRes->Release(); }
 
-    for (Allocation& alloc : mAllocations)
-    {
-        mAllocator.Free(alloc.AllocationRange);
-    }
-
     return true;
 }
 
 void GPUBufferUploadManager::PreUpdate()
 {
-    const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
-    const uint32_t frameCount = Graphic::Get().GetFrameCount();
-
-    for (Allocation& alloc : mAllocations)
+    // Uploads made before the first frame belong to it, so the segment can't be reset yet
+    if (Graphic::Get().GetCurrentFrameNumber() == mFrameNumber.load(std::memory_order_relaxed))
     {
-        // Merge not needed memory block
-        if (alloc.FrameNumber + frameCount <= currentFrameNum)
-        {
-            mAllocator.Free(alloc.AllocationRange);
-        }
+        return;
     }
 
-    mAllocations.remove_if([currentFrameNum, frameCount](const Allocation& alloc) {
-        return alloc.FrameNumber + frameCount <= currentFrameNum;
-    });
-
+    // Graphic has already waited for the frame which used this segment before
+    BeginFrameSegment();
 }
 
 UploadBufferTemporaryRangeHandle GPUBufferUploadManager::Reserve(uint32_t size, uint32_t alignment)
 {
-    Range alloc = mAllocator.Allocate(size, alignment);
-    Assert(alloc.IsValid());
+    static thread_local ThreadBlock threadBlock;
 
-    const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
-    mAllocations.push_back({ {alloc.Start, alloc.Size}, currentFrameNum });
+    const uint64_t frameNumber = mFrameNumber.load(std::memory_order_acquire);
+    uint64_t start = Align(threadBlock.Current, static_cast<uint64_t>(alignment));
+
+    // Blocks of previous frames are dropped, their memory is retired together with the segment
+    if (threadBlock.FrameNumber != frameNumber || start + size > threadBlock.End)
+    {
+        const uint64_t blockSize = std::max<uint64_t>(ThreadBlockSize, static_cast<uint64_t>(size) + alignment - 1);
+        const uint64_t blockOffset = mSegmentOffset.fetch_add(blockSize, std::memory_order_relaxed);
+        Assert(blockOffset + blockSize <= FrameSegmentSize); // not enough upload memory for this frame
 
-    return std::make_unique<UploadBufferTemporaryRange>(alloc.Start, alloc.Start + alloc.Size);
+        threadBlock.FrameNumber = frameNumber;
+        threadBlock.Current = mSegmentStart + blockOffset;
+        threadBlock.End = threadBlock.Current + blockSize;
+
+        start = Align(threadBlock.Current, static_cast<uint64_t>(alignment));
+    }
+
+    threadBlock.Current = start + size;
+
+    return std::make_unique<UploadBufferTemporaryRange>(start, start + size);
+}
+
+void GPUBufferUploadManager::BeginFrameSegment()
+{
+    mSegmentStart = static_cast<uint64_t>(Graphic::Get().GetCurrentFrameIndex()) * FrameSegmentSize;
+    mSegmentOffset.store(0, std::memory_order_relaxed);
+    mFrameNumber.store(Graphic::Get().GetCurrentFrameNumber(), std::memory_order_release);
 }
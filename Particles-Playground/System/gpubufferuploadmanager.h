@@ -1,6 +1,5 @@
 #pragma once
 #include "graphic.h"
-#include "../Utilities/freelistallocator.h"
 
 class UploadBufferTemporaryRange
 {
@@ -26,14 +25,24 @@ private:
 using UploadBufferTemporaryRangeHandle = std::unique_ptr<UploadBufferTemporaryRange>;
 
 // Handles memory that is used for buffer's uploads. Each allocation is valid only for the maximum amount of frames in flight defined in Graphic
+// Upload heap is split into a linear segment per frame in flight, the segment is reused once the GPU is done with its frame.
+// Reserve can be called from many threads at once, but not during PreUpdate.
 class GPUBufferUploadManager
 {
-    static const uint32_t UploadHeapSize = 1 * 1024 * 1024;
+public:
+    // Every thread which reserves memory during a frame takes at least one block of the frame's segment
+    static const uint32_t FrameSegmentSize = 1 * 1024 * 1024;
+    static const uint32_t ThreadBlockSize = 64 * 1024;
+
+private:
+    static const uint32_t UploadHeapSize = FrameSegmentSize * Graphic::GetFrameCount();
 
-    struct Allocation
+    // Every thread reserves memory from its own block, shared state is touched only when a new block is needed
+    struct ThreadBlock
     {
-        Range AllocationRange;
-        uint64_t FrameNumber = 0;
+        uint64_t FrameNumber = std::numeric_limits<uint64_t>::max();
+        uint64_t Current = 0;
+        uint64_t End = 0;
     };
 
 public:
@@ -59,14 +68,16 @@ public:
     }
 
 private:
-    explicit GPUBufferUploadManager()
-        : mAllocator(0, UploadHeapSize)
-    {}
+    explicit GPUBufferUploadManager() = default;
+
+    void BeginFrameSegment();
 
     ID3D12Heap* mHeap = nullptr;
     ID3D12Resource* mUploadRes = nullptr;
 
-    std::list<Allocation> mAllocations;
-    FreeListAllocator<FirstFitStrategy> mAllocator;
+    // Blocks of the current frame are carved from its segment by moving the offset
+    std::atomic<uint64_t> mFrameNumber = 0;
+    uint64_t mSegmentStart = 0;
+    std::atomic<uint64_t> mSegmentOffset = 0;
 
 };
@@ -1,7 +1,7 @@
 #pragma once
 #include "System/graphic.h"
 #include "Utilities/circularallocator.h"
-#include "Utilities/freelistallocator.h"
+#include "Utilities/bitmapallocator.h"
 
 class GPUBindlessDescriptorHandle
 {
@@ -123,7 +123,7 @@ private:
 
     D3D12_DESCRIPTOR_HEAP_TYPE mType;
     CircularAllocator mStandardAllocator;
-    FreeListAllocator<FirstFitStrategy> mBindlessAllocator;
+    BitmapAllocator mBindlessAllocator;
     ID3D12DescriptorHeap* mHeap = nullptr;
     DelayedReleaseContainer mDelayedRelease;
 };
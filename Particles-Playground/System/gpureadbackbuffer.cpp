@@ -0,0 +1,71 @@
+#include "System/gpureadbackbuffer.h"
+#include "System/gpubuffer.h"
+#include "System/commandlist.h"
+
+GPUReadbackBuffer::GPUReadbackBuffer(uint32_t size)
+    : mSize(size)
+{
+    mFrameNumbers.fill(InvalidFrameNumber);
+
+    ID3D12Device* const device = Graphic::Get().GetDevice();
+
+    const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(static_cast<uint64_t>(mSize) * Graphic::GetFrameCount());
+    const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+    HRESULT hr = device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mResource));
+    Assert(SUCCEEDED(hr));
+}
+
+GPUReadbackBuffer::~GPUReadbackBuffer()
+{
+    Assert(!mMapped);
+
+    if (mResource)
+    {
+        mResource->Release();
+        mResource = nullptr;
+    }
+}
+
+void GPUReadbackBuffer::CopyFrom(CommandList& cmdList, GPUBuffer& buffer, uint32_t start, uint32_t size)
+{
+    Assert(size <= mSize);
+    Assert(start + size <= buffer.GetBufferSize());
+    Assert(buffer.GetCurrentResourceState() == D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    const uint32_t frameIndex = Graphic::Get().GetCurrentFrameIndex();
+    const uint64_t dstOffset = static_cast<uint64_t>(mSize) * frameIndex;
+
+    cmdList->CopyBufferRegion(mResource, dstOffset, buffer.GetResource(), start, size);
+    mFrameNumbers[frameIndex] = Graphic::Get().GetCurrentFrameNumber();
+}
+
+const uint8_t* GPUReadbackBuffer::Map()
+{
+    Assert(!mMapped); // Tried to map twice
+
+    if (!HasReadableData())
+    {
+        return nullptr;
+    }
+
+    const uint64_t start = static_cast<uint64_t>(mSize) * Graphic::Get().GetCurrentFrameIndex();
+    const CD3DX12_RANGE range(start, start + mSize);
+
+    uint8_t* data = nullptr;
+    HRESULT hr = mResource->Map(0, &range, reinterpret_cast<void**>(&data));
+    Assert(SUCCEEDED(hr));
+
+    mMapped = true;
+    return data + start;
+}
+
+void GPUReadbackBuffer::Unmap()
+{
+    Assert(mMapped); // Tried to unmap without mapping
+
+    // Nothing has been written by the CPU
+    const CD3DX12_RANGE range(0, 0);
+    mResource->Unmap(0, &range);
+
+    mMapped = false;
+}
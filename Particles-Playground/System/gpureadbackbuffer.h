@@ -0,0 +1,43 @@
+#pragma once
+#include "System/graphic.h"
+
+class CommandList;
+class GPUBuffer;
+
+// Buffer placed in a readback heap. Every frame in flight owns a separate region, so data copied during a frame
+// can be safely read on the CPU once the same frame index comes around again (after Graphic waited on its fence)
+class GPUReadbackBuffer
+{
+public:
+    explicit GPUReadbackBuffer(uint32_t size);
+    ~GPUReadbackBuffer();
+
+    GPUReadbackBuffer(const GPUReadbackBuffer&) = delete;
+    GPUReadbackBuffer& operator=(const GPUReadbackBuffer&) = delete;
+
+    GPUReadbackBuffer(GPUReadbackBuffer&&) = delete;
+    GPUReadbackBuffer& operator=(GPUReadbackBuffer&&) = delete;
+
+    // Copies data into the region of the current frame, source buffer has to be in a copy source state
+    void CopyFrom(CommandList& cmdList, GPUBuffer& buffer, uint32_t start, uint32_t size);
+
+    // Returns data that was copied the last time the current frame index was used or nullptr if there is nothing to read yet
+    const uint8_t* Map();
+    void Unmap();
+
+    // Frame number in which the currently readable data has been copied
+    inline uint64_t GetReadableFrameNumber() const { return mFrameNumbers[Graphic::Get().GetCurrentFrameIndex()]; }
+    inline bool HasReadableData() const { return mFrameNumbers[Graphic::Get().GetCurrentFrameIndex()] != InvalidFrameNumber; }
+    inline uint32_t GetSize() const { return mSize; }
+
+    inline void SetDebugName(std::wstring_view name) { mResource->SetName(name.data()); }
+
+private:
+    static const uint64_t InvalidFrameNumber = std::numeric_limits<uint64_t>::max();
+
+    ID3D12Resource* mResource = nullptr;
+    uint32_t mSize = 0;
+    std::array<uint64_t, Graphic::GetFrameCount()> mFrameNumbers;
+    bool mMapped = false;
+
+};
@@ -2,6 +2,7 @@
 #include "System/window.h"
 #include "System/cpudescriptorheap.h"
 #include "System/gpudescriptorheap.h"
+#include "System/commandlistpool.h"
 
 Graphic::~Graphic() = default;
 Graphic::Graphic() = default;
@@ -71,18 +72,8 @@ bool Graphic::Startup()
 
     if (!CreateSwapChain()) { return false; }
 
-    for (ID3D12CommandAllocator*& allocator : mDirectCommandAllocator)
-    {
-        if (FAILED(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))) { return false; }
-    }
-    for (ID3D12CommandAllocator*& allocator : mComputeCommandAllocator)
-    {
-        if (FAILED(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&allocator)))) { return false; }
-    }
-    for (ID3D12CommandAllocator*& allocator : mCopyCommandAllocator)
-    {
-        if (FAILED(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)))) { return false; }
-    }
+    // Command lists and their allocators are created on the first use
+    mCommandListPool = std::make_unique<CommandListPool>();
 
     for (upFence& fence : mFences)
     {
@@ -108,9 +99,7 @@ bool Graphic::Shutdown()
 {
     for (upFence& fence : mFences) { fence.reset(); }
 
-    for (ID3D12CommandAllocator* allocator : mDirectCommandAllocator) { allocator->Release(); }
-    for (ID3D12CommandAllocator* allocator : mComputeCommandAllocator) { allocator->Release(); }
-    for (ID3D12CommandAllocator* allocator : mCopyCommandAllocator) { allocator->Release(); }
+    if (mCommandListPool) { mCommandListPool.reset(); }
 
     if (mDefaultDrawCommandSignature) { mDefaultDrawCommandSignature->Release(); }
     if (mDefaultDispatchCommandSignature) { mDefaultDispatchCommandSignature->Release(); }
@@ -149,14 +138,7 @@ void Graphic::PreUpdate()
 {
     Graphic::Get().GetCurrentFence()->WaitOnCPU();
 
-    ID3D12CommandAllocator* allocator = Graphic::Get().GetCurrentCommandAllocator(QueueType::Copy);
-    allocator->Reset();
-
-    allocator = Graphic::Get().GetCurrentCommandAllocator(QueueType::Compute);
-    allocator->Reset();
-
-    allocator = Graphic::Get().GetCurrentCommandAllocator(QueueType::Direct);
-    allocator->Reset();
+    mCommandListPool->Reset(GetCurrentFrameIndex());
 
     mGPUDescriptorHeapCBV->ReleaseUnusedDescriptorHandles();
 }
@@ -164,7 +146,7 @@ void Graphic::PreUpdate()
 void Graphic::PostUpdate()
 {
     Graphic::Get().GetCurrentFence()->Signal(QueueType::Direct);
-    mSwapChain->Present(1, 0);
+    mSwapChain->Present(mVSync ? 1 : 0, 0);
     mCurrentFrameIdx = mSwapChain->GetCurrentBackBufferIndex();
     ++mCurrentFrameNumber;
 }
@@ -184,26 +166,6 @@ ID3D12CommandQueue* Graphic::GetQueue(QueueType type) const
     }
 }
 
-ID3D12CommandAllocator* Graphic::GetCommandAllocator(QueueType type, uint32_t index) const
-{
-    switch (type)
-    {
-    case QueueType::Direct:
-        return mDirectCommandAllocator[index];
-    case QueueType::Compute:
-        return mComputeCommandAllocator[index];
-    case QueueType::Copy:
-        return mCopyCommandAllocator[index];
-    default:
-        return nullptr;
-    }
-}
-
-ID3D12CommandAllocator* Graphic::GetCurrentCommandAllocator(QueueType type) const
-{
-    return GetCommandAllocator(type, GetCurrentFrameIndex());
-}
-
 CD3DX12_CPU_DESCRIPTOR_HANDLE Graphic::GetCurrentRenderTargetHandle()
 {
     return CD3DX12_CPU_DESCRIPTOR_HANDLE(mSwapChainDescHeap->GetCPUDescriptorHandleForHeapStart(), GetCurrentFrameIndex(), GetRTVHandleSize());
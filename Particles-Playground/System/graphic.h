@@ -3,6 +3,7 @@
 #include "WinPixEventRuntime/pix3.h"
 
 class CPUDescriptorHeap;
+class CommandListPool;
 class GPUDescriptorHeap;
 enum class ShaderType;
 
@@ -40,14 +41,14 @@ public:
     void PreUpdate();
     void PostUpdate();
     ID3D12CommandQueue* GetQueue(QueueType type) const;
-    ID3D12CommandAllocator* GetCommandAllocator(QueueType type, uint32_t index) const;
-    ID3D12CommandAllocator* GetCurrentCommandAllocator(QueueType type) const;
     CD3DX12_CPU_DESCRIPTOR_HANDLE GetCurrentRenderTargetHandle();
     uint32_t GetHandleSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const;
 
     CPUDescriptorHeap* GetCPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
     GPUDescriptorHeap* GetGPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type);
 
+    inline CommandListPool* GetCommandListPool() const { return mCommandListPool.get(); }
+
     inline ID3D12Device* GetDevice() const { return mDevice; }
     inline ID3D12CommandQueue* GetDirectQueue() const { return mDirectQueue; }
     inline ID3D12CommandQueue* GetComputeQueue() const { return mComputeQueue; }
@@ -74,6 +75,10 @@ public:
 #endif
     }
 
+    // Without vsync frames are presented right away, so frame time follows the GPU once it is the bottleneck
+    inline void SetVSync(bool enabled) { mVSync = enabled; }
+    inline bool GetVSync() const { return mVSync; }
+
     static D3D12_COMMAND_LIST_TYPE GetCommandListType(QueueType type);
     static constexpr uint32_t GetFrameCount() { return mFrameCount; }
 
@@ -90,6 +95,7 @@ private:
     uint32_t mCBVHandleSize = 0;
     uint32_t mCurrentFrameIdx = 0;
     uint64_t mCurrentFrameNumber = 0;
+    bool mVSync = true;
     D3D_SHADER_MODEL mHighestShaderModel = D3D_SHADER_MODEL_5_1;
     D3D12_FEATURE_DATA_D3D12_OPTIONS mDX12Options = {};
 
@@ -111,9 +117,7 @@ private:
     std::unique_ptr<CPUDescriptorHeap> mCPUDescriptorHeapRTV;
     std::unique_ptr<CPUDescriptorHeap> mCPUDescriptorHeapDSV;
 
-    std::array<ID3D12CommandAllocator*, mFrameCount> mDirectCommandAllocator;
-    std::array<ID3D12CommandAllocator*, mFrameCount> mComputeCommandAllocator;
-    std::array<ID3D12CommandAllocator*, mFrameCount> mCopyCommandAllocator;
+    std::unique_ptr<CommandListPool> mCommandListPool;
     std::array<ID3D12Resource*, mFrameCount> mRenderTargets;
     std::array<upFence, mFrameCount> mFences;
 
@@ -32,9 +32,9 @@ void MeshManager::Bind(CommandList& cmdList, MeshType type) const
 {
     const MeshResource& mesh = mMeshes[static_cast<uint32_t>(type)];
     Assert(mesh.VertexBuffer);
-    cmdList->IASetVertexBuffers(0, 1, &mesh.VertexBufferView);
-    cmdList->IASetPrimitiveTopology(mesh.Topology);
-    cmdList->IASetIndexBuffer(&mesh.IndexBufferView);
+    cmdList.IASetVertexBuffers(0, 1, &mesh.VertexBufferView);
+    cmdList.IASetPrimitiveTopology(mesh.Topology);
+    cmdList.IASetIndexBuffer(&mesh.IndexBufferView);
 }
 
 void MeshManager::Draw(CommandList& cmdList, MeshType type, uint32_t instanceCount) const
@@ -105,24 +105,24 @@ GraphicPipelineState& GraphicPipelineState::SetViewportProperties(uint32_t idx,
     return *this;
 }
 
-void GraphicPipelineState::Bind(CommandList& commandList, ShaderParametersLayout& layout)
+void GraphicPipelineState::Bind(CommandList& commandList, const ShaderParametersLayout& layout)
 {
     PSOManager& psoManager = PSOManager::Get();
 
     // Get and set root signature based on shader parameters layout
     ID3D12RootSignature* rootSig = psoManager.CompileShaderParameterLayout(layout);
-    commandList->SetGraphicsRootSignature(rootSig);
+    commandList.SetGraphicsRootSignature(rootSig);
 
     // Update state's sturcture with a proper root signature
     mState.pRootSignature = rootSig;
 
     // Get and set pipeline state based on provided parameters
     ID3D12PipelineState* pso = PSOManager::Get().CompilePipelineState(*this);
-    commandList->SetPipelineState(pso);
+    commandList.SetPipelineState(pso);
 
     // Set viewports' properties
-    commandList->RSSetViewports(mState.NumRenderTargets, mViewports.data());
-    commandList->RSSetScissorRects(mState.NumRenderTargets, mScissorRects.data());
+    commandList.RSSetViewports(mState.NumRenderTargets, mViewports.data());
+    commandList.RSSetScissorRects(mState.NumRenderTargets, mScissorRects.data());
 
 }
 
@@ -139,18 +139,18 @@ ComputePipelineState& ComputePipelineState::SetCS(ShaderHandle handle)
     return *this;
 }
 
-void ComputePipelineState::Bind(CommandList& commandList, ShaderParametersLayout& layout)
+void ComputePipelineState::Bind(CommandList& commandList, const ShaderParametersLayout& layout)
 {
     PSOManager& psoManager = PSOManager::Get();
 
     // Get and set root signature based on shader parameters layout
     ID3D12RootSignature* rootSig = psoManager.CompileShaderParameterLayout(layout);
-    commandList->SetComputeRootSignature(rootSig);
+    commandList.SetComputeRootSignature(rootSig);
 
     // Update state's structure with a proper root signature
     mState.pRootSignature = rootSig;
 
     // Get and set pipeline state based on provided parameters
     ID3D12PipelineState* pso = PSOManager::Get().CompilePipelineState(*this);
-    commandList->SetPipelineState(pso);
+    commandList.SetPipelineState(pso);
 }
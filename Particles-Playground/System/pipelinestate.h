@@ -55,7 +55,7 @@ public:
     GraphicPipelineState& SetRTBlendState(uint32_t idx, const D3D12_RENDER_TARGET_BLEND_DESC& blend);
     GraphicPipelineState& SetIndependentBlend(bool enable);
     GraphicPipelineState& SetViewportProperties(uint32_t idx, const CD3DX12_VIEWPORT& properties);
-    void Bind(CommandList& commandList, ShaderParametersLayout& layout);
+    void Bind(CommandList& commandList, const ShaderParametersLayout& layout);
 
 private:
     std::array<CD3DX12_VIEWPORT, 8> mViewports;
@@ -69,7 +69,7 @@ public:
     ComputePipelineState();
 
     ComputePipelineState& SetCS(ShaderHandle handle);
-    void Bind(CommandList& commandList, ShaderParametersLayout& layout);
+    void Bind(CommandList& commandList, const ShaderParametersLayout& layout);
 
 };
 
@@ -22,19 +22,68 @@ bool PSOManager::Startup()
 
 bool PSOManager::Shutdown()
 {
-    for (auto& [key, pso] : mCachedPipelineStates)
+    for (auto& [key, cachedPso] : mCachedPipelineStates)
     {
-        pso->Release();
+        cachedPso.PipelineState->Release();
     }
+    mCachedPipelineStates.clear();
+
+    for (RetiredPipelineState& retiredPso : mRetiredPipelineStates)
+    {
+        retiredPso.PipelineState->Release();
+    }
+    mRetiredPipelineStates.clear();
+
+    for (auto& [key, commandSig] : mCachedCommandSignatures)
+    {
+        commandSig->Release();
+    }
+    mCachedCommandSignatures.clear();
 
     for (auto& [type, rootSig] : mCachedRootSignatures)
     {
         rootSig->Release();
     }
+    mCachedRootSignatures.clear();
 
     return true;
 }
 
+void PSOManager::PreUpdate()
+{
+    const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
+    const uint32_t frameCount = Graphic::Get().GetFrameCount();
+
+    auto retiredEnd = std::remove_if(mRetiredPipelineStates.begin(), mRetiredPipelineStates.end(), [currentFrameNum, frameCount](RetiredPipelineState& retiredPso) {
+        if (retiredPso.FrameNumber + frameCount > currentFrameNum)
+        {
+            return false;
+        }
+
+        retiredPso.PipelineState->Release();
+        return true;
+        });
+    mRetiredPipelineStates.erase(retiredEnd, mRetiredPipelineStates.end());
+}
+
+void PSOManager::RetirePipelineStates(const void* bytecode)
+{
+    const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
+
+    for (auto psoIt = mCachedPipelineStates.begin(); psoIt != mCachedPipelineStates.end();)
+    {
+        const std::array<const void*, 2>& psoBytecode = psoIt->second.Bytecode;
+        if (std::find(psoBytecode.begin(), psoBytecode.end(), bytecode) == psoBytecode.end())
+        {
+            ++psoIt;
+            continue;
+        }
+
+        mRetiredPipelineStates.push_back({ psoIt->second.PipelineState, currentFrameNum });
+        psoIt = mCachedPipelineStates.erase(psoIt);
+    }
+}
+
 template<typename PipelineState>
 ID3D12PipelineState* PSOManager::CompilePipelineState(const PipelineState& pipelineState)
 {
@@ -43,12 +92,12 @@ ID3D12PipelineState* PSOManager::CompilePipelineState(const PipelineState& pipel
 
     if (psoIt != mCachedPipelineStates.end())
     {
-        return psoIt->second;
+        return psoIt->second.PipelineState;
     }
 
     ID3D12PipelineState* pso = CreatePipelineState(pipelineState);
 
-    mCachedPipelineStates[key] = pso;
+    mCachedPipelineStates[key] = { pso, GetBytecode(pipelineState) };
     return pso;
 }
 
@@ -95,10 +144,64 @@ ID3D12RootSignature* PSOManager::CompileShaderParameterLayout(const ShaderParame
     Assert(SUCCEEDED(hr));
     blob->Release();
 
+    OutputDebugMessage("Root Signature: %u parameters, %u DWORDs\n", static_cast<uint32_t>(params.Parameters.size()), layout.GetRootSignatureCost());
+
     mCachedRootSignatures[key] = rootSig;
     return rootSig;
 }
 
+ID3D12CommandSignature* PSOManager::CompileCommandSignature(const ShaderParametersLayout& layout, const std::vector<D3D12_INDIRECT_ARGUMENT_DESC>& arguments, uint32_t byteStride)
+{
+    static_assert(sizeof(D3D12_INDIRECT_ARGUMENT_DESC) % sizeof(uint32_t) == 0);
+
+    const uint32_t* argsStart = reinterpret_cast<const uint32_t*>(arguments.data());
+    const uint32_t* argsEnd = reinterpret_cast<const uint32_t*>(arguments.data() + arguments.size());
+
+    std::array<uint32_t, 3> keyData = { layout.Hash(), byteStride, HashRange(argsStart, argsEnd) };
+    const uint32_t key = HashRange(keyData.data(), keyData.data() + keyData.size());
+    auto commandSigIt = mCachedCommandSignatures.find(key);
+
+    if (commandSigIt != mCachedCommandSignatures.end())
+    {
+        return commandSigIt->second;
+    }
+
+    // Root signature is required only if the command signature changes root arguments
+    const bool changesRootArguments = std::any_of(arguments.begin(), arguments.end(), [](const D3D12_INDIRECT_ARGUMENT_DESC& argument) {
+        return argument.Type != D3D12_INDIRECT_ARGUMENT_TYPE_DRAW && argument.Type != D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED && argument.Type != D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+        });
+
+    ID3D12RootSignature* rootSig = changesRootArguments ? CompileShaderParameterLayout(layout) : nullptr;
+
+    // Arguments refer to parameters by the layout's indices, they are moved to their place in the compiled root signature
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC> rootArguments = arguments;
+    for (D3D12_INDIRECT_ARGUMENT_DESC& argument : rootArguments)
+    {
+        switch (argument.Type)
+        {
+            case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT: { argument.Constant.RootParameterIndex = layout.GetRootParameterLocation(argument.Constant.RootParameterIndex).RootIndex; break; }
+            case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW: { argument.ConstantBufferView.RootParameterIndex = layout.GetRootParameterLocation(argument.ConstantBufferView.RootParameterIndex).RootIndex; break; }
+            case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW: { argument.ShaderResourceView.RootParameterIndex = layout.GetRootParameterLocation(argument.ShaderResourceView.RootParameterIndex).RootIndex; break; }
+            case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW: { argument.UnorderedAccessView.RootParameterIndex = layout.GetRootParameterLocation(argument.UnorderedAccessView.RootParameterIndex).RootIndex; break; }
+            default: { break; }
+        }
+    }
+
+    D3D12_COMMAND_SIGNATURE_DESC desc{};
+    desc.pArgumentDescs = rootArguments.data();
+    desc.NumArgumentDescs = static_cast<uint32_t>(rootArguments.size());
+    desc.ByteStride = byteStride;
+
+    ID3D12Device* device = Graphic::Get().GetDevice();
+
+    ID3D12CommandSignature* commandSig = nullptr;
+    HRESULT hr = device->CreateCommandSignature(&desc, rootSig, IID_PPV_ARGS(&commandSig));
+    Assert(SUCCEEDED(hr));
+
+    mCachedCommandSignatures[key] = commandSig;
+    return commandSig;
+}
+
 ID3D12PipelineState* PSOManager::CreatePipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
 {
     ID3D12Device* device = Graphic::Get().GetDevice();
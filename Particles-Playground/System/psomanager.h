@@ -22,6 +22,9 @@ public:
     bool Startup();
     bool Shutdown();
 
+    // Releases pipeline states retired at least frame count frames ago
+    void PreUpdate();
+
     static PSOManager& Get()
     {
         static PSOManager* instance = new PSOManager();
@@ -31,16 +34,38 @@ public:
     template<typename PipelineState>
     ID3D12PipelineState* CompilePipelineState(const PipelineState& pipelineState);
     ID3D12RootSignature* CompileShaderParameterLayout(const ShaderParametersLayout& layout);
+    ID3D12CommandSignature* CompileCommandSignature(const ShaderParametersLayout& layout, const std::vector<D3D12_INDIRECT_ARGUMENT_DESC>& arguments, uint32_t byteStride);
+
+    // Pipeline states are cached by bytecode address, ones built from given bytecode are dropped from the cache right away,
+    // so the address can be reused by a new shader, and released once frames which may use them are done
+    void RetirePipelineStates(const void* bytecode);
 
 private:
+    struct CachedPipelineState
+    {
+        ID3D12PipelineState* PipelineState = nullptr;
+        std::array<const void*, 2> Bytecode = {};
+    };
+
+    struct RetiredPipelineState
+    {
+        ID3D12PipelineState* PipelineState = nullptr;
+        uint64_t FrameNumber = 0;
+    };
+
     explicit PSOManager() = default;
 
+    static std::array<const void*, 2> GetBytecode(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) { return { desc.VS.pShaderBytecode, desc.PS.pShaderBytecode }; }
+    static std::array<const void*, 2> GetBytecode(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) { return { desc.CS.pShaderBytecode, nullptr }; }
+
     ID3D12PipelineState* CreatePipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
     ID3D12PipelineState* CreatePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
 
     D3D_ROOT_SIGNATURE_VERSION mRootSigVer = D3D_ROOT_SIGNATURE_VERSION_1_1;
     std::map<uint32_t, ID3D12RootSignature*> mCachedRootSignatures;
-    std::map<uint32_t, ID3D12PipelineState*> mCachedPipelineStates;
+    std::map<uint32_t, CachedPipelineState> mCachedPipelineStates;
+    std::vector<RetiredPipelineState> mRetiredPipelineStates;
+    std::map<uint32_t, ID3D12CommandSignature*> mCachedCommandSignatures;
 
 };
 
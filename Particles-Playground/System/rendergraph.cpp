@@ -40,7 +40,7 @@ void RenderGraph::Execute(TransientResourceAllocator& allocator, SceneData& scen
     CommandList commandList(QueueType::Direct);
 
     std::array<ID3D12DescriptorHeap*, 1> descHeaps = { Graphic::Get().GetGPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->GetHeap() };
-    commandList->SetDescriptorHeaps(static_cast<uint32_t>(descHeaps.size()), descHeaps.data());
+    commandList.SetDescriptorHeaps(static_cast<uint32_t>(descHeaps.size()), descHeaps.data());
 
     std::map<ResourceID, TransientResourceHandle> resources;
     std::map<ResourceID, ResourceID> availableAliases;
@@ -67,6 +67,8 @@ void RenderGraph::Execute(TransientResourceAllocator& allocator, SceneData& scen
     }
 
     commandList.Submit();
+
+    mCommandListStats = commandList.GetStats();
 }
 
 std::vector<RGSetupContext> RenderGraph::GatherSetupContexts() const
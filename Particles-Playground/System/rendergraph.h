@@ -1,5 +1,6 @@
 #pragma once
 #include "System/rendergraphcommon.h"
+#include "System/commandlist.h"
 #include "System/dependencygraph.h"
 #include "Utilities/debug.h"
 #include "System/transientresourceallocator.h"
@@ -36,6 +37,9 @@ public:
     inline void AddExternalGPUBuffer(ResourceID id, GPUBuffer* buffer) { mExternalGPUBuffers[id] = buffer; }
     inline void AddExternalTexture2D(ResourceID id, Texture2D* texture) { mExternalTextures2D[id] = texture; }
 
+    // Calls issued and filtered out by the command list during the last Execute
+    inline const CommandListStats& GetCommandListStats() const { return mCommandListStats; }
+
 private:
     // Setup
     std::vector<RGSetupContext> GatherSetupContexts() const;
@@ -60,4 +64,6 @@ private:
 
     std::map<ResourceID, GPUBuffer*> mExternalGPUBuffers;
     std::map<ResourceID, Texture2D*> mExternalTextures2D;
+
+    CommandListStats mCommandListStats;
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include "Utilities/objectpool.h"
+#include "System/shaderparameterslayout.h"
 
 enum class ShaderType
 {
@@ -8,13 +9,52 @@ enum class ShaderType
     Compute
 };
 
+enum class ShaderBindingType
+{
+    ConstantBuffer = 0,
+    SRV,
+    UAV,
+    Sampler
+};
+
+// Resource declared by the shader, taken from DXC reflection
+struct ShaderBinding
+{
+    ShaderBindingType Type = ShaderBindingType::ConstantBuffer;
+    ParameterResource Resource = ParameterResource::Any;
+    uint32_t Register = 0;
+    uint32_t Space = 0;
+    uint32_t Size = 0; // Constant buffers only, in bytes
+    std::string Name;
+};
+
+struct ShaderReflection
+{
+    std::vector<ShaderBinding> Bindings;
+    bool UsesResourceDescriptorHeap = false;
+};
+
+// Everything needed to compile the shader again, includes are file names the shader depends on besides its own file.
+// Parameters are names of resources the caller binds by index, in that order, new versions of the shader have to match them.
+struct ShaderSource
+{
+    std::wstring Entry;
+    std::vector<std::pair<std::string, std::string>> Tokens;
+    std::vector<std::string> Parameters;
+    std::vector<std::wstring> Includes;
+    size_t PreprocessedHash = 0;
+};
+
 class Shader : public IObject<Shader>
 {
 public:
-    Shader(std::wstring_view name, ShaderType type, IDxcBlob* blob)
+    Shader(std::wstring_view name, ShaderType type, ShaderSource source, IDxcBlob* blob, ShaderReflection reflection, ShaderParametersLayout layout)
         : mName(name)
         , mType(type)
+        , mSource(std::move(source))
         , mBlob(blob)
+        , mReflection(std::move(reflection))
+        , mLayout(std::move(layout))
     { }
 
     ~Shader()
@@ -25,10 +65,28 @@ public:
     inline IDxcBlob* GetBlob() const { return mBlob; }
     inline ShaderType GetType() const { return mType; }
     inline std::wstring_view GetName() const { return mName; }
+    inline const ShaderReflection& GetReflection() const { return mReflection; }
+    inline const ShaderParametersLayout& GetParametersLayout() const { return mLayout; }
+    inline const ShaderSource& GetSource() const { return mSource; }
+
+    inline void SetIncludes(std::vector<std::wstring> includes) { mSource.Includes = std::move(includes); }
+
+    // Handle stays the same, so users pick up the new code the next time they build a pipeline state. Returns the old blob.
+    [[nodiscard]] IDxcBlob* Reload(size_t preprocessedHash, IDxcBlob* blob, ShaderReflection reflection, ShaderParametersLayout layout)
+    {
+        mSource.PreprocessedHash = preprocessedHash;
+        mReflection = std::move(reflection);
+        mLayout = std::move(layout);
+        return std::exchange(mBlob, blob);
+    }
+
 private:
     std::wstring mName;
     ShaderType mType;
+    ShaderSource mSource;
     IDxcBlob* mBlob = nullptr;
+    ShaderReflection mReflection;
+    ShaderParametersLayout mLayout;
 };
 
 using ShaderHandle = ObjectHandle<Shader>;
@@ -2,15 +2,84 @@
 #include "Utilities/debug.h"
 #include "Utilities/string.h"
 #include "System/graphic.h"
+#include "System/sampler.h"
+#include "System/psomanager.h"
+#include "Utilities/memory.h"
+#include "Shaders/bindlesscommon.hlsli"
+#include <d3d12shader.h>
 
 const std::wstring SHADER_SOURCE_FOLDER = L"Shaders/";
 
+static std::wstring GetShaderPath(std::wstring_view shaderName)
+{
+    return SHADER_SOURCE_FOLDER + std::wstring(shaderName) + L".hlsl";
+}
+
+// All shaders live in a single folder, so dependencies are tracked by lowercase file names
+static std::wstring GetShaderFileName(std::wstring_view path)
+{
+    const size_t separator = path.find_last_of(L"/\\");
+    std::wstring fileName(separator == std::wstring_view::npos ? path : path.substr(separator + 1));
+    CharLowerBuffW(fileName.data(), static_cast<DWORD>(fileName.size()));
+    return fileName;
+}
+
+static std::array<DxcDefine, 1> GetShaderDefines()
+{
+    return { DxcDefine{ L"ENABLE_RESOURCE_DESCRIPTOR_HEAP", Graphic::Get().SupportsResourceDescriptorHeap() ? L"1" : L"0" } };
+}
+
+// Forwards to DXC's default include handler and remembers every file opened through it
+class ShaderIncludeHandler : public IDxcIncludeHandler
+{
+public:
+    ShaderIncludeHandler(IDxcIncludeHandler* defaultHandler)
+        : mDefaultHandler(defaultHandler)
+    { }
+
+    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR filename, IDxcBlob** includeSource) override
+    {
+        std::wstring fileName = GetShaderFileName(filename);
+        if (std::find(mIncludes.begin(), mIncludes.end(), fileName) == mIncludes.end())
+        {
+            mIncludes.push_back(std::move(fileName));
+        }
+
+        return mDefaultHandler->LoadSource(filename, includeSource);
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+    {
+        if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+        {
+            *object = this;
+            return S_OK;
+        }
+
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    // Lifetime is managed by the ShaderManager
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+    inline std::vector<std::wstring> TakeIncludes() { return std::exchange(mIncludes, {}); }
+
+private:
+    IDxcIncludeHandler* mDefaultHandler = nullptr;
+    std::vector<std::wstring> mIncludes;
+};
+
 ShaderHandle VS_Screen;
 ShaderHandle PS_Screen;
 ShaderHandle VS_DrawParticle;
 ShaderHandle PS_DrawParticle;
-ShaderHandle CS_ResetFreeIndices;
+ShaderHandle CS_RelocateParticles;
 ShaderHandle CS_EmitterUpdate;
+ShaderHandle CS_PrepareDraw;
+ShaderHandle CS_BuildSortKeys;
+ShaderHandle CS_BitonicSort;
 
 bool ShaderManager::Startup()
 {
@@ -23,17 +92,34 @@ bool ShaderManager::Startup()
 
     if (FAILED(DxcCreateInstance(CLSID_DxcLibrary, IID_PPV_ARGS(&mLibrary)))) { return false; }
     if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&mCompiler)))) { return false; }
+    if (FAILED(DxcCreateInstance(CLSID_DxcContainerReflection, IID_PPV_ARGS(&mContainerReflection)))) { return false; }
 
     if (FAILED(mLibrary->CreateIncludeHandler(&mIncludeHandler))) { return false; }
+    mTrackingIncludeHandler = new ShaderIncludeHandler(mIncludeHandler);
 
     mShadersPool.Init();
 
+    // Parameters are listed in the order render nodes bind them
+    const ShaderParameterNames screenParameters = { "Texture" };
+    const ShaderParameterNames drawParticleParameters = { "Constants", "Camera", "Data", "Indices" };
+
     VS_Screen = CompileShader(L"vsscreen", ShaderType::Vertex).GetHandle();
-    PS_Screen = CompileShader(L"psscreen", ShaderType::Pixel).GetHandle();
-    VS_DrawParticle = CompileShader(L"vsdefault", ShaderType::Vertex).GetHandle();
+    PS_Screen = CompileShader(L"psscreen", ShaderType::Pixel, L"main", {}, screenParameters).GetHandle();
+    VS_DrawParticle = CompileShader(L"vsdefault", ShaderType::Vertex, L"main", {}, drawParticleParameters).GetHandle();
     PS_DrawParticle = CompileShader(L"psdefault", ShaderType::Pixel).GetHandle();
-    CS_ResetFreeIndices = CompileShader(L"resetfreeindices", ShaderType::Compute).GetHandle();
-    CS_EmitterUpdate = CompileShader(L"emitterupdate", ShaderType::Compute).GetHandle();
+    CS_RelocateParticles = CompileShader(L"relocateparticles", ShaderType::Compute, L"main", {}, { "Constants", "Particles", "FreeList" }).GetHandle();
+    CS_EmitterUpdate = CompileShader(L"emitterupdate", ShaderType::Compute, L"main", {}, { "Constants", "EmitterConstant", "EmitterIndexBuffer", "EmitterStatus", "DrawIndirectBuffer", "SpawnIndirectBuffer", "SpawnGroupTable" }).GetHandle();
+    CS_PrepareDraw = CompileShader(L"preparedraw", ShaderType::Compute, L"main", {}, { "Constants", "EmitterConstant", "EmitterIndexBuffer", "DrawIndirectBuffer", "SortCount", "DrawCommands", "DrawCount" }).GetHandle();
+    CS_BuildSortKeys = CompileShader(L"buildsortkeys", ShaderType::Compute, L"main", {}, { "Constants", "Camera", "EmitterConstant", "Particles", "Indices", "DrawIndirectArgs", "SortKeys", "SortValues", "SortCount" }).GetHandle();
+    CS_BitonicSort = CompileShader(L"bitonicsort", ShaderType::Compute, L"main", {}, { "Constants", "SortCount", "SortKeys", "SortValues" }).GetHandle();
+
+    // Pixel shaders of both pairs don't add parameters of their own
+    Assert(GetShaderParametersLayout(VS_Screen, PS_Screen).HasParameters(screenParameters));
+    Assert(GetShaderParametersLayout(VS_DrawParticle, PS_DrawParticle).HasParameters(drawParticleParameters));
+
+    // Missing notifications only turn off reloading
+    mShadersChangeHandle = FindFirstChangeNotification(SHADER_SOURCE_FOLDER.data(), false, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    UpdateShaderFileTimes();
 
     return true;
 }
@@ -44,12 +130,33 @@ bool ShaderManager::Shutdown()
     FreeShader(PS_Screen);
     FreeShader(VS_DrawParticle);
     FreeShader(PS_DrawParticle);
-    FreeShader(CS_ResetFreeIndices);
+    FreeShader(CS_RelocateParticles);
     FreeShader(CS_EmitterUpdate);
+    FreeShader(CS_PrepareDraw);
+    FreeShader(CS_BuildSortKeys);
+    FreeShader(CS_BitonicSort);
 
     mShadersPool.Free();
+    mGraphicsLayouts.clear();
+
+    for (RetiredBlob& retiredBlob : mRetiredBlobs)
+    {
+        retiredBlob.Blob->Release();
+    }
+    mRetiredBlobs.clear();
+
+    if (mShadersChangeHandle != INVALID_HANDLE_VALUE)
+    {
+        FindCloseChangeNotification(mShadersChangeHandle);
+        mShadersChangeHandle = INVALID_HANDLE_VALUE;
+    }
+    mShaderFileTimes.clear();
+
+    delete mTrackingIncludeHandler;
+    mTrackingIncludeHandler = nullptr;
 
     mIncludeHandler->Release();
+    mContainerReflection->Release();
 
     mLibrary->Release();
     mCompiler->Release();
@@ -59,23 +166,276 @@ bool ShaderManager::Shutdown()
     return true;
 }
 
-ShaderCompilationResult ShaderManager::CompileShader(std::wstring_view shaderName, ShaderType type, std::wstring_view entry, ShaderTokens tokens)
+ShaderCompilationResult ShaderManager::CompileShader(std::wstring_view shaderName, ShaderType type, std::wstring_view entry, ShaderTokens tokens, ShaderParameterNames parameters)
 {
     Assert(shaderName.size());
 
-    const std::wstring shaderPath = SHADER_SOURCE_FOLDER + shaderName.data() + L".hlsl";
-
-    std::string sourceCode;
-    if (!GetSourceCode(shaderPath, sourceCode)) { return ShaderCompilationResult("Can't find a shader file"); }
+    const std::wstring shaderPath = GetShaderPath(shaderName);
 
-    ApplyTokens(tokens, shaderPath, sourceCode);
+    // Source is kept, so the shader can be compiled again when one of its files changes
+    ShaderSource source;
+    source.Entry = entry;
+    for (const ShaderToken& token : tokens)
+    {
+        source.Tokens.push_back({ std::string(token.first), std::string(token.second) });
+    }
+    source.Parameters = std::move(parameters);
 
+    std::string preprocessedCode;
     std::string errorMsg;
-    IDxcBlob* shaderBlob = CompileShader(sourceCode, type, entry, shaderPath, errorMsg);
+    if (!PreprocessShader(shaderPath, tokens, preprocessedCode, source.Includes, errorMsg)) { return ShaderCompilationResult(std::move(errorMsg)); }
+
+    source.PreprocessedHash = std::hash<std::string>{}(preprocessedCode);
+
+    IDxcBlob* shaderBlob = CompileShader(preprocessedCode, type, entry, shaderPath, errorMsg);
 
     if (!shaderBlob) { return ShaderCompilationResult(std::move(errorMsg)); }
 
-    return ShaderCompilationResult(mShadersPool.AllocateObject(shaderName, type, shaderBlob));
+    ShaderReflection reflection;
+    if (!ReflectShader(shaderBlob, reflection))
+    {
+        shaderBlob->Release();
+        return ShaderCompilationResult("Can't reflect a shader");
+    }
+
+    ShaderParametersLayout layout = CreateShaderParametersLayout({ { type, &reflection } });
+
+    if (!ValidateParameters(layout, source, shaderName))
+    {
+        shaderBlob->Release();
+        return ShaderCompilationResult("Shader parameters don't match the ones bound by the caller");
+    }
+
+    return ShaderCompilationResult(mShadersPool.AllocateObject(shaderName, type, std::move(source), shaderBlob, std::move(reflection), std::move(layout)));
+}
+
+void ShaderManager::FreeShader(ShaderHandle handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(mGraphicsLayoutsLock);
+
+        // Drop layouts of all pairs the shader is part of
+        for (auto layoutIt = mGraphicsLayouts.begin(); layoutIt != mGraphicsLayouts.end();)
+        {
+            const bool usesShader = static_cast<uint32_t>(layoutIt->first >> 32) == handle.GetHandle() || static_cast<uint32_t>(layoutIt->first) == handle.GetHandle();
+            layoutIt = usesShader ? mGraphicsLayouts.erase(layoutIt) : std::next(layoutIt);
+        }
+    }
+
+    if (handle.GetHandle() != ShaderHandle::Invalid)
+    {
+        // Shader's destructor drops its own reference, bytecode lives on until pipeline states built from it are released
+        IDxcBlob* blob = GetShader(handle)->GetBlob();
+        blob->AddRef();
+        RetireBlob(blob);
+    }
+
+    mShadersPool.FreeObject(handle);
+}
+
+void ShaderManager::RetireBlob(IDxcBlob* blob)
+{
+    // Address of the bytecode can't be reused while it's still a key of cached pipeline states
+    PSOManager::Get().RetirePipelineStates(blob->GetBufferPointer());
+    mRetiredBlobs.push_back({ blob, Graphic::Get().GetCurrentFrameNumber() });
+}
+
+void ShaderManager::PreUpdate()
+{
+    const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
+    const uint32_t frameCount = Graphic::Get().GetFrameCount();
+
+    auto retiredEnd = std::remove_if(mRetiredBlobs.begin(), mRetiredBlobs.end(), [currentFrameNum, frameCount](RetiredBlob& retiredBlob) {
+        if (retiredBlob.FrameNumber + frameCount > currentFrameNum)
+        {
+            return false;
+        }
+
+        retiredBlob.Blob->Release();
+        return true;
+        });
+    mRetiredBlobs.erase(retiredEnd, mRetiredBlobs.end());
+
+    if (mShadersChangeHandle == INVALID_HANDLE_VALUE || WaitForSingleObject(mShadersChangeHandle, 0) != WAIT_OBJECT_0)
+    {
+        return;
+    }
+
+    FindNextChangeNotification(mShadersChangeHandle);
+
+    const std::vector<std::wstring> changedFiles = UpdateShaderFileTimes();
+    if (!changedFiles.empty())
+    {
+        ReloadShaders(changedFiles);
+    }
+}
+
+const ShaderParametersLayout& ShaderManager::GetShaderParametersLayout(ShaderHandle computeShader)
+{
+    const Shader* shader = GetShader(computeShader);
+    Assert(shader && shader->GetType() == ShaderType::Compute);
+
+    return shader->GetParametersLayout();
+}
+
+const ShaderParametersLayout& ShaderManager::GetShaderParametersLayout(ShaderHandle vertexShader, ShaderHandle pixelShader)
+{
+    const uint64_t key = (static_cast<uint64_t>(vertexShader.GetHandle()) << 32) | pixelShader.GetHandle();
+
+    std::lock_guard<std::mutex> lock(mGraphicsLayoutsLock);
+
+    auto layoutIt = mGraphicsLayouts.find(key);
+    if (layoutIt != mGraphicsLayouts.end())
+    {
+        return layoutIt->second;
+    }
+
+    const Shader* vs = GetShader(vertexShader);
+    const Shader* ps = GetShader(pixelShader);
+    Assert(vs && vs->GetType() == ShaderType::Vertex);
+    Assert(ps && ps->GetType() == ShaderType::Pixel);
+
+    ShaderParametersLayout layout = CreateShaderParametersLayout({ { ShaderType::Vertex, &vs->GetReflection() }, { ShaderType::Pixel, &ps->GetReflection() } });
+    return mGraphicsLayouts.emplace(key, std::move(layout)).first->second;
+}
+
+std::vector<std::wstring> ShaderManager::UpdateShaderFileTimes()
+{
+    std::vector<std::wstring> changedFiles;
+
+    WIN32_FIND_DATA findData{};
+    HANDLE findHandle = FindFirstFile((SHADER_SOURCE_FOLDER + L"*").data(), &findData);
+    if (findHandle == INVALID_HANDLE_VALUE) { return changedFiles; }
+
+    do
+    {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) { continue; }
+
+        const uint64_t writeTime = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) | findData.ftLastWriteTime.dwLowDateTime;
+
+        // Editors often write a file more than once, only files with a new time are reported
+        auto [fileIt, inserted] = mShaderFileTimes.try_emplace(GetShaderFileName(findData.cFileName), writeTime);
+        if (!inserted && fileIt->second != writeTime)
+        {
+            fileIt->second = writeTime;
+            changedFiles.push_back(fileIt->first);
+        }
+    } while (FindNextFile(findHandle, &findData));
+
+    FindClose(findHandle);
+
+    return changedFiles;
+}
+
+void ShaderManager::ReloadShaders(const std::vector<std::wstring>& changedFiles)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    uint32_t recompiled = 0;
+    uint32_t unchanged = 0;
+    uint32_t failed = 0;
+    bool graphicsReloaded = false;
+
+    for (Shader* shader : mShadersPool.GetObjectsView())
+    {
+        if (!DependsOnFiles(*shader, changedFiles)) { continue; }
+
+        const ShaderSource& source = shader->GetSource();
+        const std::wstring shaderPath = GetShaderPath(shader->GetName());
+
+        ShaderTokens tokens;
+        for (const auto& [token, value] : source.Tokens)
+        {
+            tokens.push_back({ token, value });
+        }
+
+        // Failed shaders keep their previous version, so a typo doesn't break the frame
+        std::string preprocessedCode;
+        std::vector<std::wstring> includes;
+        std::string errorMsg;
+        if (!PreprocessShader(shaderPath, tokens, preprocessedCode, includes, errorMsg))
+        {
+            ++failed;
+            continue;
+        }
+
+        shader->SetIncludes(std::move(includes));
+
+        // Changes which don't affect the shader (comments, unused code in shared includes) are skipped
+        const size_t preprocessedHash = std::hash<std::string>{}(preprocessedCode);
+        if (preprocessedHash == source.PreprocessedHash)
+        {
+            ++unchanged;
+            continue;
+        }
+
+        IDxcBlob* shaderBlob = CompileShader(preprocessedCode, shader->GetType(), source.Entry, shaderPath, errorMsg);
+        if (!shaderBlob)
+        {
+            ++failed;
+            continue;
+        }
+
+        ShaderReflection reflection;
+        if (!ReflectShader(shaderBlob, reflection))
+        {
+            shaderBlob->Release();
+            ++failed;
+            continue;
+        }
+
+        ShaderParametersLayout layout = CreateShaderParametersLayout({ { shader->GetType(), &reflection } });
+
+        // Callers keep binding the old parameters, a shader which moved them would be bound wrong
+        if (!ValidateParameters(layout, source, shader->GetName()))
+        {
+            shaderBlob->Release();
+            ++failed;
+            continue;
+        }
+
+        // Pipeline states built from the old bytecode may still be in flight, both are released after the frame latency
+        RetireBlob(shader->Reload(preprocessedHash, shaderBlob, std::move(reflection), std::move(layout)));
+
+        graphicsReloaded |= shader->GetType() != ShaderType::Compute;
+        ++recompiled;
+    }
+
+    if (graphicsReloaded)
+    {
+        std::lock_guard<std::mutex> lock(mGraphicsLayoutsLock);
+        mGraphicsLayouts.clear();
+    }
+
+    const std::chrono::duration<float, std::milli> reloadTime = std::chrono::high_resolution_clock::now() - startTime;
+    OutputDebugMessage("Shaders reloaded in %.2f ms: %u recompiled, %u unchanged, %u failed\n", reloadTime.count(), recompiled, unchanged, failed);
+}
+
+bool ShaderManager::DependsOnFiles(const Shader& shader, const std::vector<std::wstring>& files) const
+{
+    const std::wstring fileName = GetShaderFileName(GetShaderPath(shader.GetName()));
+    const std::vector<std::wstring>& includes = shader.GetSource().Includes;
+
+    return std::any_of(files.begin(), files.end(), [&](const std::wstring& file) {
+        return file == fileName || std::find(includes.begin(), includes.end(), file) != includes.end();
+        });
+}
+
+bool ShaderManager::ValidateParameters(const ShaderParametersLayout& layout, const ShaderSource& source, std::wstring_view shaderName) const
+{
+    if (source.Parameters.empty() || layout.HasParameters(source.Parameters))
+    {
+        return true;
+    }
+
+    const std::string shaderNameA = ConvertWStringToString(shaderName);
+    OutputDebugMessage("Parameters of shader %s don't match the expected ones:\n", shaderNameA.data());
+    for (uint32_t idx = 0; idx < source.Parameters.size(); ++idx)
+    {
+        OutputDebugMessage("    %u: %s found at %u\n", idx, source.Parameters[idx].data(), layout.GetParameterIndex(source.Parameters[idx]));
+    }
+
+    return false;
 }
 
 bool ShaderManager::GetSourceCode(std::wstring_view path, std::string& sourceCode)
@@ -114,20 +474,77 @@ void ShaderManager::ApplyTokens(ShaderTokens tokens, std::wstring_view shaderPat
     }
 }
 
-IDxcBlob* ShaderManager::CompileShader(std::string_view sourceCode, ShaderType type, std::wstring_view entry, std::wstring_view shaderPath, std::string& errorMsg)
+bool ShaderManager::PreprocessShader(std::wstring_view shaderPath, ShaderTokens tokens, std::string& preprocessedCode, std::vector<std::wstring>& includes, std::string& errorMsg)
 {
     errorMsg.clear();
 
+    std::string sourceCode;
+    if (!GetSourceCode(shaderPath, sourceCode))
+    {
+        errorMsg = "Can't find a shader file";
+        return false;
+    }
+
+    ApplyTokens(tokens, shaderPath, sourceCode);
+
     IDxcBlobEncoding* sourceBlob = nullptr;
     mLibrary->CreateBlobWithEncodingFromPinned(sourceCode.data(), static_cast<uint32_t>(sourceCode.size()), CP_UTF8, &sourceBlob);
 
-    std::array defines = { 
-        DxcDefine{ L"ENABLE_RESOURCE_DESCRIPTOR_HEAP", Graphic::Get().SupportsResourceDescriptorHeap() ? L"1" : L"0" }
-    };
+    const std::array defines = GetShaderDefines();
 
+    // Includes are resolved only here, so this is where shader's dependencies are collected
+    IDxcOperationResult* result = nullptr;
+    Assert(SUCCEEDED(mCompiler->Preprocess(sourceBlob, shaderPath.data(), nullptr, 0, defines.data(), static_cast<uint32_t>(defines.size()), mTrackingIncludeHandler, &result)));
+
+    includes = mTrackingIncludeHandler->TakeIncludes();
+
+    HRESULT preprocessResult;
+    result->GetStatus(&preprocessResult);
+
+    if (SUCCEEDED(preprocessResult))
+    {
+        IDxcBlob* blob = nullptr;
+        Assert(SUCCEEDED(result->GetResult(&blob)));
+
+        preprocessedCode.assign(static_cast<const char*>(blob->GetBufferPointer()), blob->GetBufferSize());
+
+        // Output may be null terminated, which is not a part of the code
+        while (!preprocessedCode.empty() && preprocessedCode.back() == '\0')
+        {
+            preprocessedCode.pop_back();
+        }
+
+        blob->Release();
+    }
+    else
+    {
+        IDxcBlobEncoding* errorsBlob = nullptr;
+        Assert(SUCCEEDED(result->GetErrorBuffer(&errorsBlob)));
+
+        errorMsg = ConvertWStringToString(shaderPath);
+        const char* error = static_cast<const char*>(errorsBlob->GetBufferPointer());
+        OutputDebugMessage("Shader preprocessing error: %s\n%s", errorMsg.data(), error);
+
+        errorsBlob->Release();
+    }
+
+    result->Release();
+    sourceBlob->Release();
+
+    return SUCCEEDED(preprocessResult);
+}
+
+IDxcBlob* ShaderManager::CompileShader(std::string_view sourceCode, ShaderType type, std::wstring_view entry, std::wstring_view shaderPath, std::string& errorMsg)
+{
+    errorMsg.clear();
+
+    IDxcBlobEncoding* sourceBlob = nullptr;
+    mLibrary->CreateBlobWithEncodingFromPinned(sourceCode.data(), static_cast<uint32_t>(sourceCode.size()), CP_UTF8, &sourceBlob);
+
+    // Source is already preprocessed, defines and includes are resolved
     IDxcOperationResult* result = nullptr;
     Assert(SUCCEEDED(mCompiler->Compile(sourceBlob, shaderPath.data(), entry.data(), GetShaderTargetProfile(type).data(), 
-        nullptr, 0, defines.data(), static_cast<uint32_t>(defines.size()), mIncludeHandler, &result)));
+        nullptr, 0, nullptr, 0, mIncludeHandler, &result)));
 
     HRESULT compilationResult;
     result->GetStatus(&compilationResult);
@@ -169,3 +586,188 @@ std::wstring_view ShaderManager::GetShaderTargetProfile(ShaderType type) const
     default: return L"";
     }
 }
+
+bool ShaderManager::ReflectShader(IDxcBlob* blob, ShaderReflection& reflection)
+{
+    uint32_t partIndex = 0;
+    if (FAILED(mContainerReflection->Load(blob))) { return false; }
+    if (FAILED(mContainerReflection->FindFirstPartKind(DXC_PART_DXIL, &partIndex))) { return false; }
+
+    ID3D12ShaderReflection* shaderReflection = nullptr;
+    if (FAILED(mContainerReflection->GetPartReflection(partIndex, IID_PPV_ARGS(&shaderReflection)))) { return false; }
+
+    D3D12_SHADER_DESC shaderDesc{};
+    shaderReflection->GetDesc(&shaderDesc);
+
+    for (uint32_t i = 0; i < shaderDesc.BoundResources; ++i)
+    {
+        D3D12_SHADER_INPUT_BIND_DESC bindDesc{};
+        shaderReflection->GetResourceBindingDesc(i, &bindDesc);
+
+        ShaderBinding& binding = reflection.Bindings.emplace_back();
+        binding.Register = bindDesc.BindPoint;
+        binding.Space = bindDesc.Space;
+        binding.Name = bindDesc.Name;
+
+        switch (bindDesc.Type)
+        {
+            case D3D_SIT_CBUFFER:
+            {
+                binding.Type = ShaderBindingType::ConstantBuffer;
+                binding.Resource = ParameterResource::Buffer;
+
+                // Size of the buffer is aligned to 16 bytes, so the used part is taken from its variables
+                ID3D12ShaderReflectionConstantBuffer* constantBuffer = shaderReflection->GetConstantBufferByName(bindDesc.Name);
+                D3D12_SHADER_BUFFER_DESC bufferDesc{};
+                constantBuffer->GetDesc(&bufferDesc);
+
+                for (uint32_t var = 0; var < bufferDesc.Variables; ++var)
+                {
+                    D3D12_SHADER_VARIABLE_DESC varDesc{};
+                    constantBuffer->GetVariableByIndex(var)->GetDesc(&varDesc);
+                    binding.Size = std::max(binding.Size, varDesc.StartOffset + varDesc.Size);
+                }
+                break;
+            }
+            case D3D_SIT_STRUCTURED:
+            case D3D_SIT_BYTEADDRESS:
+            {
+                binding.Type = ShaderBindingType::SRV;
+                binding.Resource = ParameterResource::Buffer;
+                break;
+            }
+            case D3D_SIT_TEXTURE:
+            case D3D_SIT_TBUFFER:
+            {
+                binding.Type = ShaderBindingType::SRV;
+                break;
+            }
+            case D3D_SIT_UAV_RWSTRUCTURED:
+            case D3D_SIT_UAV_RWBYTEADDRESS:
+            {
+                binding.Type = ShaderBindingType::UAV;
+                binding.Resource = ParameterResource::Buffer;
+                break;
+            }
+            case D3D_SIT_UAV_RWTYPED:
+            case D3D_SIT_UAV_APPEND_STRUCTURED:
+            case D3D_SIT_UAV_CONSUME_STRUCTURED:
+            case D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER:
+            {
+                // Typed buffers and counters can't be bound as root descriptors
+                binding.Type = ShaderBindingType::UAV;
+                break;
+            }
+            case D3D_SIT_SAMPLER:
+            {
+                binding.Type = ShaderBindingType::Sampler;
+                break;
+            }
+            default:
+            {
+                Assert(false); // Unsupported resource type
+                reflection.Bindings.pop_back();
+            }
+        }
+    }
+
+    reflection.UsesResourceDescriptorHeap = (shaderReflection->GetRequiresFlags() & D3D_SHADER_REQUIRES_RESOURCE_DESCRIPTOR_HEAP_INDEXING) != 0;
+
+    shaderReflection->Release();
+    return true;
+}
+
+ShaderParametersLayout ShaderManager::CreateShaderParametersLayout(std::initializer_list<std::pair<ShaderType, const ShaderReflection*>> shaders) const
+{
+    struct StageBinding
+    {
+        ShaderBinding Binding;
+        D3D12_SHADER_VISIBILITY Visibility;
+    };
+
+    std::vector<StageBinding> bindings;
+    bool usesBindlessHeap = false;
+
+    for (const auto& [type, reflection] : shaders)
+    {
+        const D3D12_SHADER_VISIBILITY visibility = type == ShaderType::Vertex ? D3D12_SHADER_VISIBILITY_VERTEX : 
+                                                   type == ShaderType::Pixel ? D3D12_SHADER_VISIBILITY_PIXEL : D3D12_SHADER_VISIBILITY_ALL;
+
+        usesBindlessHeap |= reflection->UsesResourceDescriptorHeap;
+
+        for (const ShaderBinding& binding : reflection->Bindings)
+        {
+            // Whole bindless space is covered by a single table
+            if (binding.Space == BindlessDescriptorRegisterSpace)
+            {
+                usesBindlessHeap = true;
+                continue;
+            }
+
+            Assert(binding.Space == 0); // Only the default and the bindless spaces are supported
+
+            // Resource used by many stages has to be visible to all of them
+            auto bindingIt = std::find_if(bindings.begin(), bindings.end(), [&binding](const StageBinding& stageBinding) {
+                return stageBinding.Binding.Type == binding.Type && stageBinding.Binding.Register == binding.Register;
+                });
+
+            if (bindingIt != bindings.end())
+            {
+                Assert(bindingIt->Binding.Resource == binding.Resource && bindingIt->Binding.Size == binding.Size); // Stages declare different resources under the same register
+                bindingIt->Visibility = D3D12_SHADER_VISIBILITY_ALL;
+                continue;
+            }
+
+            bindings.push_back({ binding, visibility });
+        }
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const StageBinding& a, const StageBinding& b) {
+        return std::tie(a.Binding.Type, a.Binding.Register) < std::tie(b.Binding.Type, b.Binding.Register);
+        });
+
+    Sampler defaultSampler;
+
+    ShaderParametersLayout layout;
+    uint32_t idx = 0;
+
+    for (const auto& [binding, visibility] : bindings)
+    {
+        if (binding.Type != ShaderBindingType::Sampler)
+        {
+            layout.SetParameterName(idx, binding.Name);
+        }
+
+        switch (binding.Type)
+        {
+            case ShaderBindingType::ConstantBuffer:
+            {
+                const uint32_t size = Align(binding.Size, 4U) / 4;
+                if (size <= MaxRootConstantsSize)
+                {
+                    layout.SetConstant(idx++, binding.Register, size, visibility);
+                }
+                else
+                {
+                    layout.SetCBV(idx++, binding.Register, visibility);
+                }
+                break;
+            }
+            case ShaderBindingType::SRV: { layout.SetSRV(idx++, binding.Register, visibility, binding.Resource); break; }
+            case ShaderBindingType::UAV: { layout.SetUAV(idx++, binding.Register, visibility, binding.Resource); break; }
+            case ShaderBindingType::Sampler: { layout.SetStaticSampler(binding.Register, defaultSampler, visibility); break; }
+            default: { Assert(false); }
+        }
+    }
+
+    if (usesBindlessHeap)
+    {
+        layout.SetBindlessHeap(idx);
+    }
+
+    // Root signature is packed and hashed right away, so using the layout later doesn't change it
+    layout.GetRootSignatureCost();
+    layout.Hash();
+
+    return layout;
+}
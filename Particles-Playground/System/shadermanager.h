@@ -5,17 +5,23 @@ struct IDxcLibrary;
 struct IDxcCompiler;
 struct IDxcBlob;
 struct IDxcIncludeHandler;
+struct IDxcContainerReflection;
+class ShaderIncludeHandler;
 
 // Global shaders
 extern ShaderHandle VS_Screen;
 extern ShaderHandle PS_Screen;
 extern ShaderHandle VS_DrawParticle;
 extern ShaderHandle PS_DrawParticle;
-extern ShaderHandle CS_ResetFreeIndices;
+extern ShaderHandle CS_RelocateParticles;
 extern ShaderHandle CS_EmitterUpdate;
+extern ShaderHandle CS_PrepareDraw;
+extern ShaderHandle CS_BuildSortKeys;
+extern ShaderHandle CS_BitonicSort;
 
 using ShaderToken = std::pair<std::string_view, std::string_view>;
 using ShaderTokens = std::vector<ShaderToken>;
+using ShaderParameterNames = std::vector<std::string>;
 
 class ShaderCompilationResult
 {
@@ -46,7 +52,10 @@ private:
 
 class ShaderManager
 {
-    static const uint32_t MaxShaders = 64;
+    static const uint32_t MaxShaders = 1024;
+
+    // Constant buffers up to this size (in DWORDs) are placed directly in the root signature
+    static const uint32_t MaxRootConstantsSize = 16;
 
 public:
     ShaderManager(const ShaderManager&) = delete;
@@ -58,9 +67,19 @@ public:
     bool Startup();
     bool Shutdown();
 
-    ShaderCompilationResult CompileShader(std::wstring_view shaderName, ShaderType type, std::wstring_view entry = L"main", ShaderTokens tokens = {});
+    // Releases retired bytecode and recompiles shaders affected by files changed in the shader folder since the last call
+    void PreUpdate();
+
+    // Callers which bind parameters by index pass their names in that order, a shader which doesn't match them fails to compile.
+    // It catches resources stripped by the compiler, which would shift indices of all following parameters.
+    ShaderCompilationResult CompileShader(std::wstring_view shaderName, ShaderType type, std::wstring_view entry = L"main", ShaderTokens tokens = {}, ShaderParameterNames parameters = {});
     inline Shader* GetShader(ShaderHandle handle) { return mShadersPool.GetObject(handle); }
-    inline void FreeShader(ShaderHandle handle) { mShadersPool.FreeObject(handle); }
+    void FreeShader(ShaderHandle handle);
+
+    // Layouts are generated from the reflection and built once, parameters are numbered in order:
+    // constant buffers, SRVs and UAVs, each group sorted by register
+    const ShaderParametersLayout& GetShaderParametersLayout(ShaderHandle computeShader);
+    const ShaderParametersLayout& GetShaderParametersLayout(ShaderHandle vertexShader, ShaderHandle pixelShader);
 
     static ShaderManager& Get()
     {
@@ -75,14 +94,41 @@ private:
 
     bool GetSourceCode(std::wstring_view path, std::string& sourceCode);
     void ApplyTokens(ShaderTokens tokens, std::wstring_view shaderPath, std::string& sourceCode);
+    bool PreprocessShader(std::wstring_view shaderPath, ShaderTokens tokens, std::string& preprocessedCode, std::vector<std::wstring>& includes, std::string& errorMsg);
     IDxcBlob* CompileShader(std::string_view sourceCode, ShaderType type, std::wstring_view entry, std::wstring_view shaderPath, std::string& error);
     std::wstring_view GetShaderTargetProfile(ShaderType type) const;
+    bool ReflectShader(IDxcBlob* blob, ShaderReflection& reflection);
+    ShaderParametersLayout CreateShaderParametersLayout(std::initializer_list<std::pair<ShaderType, const ShaderReflection*>> shaders) const;
+
+    std::vector<std::wstring> UpdateShaderFileTimes();
+    void ReloadShaders(const std::vector<std::wstring>& changedFiles);
+    bool DependsOnFiles(const Shader& shader, const std::vector<std::wstring>& files) const;
+    void RetireBlob(IDxcBlob* blob);
+    bool ValidateParameters(const ShaderParametersLayout& layout, const ShaderSource& source, std::wstring_view shaderName) const;
 
     HMODULE mDXCHandle = nullptr;
     IDxcLibrary* mLibrary = nullptr;
     IDxcCompiler* mCompiler = nullptr;
     IDxcIncludeHandler* mIncludeHandler = nullptr;
+    ShaderIncludeHandler* mTrackingIncludeHandler = nullptr;
+    IDxcContainerReflection* mContainerReflection = nullptr;
 
     ObjectPool<Shader> mShadersPool;
 
+    // Layouts of vertex and pixel shader pairs, keyed by both handles
+    std::map<uint64_t, ShaderParametersLayout> mGraphicsLayouts;
+    std::mutex mGraphicsLayoutsLock;
+
+    // Shader folder is watched for changes, write times tell which files have changed
+    HANDLE mShadersChangeHandle = INVALID_HANDLE_VALUE;
+    std::map<std::wstring, uint64_t> mShaderFileTimes;
+
+    // Bytecode of freed and reloaded shaders, pipeline states built from it are retired together with it
+    struct RetiredBlob
+    {
+        IDxcBlob* Blob = nullptr;
+        uint64_t FrameNumber = 0;
+    };
+    std::vector<RetiredBlob> mRetiredBlobs;
+
 };
@@ -6,7 +6,7 @@
 template<typename T>
 ShaderParameters& ShaderParameters::SetCBV(uint32_t idx, T& resource)
 {
-    mParams[idx] = SingleDescriptor<T>{ DescriptorType::CBV, &resource };
+    GetParameter(idx) = SingleDescriptor<T>{ DescriptorType::CBV, &resource };
     return *this;
 }
 
@@ -16,7 +16,7 @@ template ShaderParameters& ShaderParameters::SetCBV<GPUBuffer>(uint32_t idx, GPU
 template<typename T>
 ShaderParameters& ShaderParameters::SetSRV(uint32_t idx, T& resource)
 {
-    mParams[idx] = SingleDescriptor<T>{ DescriptorType::SRV, &resource };
+    GetParameter(idx) = SingleDescriptor<T>{ DescriptorType::SRV, &resource };
     return *this;
 }
 
@@ -27,42 +27,89 @@ template ShaderParameters& ShaderParameters::SetSRV<Texture2D>(uint32_t idx, Tex
 template<typename T>
 ShaderParameters& ShaderParameters::SetUAV(uint32_t idx, T& resource)
 {
-    mParams[idx] = SingleDescriptor<T>{ DescriptorType::UAV, &resource };
+    GetParameter(idx) = SingleDescriptor<T>{ DescriptorType::UAV, &resource };
     return *this;
 }
 
 template ShaderParameters& ShaderParameters::SetUAV<GPUBuffer>(uint32_t idx, GPUBuffer& resource);
 
+// ---
+ShaderParameters::ParameterVar& ShaderParameters::GetParameter(uint32_t idx)
+{
+    Assert(idx < MaxParameters); // Root parameter index is too big
+    mParamsCount = std::max(mParamsCount, idx + 1);
+    return mParams[idx];
+}
+
 // ---
 template <bool isGraphics>
-void ShaderParameters::Bind(CommandList& commandList, ShaderParametersLayout& layout)
+void ShaderParameters::Bind(CommandList& commandList, const ShaderParametersLayout& layout)
 {
-    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    // Scratch storage keeps its capacity between calls
+    static thread_local std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    barriers.clear();
+
+    GPUDescriptorHeap* descriptorHeap = Graphic::Get().GetGPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    const uint32_t handleSize = Graphic::Get().GetHandleSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    // Tables which don't have any of their parameters set keep what was bound before
+    std::array<uint32_t, ShaderParametersLayout::MaxTables> tableParamsCount = {};
+    for (uint32_t idx = 0; idx < mParamsCount; ++idx)
+    {
+        const RootParameterLocation& location = layout.GetRootParameterLocation(idx);
+        if (!std::holds_alternative<std::monostate>(mParams[idx]) && location.Type == RootParameterType::Table)
+        {
+            ++tableParamsCount[location.TableIndex];
+        }
+    }
+
+    // Every table is allocated once and filled with all of its descriptors
+    std::array<std::optional<GPUDescriptorHandleScoped>, ShaderParametersLayout::MaxTables> tableHandles;
+    for (uint32_t tableIdx = 0; tableIdx < layout.GetRootTablesCount(); ++tableIdx)
+    {
+        if (tableParamsCount[tableIdx] == 0) { continue; }
 
-    for (const auto& [idx, var] : mParams)
+        const RootTableDesc& table = layout.GetRootTable(tableIdx);
+        Assert(tableParamsCount[tableIdx] == table.Size); // Parameters sharing a table have to be set together
+        tableHandles[tableIdx].emplace(descriptorHeap->Allocate<GPUStandardDescriptor>(table.Size));
+    }
+
+    for (uint32_t idx = 0; idx < mParamsCount; ++idx)
     {
-        if (std::holds_alternative<RootConstant>(var))
+        const ParameterVar& var = mParams[idx];
+
+        if (std::holds_alternative<std::monostate>(var))
+        {
+            continue;
+        }
+        else if (std::holds_alternative<RootConstant>(var))
         {
             const RootConstant& constant = std::get<RootConstant>(var);
-            const uint32_t size = static_cast<uint32_t>(constant.Data.size());
-            const uint32_t* data = constant.Data.data();
+            const uint32_t size = constant.Size;
+            const uint32_t* data = &mConstants[constant.Offset];
+            const RootParameterLocation& location = layout.GetRootParameterLocation(idx);
+            Assert(location.Type == RootParameterType::Constants); // Layout doesn't match parameters
+
+            const uint32_t rootIndex = location.RootIndex;
 
             if constexpr (isGraphics) {
-                commandList->SetGraphicsRoot32BitConstants(idx, size, data, 0);
+                commandList.SetGraphicsRoot32BitConstants(rootIndex, size, data);
             }
             else {
-                commandList->SetComputeRoot32BitConstants(idx, size, data, 0);
+                commandList.SetComputeRoot32BitConstants(rootIndex, size, data);
             }
         }
         else
         {
             D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = {};
+            D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
 
             if (std::holds_alternative<SingleDescriptor<GPUBuffer>>(var))
             {
                 const SingleDescriptor<GPUBuffer>& descriptor = std::get<SingleDescriptor<GPUBuffer>>(var);
                 const DescriptorType type = descriptor.Type;
                 GPUBuffer* resource = descriptor.Resource;
+                gpuAddress = resource->GetGPUAddress();
 
                 switch (type)
                 {
@@ -108,30 +155,82 @@ void ShaderParameters::Bind(CommandList& commandList, ShaderParametersLayout& la
             }
             else { Assert(false); }
 
-            GPUDescriptorHandleScoped gpuHandle = Graphic::Get().GetGPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->Allocate<GPUStandardDescriptor>();
-            Graphic::Get().GetDevice()->CopyDescriptorsSimple(1, gpuHandle, cpuHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            const RootParameterLocation& location = layout.GetRootParameterLocation(idx);
+            const uint32_t rootIndex = location.RootIndex;
 
-            if constexpr (isGraphics) {
-                commandList->SetGraphicsRootDescriptorTable(idx, gpuHandle);
-            }
-            else {
-                commandList->SetComputeRootDescriptorTable(idx, gpuHandle);
+            // Only raw and structured buffers can be promoted to root descriptors
+            Assert(location.Type == RootParameterType::Table || gpuAddress != 0);
+
+            switch (location.Type)
+            {
+                case RootParameterType::Table:
+                {
+                    const CD3DX12_CPU_DESCRIPTOR_HANDLE tableHandle(static_cast<D3D12_CPU_DESCRIPTOR_HANDLE>(*tableHandles[location.TableIndex]), location.TableOffset, handleSize);
+                    Graphic::Get().GetDevice()->CopyDescriptorsSimple(1, tableHandle, cpuHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+                    break;
+                }
+                case RootParameterType::CBV:
+                {
+                    if constexpr (isGraphics) {
+                        commandList.SetGraphicsRootConstantBufferView(rootIndex, gpuAddress);
+                    }
+                    else {
+                        commandList.SetComputeRootConstantBufferView(rootIndex, gpuAddress);
+                    }
+                    break;
+                }
+                case RootParameterType::SRV:
+                {
+                    if constexpr (isGraphics) {
+                        commandList.SetGraphicsRootShaderResourceView(rootIndex, gpuAddress);
+                    }
+                    else {
+                        commandList.SetComputeRootShaderResourceView(rootIndex, gpuAddress);
+                    }
+                    break;
+                }
+                case RootParameterType::UAV:
+                {
+                    if constexpr (isGraphics) {
+                        commandList.SetGraphicsRootUnorderedAccessView(rootIndex, gpuAddress);
+                    }
+                    else {
+                        commandList.SetComputeRootUnorderedAccessView(rootIndex, gpuAddress);
+                    }
+                    break;
+                }
+                default: { Assert(false); }
             }
 
         }
         
     }
 
+    for (uint32_t tableIdx = 0; tableIdx < layout.GetRootTablesCount(); ++tableIdx)
+    {
+        if (!tableHandles[tableIdx]) { continue; }
+
+        const uint32_t rootIndex = layout.GetRootTable(tableIdx).RootIndex;
+        const D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = *tableHandles[tableIdx];
+
+        if constexpr (isGraphics) {
+            commandList.SetGraphicsRootDescriptorTable(rootIndex, gpuHandle);
+        }
+        else {
+            commandList.SetComputeRootDescriptorTable(rootIndex, gpuHandle);
+        }
+    }
+
     if (!Graphic::Get().SupportsResourceDescriptorHeap() && layout.HasBindlessHeap())
     {
         CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(Graphic::Get().GetGPUDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->GetHeap()->GetGPUDescriptorHandleForHeapStart(), 0, 
             Graphic::Get().GetHandleSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
 
         if constexpr (isGraphics) {
-            commandList->SetGraphicsRootDescriptorTable(layout.GetBindlessHeapIndex(), gpuHandle);
+            commandList.SetGraphicsRootDescriptorTable(layout.GetBindlessHeapIndex(), gpuHandle);
         }
         else {
-            commandList->SetComputeRootDescriptorTable(layout.GetBindlessHeapIndex(), gpuHandle);
+            commandList.SetComputeRootDescriptorTable(layout.GetBindlessHeapIndex(), gpuHandle);
         }
     }
 
@@ -142,5 +241,5 @@ void ShaderParameters::Bind(CommandList& commandList, ShaderParametersLayout& la
 
 }
 
-template void ShaderParameters::Bind<true>(CommandList& commandList, ShaderParametersLayout& layout);
-template void ShaderParameters::Bind<false>(CommandList& commandList, ShaderParametersLayout& layout);
+template void ShaderParameters::Bind<true>(CommandList& commandList, const ShaderParametersLayout& layout);
+template void ShaderParameters::Bind<false>(CommandList& commandList, const ShaderParametersLayout& layout);
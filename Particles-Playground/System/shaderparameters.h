@@ -7,9 +7,11 @@ class ShaderParametersLayout;
 
 class ShaderParameters
 {
+    // Data is kept in mConstants, so setting parameters never touches the heap
     struct RootConstant
     {
-        std::vector<uint32_t> Data;
+        uint32_t Offset = 0;
+        uint32_t Size = 0;
     };
 
     enum class DescriptorType
@@ -26,9 +28,15 @@ class ShaderParameters
         ResourceT* Resource = nullptr;
     };
 
-    using ParameterVar = std::variant<SingleDescriptor<GPUBuffer>, SingleDescriptor<Texture2D>, RootConstant>;
+    using ParameterVar = std::variant<std::monostate, SingleDescriptor<GPUBuffer>, SingleDescriptor<Texture2D>, RootConstant>;
 
 public:
+    // Parameters are indexed directly by the root parameter index
+    static const uint32_t MaxParameters = 16;
+
+    // Root signature can't hold more than 64 DWORDs, so constants of any layout fit
+    static const uint32_t MaxConstants = 64;
+
     ShaderParameters() = default;
     ~ShaderParameters() = default;
     ShaderParameters(const ShaderParameters&) = default;
@@ -47,11 +55,15 @@ public:
     ShaderParameters& SetConstant(uint32_t idx, const T& data);
 
     template<bool isGraphics>
-    void Bind(CommandList& commandList, ShaderParametersLayout& layout);
+    void Bind(CommandList& commandList, const ShaderParametersLayout& layout);
 
 private:
-    std::map<uint32_t, ParameterVar> mParams;
-    
+    ParameterVar& GetParameter(uint32_t idx);
+
+    std::array<ParameterVar, MaxParameters> mParams = {};
+    std::array<uint32_t, MaxConstants> mConstants = {};
+    uint32_t mParamsCount = 0;
+    uint32_t mConstantsCount = 0;
 };
 
 #include "shaderparameters.inl"
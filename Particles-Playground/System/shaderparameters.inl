@@ -9,12 +9,19 @@ template<typename T>
 ShaderParameters& ShaderParameters::SetConstant(uint32_t idx, const T& data)
 {
     const uint32_t size = std::max(static_cast<uint32_t>(sizeof(T) / 4), 1U);
-    RootConstant constant;
-    constant.Data.resize(size);
+    ParameterVar& param = GetParameter(idx);
 
-    memcpy(constant.Data.data(), &data, sizeof(T));
+    // Constant set again with the same size reuses its DWORDs
+    RootConstant* constant = std::get_if<RootConstant>(&param);
+    if (!constant || constant->Size != size)
+    {
+        Assert(mConstantsCount + size <= MaxConstants); // Too many root constants
+        param = RootConstant{ mConstantsCount, size };
+        constant = &std::get<RootConstant>(param);
+        mConstantsCount += size;
+    }
 
-    mParams[idx] = std::move(constant);
+    memcpy(&mConstants[constant->Offset], &data, sizeof(T));
 
     return *this;
 }
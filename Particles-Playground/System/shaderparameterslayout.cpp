@@ -11,34 +11,38 @@ std::array<CD3DX12_DESCRIPTOR_RANGE1, 3> g_BindlessRanges = {
     CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, GPUDescriptorHeap::BindlessDescriptorNum, 0, BindlessDescriptorRegisterSpace, g_BindlessFlags, 0)
 };
 
+// Descriptor table takes 1 DWORD, root descriptor takes 2 DWORDs
+const uint32_t g_TableCost = 1;
+const uint32_t g_RootDescriptorCost = 2;
+
 ShaderParametersLayout& ShaderParametersLayout::SetCBV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility)
 {
     SingleRangeDesc desc{};
     desc.Range = CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, regIdx);
     desc.Visibility = visibility;
+    desc.Resource = ParameterResource::Buffer;
 
-    mParams[idx] = desc;
-    return *this;
+    return SetParameter(idx, desc);
 }
 
-ShaderParametersLayout& ShaderParametersLayout::SetSRV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility)
+ShaderParametersLayout& ShaderParametersLayout::SetSRV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility, ParameterResource resource)
 {
     SingleRangeDesc desc{};
     desc.Range = CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, regIdx);
     desc.Visibility = visibility;
+    desc.Resource = resource;
 
-    mParams[idx] = desc;
-    return *this;
+    return SetParameter(idx, desc);
 }
 
-ShaderParametersLayout& ShaderParametersLayout::SetUAV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility)
+ShaderParametersLayout& ShaderParametersLayout::SetUAV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility, ParameterResource resource)
 {
     SingleRangeDesc desc{};
     desc.Range = CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, regIdx);
     desc.Visibility = visibility;
+    desc.Resource = resource;
 
-    mParams[idx] = desc;
-    return *this;
+    return SetParameter(idx, desc);
 }
 
 ShaderParametersLayout& ShaderParametersLayout::SetConstant(uint32_t idx, uint32_t regIdx, uint32_t size, D3D12_SHADER_VISIBILITY visibility)
@@ -46,8 +50,7 @@ ShaderParametersLayout& ShaderParametersLayout::SetConstant(uint32_t idx, uint32
     ConstantDesc desc{};
     desc.Parameter.InitAsConstants(size, regIdx, 0, visibility);
 
-    mParams[idx] = desc;
-    return *this;
+    return SetParameter(idx, desc);
 }
 
 ShaderParametersLayout& ShaderParametersLayout::SetStaticSampler(uint32_t regIdx, Sampler& sampler, D3D12_SHADER_VISIBILITY visibility)
@@ -60,6 +63,7 @@ ShaderParametersLayout& ShaderParametersLayout::SetStaticSampler(uint32_t regIdx
                               D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK, desc.MinLOD,
                               desc.MaxLOD, visibility, 0);
     
+    mHash.reset();
     return *this;
 }
 
@@ -67,12 +71,53 @@ ShaderParametersLayout& ShaderParametersLayout::SetBindlessHeap(uint32_t idx)
 {
     Assert(idx != std::numeric_limits<uint32_t>::max());
     mBindlessIndex = idx;
+    mCompiled = false;
+    mHash.reset();
+    return *this;
+}
+
+ShaderParametersLayout& ShaderParametersLayout::SetParameterName(uint32_t idx, std::string_view name)
+{
+    Assert(idx < MaxParameters);
+    mParamNames[idx] = name;
     return *this;
 }
 
+uint32_t ShaderParametersLayout::GetParameterIndex(std::string_view name) const
+{
+    for (const auto& [idx, paramName] : mParamNames)
+    {
+        if (paramName == name)
+        {
+            return idx;
+        }
+    }
+
+    return InvalidParameterIndex;
+}
+
+bool ShaderParametersLayout::HasParameters(const std::vector<std::string>& names) const
+{
+    if (names.size() != mParams.size())
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < names.size(); ++idx)
+    {
+        if (GetParameterIndex(names[idx]) != idx)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 uint32_t ShaderParametersLayout::Hash() const
 {
     if (mParams.empty()) { return 0; }
+    if (mHash) { return *mHash; }
 
     const auto maxElem = std::max_element(mParams.begin(), mParams.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
     const uint32_t biggestIdx = maxElem->first;
@@ -108,36 +153,47 @@ uint32_t ShaderParametersLayout::Hash() const
 
     *reinterpret_cast<uint32_t*>(start + parametersSize + staticSamplerSize) = GetBindlessHeapIndex();
 
-    return HashRange(reinterpret_cast<uint32_t*>(start), reinterpret_cast<uint32_t*>(end));
+    mHash = HashRange(reinterpret_cast<uint32_t*>(start), reinterpret_cast<uint32_t*>(end));
+    return *mHash;
 }
 
 RootParameters ShaderParametersLayout::GetParameters() const
 {
     if (mParams.empty()) { return {}; }
 
-    const auto maxElem = std::max_element(mParams.begin(), mParams.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
-
-    uint32_t biggestIdx = maxElem->first;
-    if (!Graphic::Get().SupportsResourceDescriptorHeap() && HasBindlessHeap())
-    {
-        biggestIdx = std::max(maxElem->first, GetBindlessHeapIndex());
-    }
+    Compile();
 
     RootParameters result{};
-    result.Parameters.resize(biggestIdx + 1);
+    result.Parameters.resize(mRootParametersCount);
 
-    for (auto& [idx, param] : mParams)
+    // Ranges are referenced by pointers, so they can't be reallocated
+    result.Ranges.reserve(mParams.size());
+
+    std::array<std::pair<const SingleRangeDesc*, RootParameterLocation>, MaxParameters> tableParams;
+    uint32_t tableParamsCount = 0;
+
+    for (const auto& [idx, param] : mParams)
     {
+        const RootParameterLocation& location = mLocations[idx];
+
         if (std::holds_alternative<SingleRangeDesc>(param))
         {
             const SingleRangeDesc& range = std::get<SingleRangeDesc>(param);
-            result.Ranges.push_back(range.Range);
-            result.Parameters[idx].InitAsDescriptorTable(1, &result.Ranges.back(), range.Visibility);
+            const uint32_t regIdx = range.Range.BaseShaderRegister;
+
+            switch (location.Type)
+            {
+                case RootParameterType::Table: { tableParams[tableParamsCount++] = { &range, location }; break; }
+                case RootParameterType::CBV: { result.Parameters[location.RootIndex].InitAsConstantBufferView(regIdx, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, range.Visibility); break; }
+                case RootParameterType::SRV: { result.Parameters[location.RootIndex].InitAsShaderResourceView(regIdx, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, range.Visibility); break; }
+                case RootParameterType::UAV: { result.Parameters[location.RootIndex].InitAsUnorderedAccessView(regIdx, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, range.Visibility); break; }
+                default: { Assert(0); } // Unsupported parameter type
+            }
         }
         else if (std::holds_alternative<ConstantDesc>(param))
         {
             const ConstantDesc& constant = std::get<ConstantDesc>(param);
-            result.Parameters[idx] = constant.Parameter;
+            result.Parameters[location.RootIndex] = constant.Parameter;
         }
         else
         {
@@ -145,9 +201,44 @@ RootParameters ShaderParametersLayout::GetParameters() const
         }
     }
 
+    // Parameters inside of a table are sorted by type and register, so neighbours with consecutive registers can share one range
+    std::sort(tableParams.begin(), tableParams.begin() + tableParamsCount, [](const auto& a, const auto& b) {
+        return std::tie(a.second.TableIndex, a.second.TableOffset) < std::tie(b.second.TableIndex, b.second.TableOffset);
+        });
+
+    for (uint32_t first = 0; first < tableParamsCount;)
+    {
+        const uint32_t tableIdx = tableParams[first].second.TableIndex;
+        const size_t firstRange = result.Ranges.size();
+
+        uint32_t last = first;
+        for (; last < tableParamsCount && tableParams[last].second.TableIndex == tableIdx; ++last)
+        {
+            const CD3DX12_DESCRIPTOR_RANGE1& range = tableParams[last].first->Range;
+
+            if (result.Ranges.size() > firstRange)
+            {
+                CD3DX12_DESCRIPTOR_RANGE1& previous = result.Ranges.back();
+                if (previous.RangeType == range.RangeType && previous.BaseShaderRegister + previous.NumDescriptors == range.BaseShaderRegister)
+                {
+                    ++previous.NumDescriptors;
+                    continue;
+                }
+            }
+
+            CD3DX12_DESCRIPTOR_RANGE1& newRange = result.Ranges.emplace_back(range);
+            newRange.OffsetInDescriptorsFromTableStart = tableParams[last].second.TableOffset;
+        }
+
+        const uint32_t rangesCount = static_cast<uint32_t>(result.Ranges.size() - firstRange);
+        result.Parameters[mTables[tableIdx].RootIndex].InitAsDescriptorTable(rangesCount, &result.Ranges[firstRange], tableParams[first].first->Visibility);
+
+        first = last;
+    }
+
     if (!Graphic::Get().SupportsResourceDescriptorHeap() && HasBindlessHeap())
     {
-        result.Parameters[GetBindlessHeapIndex()].InitAsDescriptorTable(static_cast<uint32_t>(g_BindlessRanges.size()), g_BindlessRanges.data(), D3D12_SHADER_VISIBILITY_ALL);
+        result.Parameters[mBindlessRootIndex].InitAsDescriptorTable(static_cast<uint32_t>(g_BindlessRanges.size()), g_BindlessRanges.data(), D3D12_SHADER_VISIBILITY_ALL);
     }
 
     result.StaticSamplers = mStaticSamplers;
@@ -155,11 +246,11 @@ RootParameters ShaderParametersLayout::GetParameters() const
     return result;
 }
 
-D3D12_SHADER_VISIBILITY ShaderParametersLayout::GetVisibilityForParameterIndex(uint32_t idx)
+D3D12_SHADER_VISIBILITY ShaderParametersLayout::GetVisibilityForParameterIndex(uint32_t idx) const
 {
     Assert(mParams.count(idx));
 
-    const ParameterVar& param = mParams[idx];
+    const ParameterVar& param = mParams.at(idx);
     
     if (std::holds_alternative<SingleRangeDesc>(param))
     {
@@ -175,3 +266,183 @@ D3D12_SHADER_VISIBILITY ShaderParametersLayout::GetVisibilityForParameterIndex(u
     Assert(0); // Unsupported parameter type
     return D3D12_SHADER_VISIBILITY_ALL;
 }
+
+const RootParameterLocation& ShaderParametersLayout::GetRootParameterLocation(uint32_t idx) const
+{
+    Assert(idx < MaxParameters);
+
+    Compile();
+    return mLocations[idx];
+}
+
+const RootTableDesc& ShaderParametersLayout::GetRootTable(uint32_t tableIdx) const
+{
+    Compile();
+
+    Assert(tableIdx < mTablesCount);
+    return mTables[tableIdx];
+}
+
+uint32_t ShaderParametersLayout::GetRootTablesCount() const
+{
+    Compile();
+    return mTablesCount;
+}
+
+uint32_t ShaderParametersLayout::GetRootSignatureCost() const
+{
+    Compile();
+    return mCost;
+}
+
+uint32_t ShaderParametersLayout::GetBindlessHeapIndex() const
+{
+    Assert(HasBindlessHeap());
+
+    Compile();
+    return mBindlessRootIndex;
+}
+
+ShaderParametersLayout& ShaderParametersLayout::SetParameter(uint32_t idx, const ParameterVar& param)
+{
+    Assert(idx < MaxParameters); // Parameter index is too big
+
+    mParams[idx] = param;
+    mCompiled = false;
+    mHash.reset();
+    return *this;
+}
+
+void ShaderParametersLayout::Compile() const
+{
+    if (mCompiled) { return; }
+
+    mLocations = {};
+    mTables = {};
+    mTablesCount = 0;
+
+    const bool hasBindlessTable = !Graphic::Get().SupportsResourceDescriptorHeap() && HasBindlessHeap();
+    uint32_t cost = hasBindlessTable ? g_TableCost : 0;
+
+    // Every descriptor starts in a table shared by all descriptors with the same visibility
+    std::array<D3D12_SHADER_VISIBILITY, MaxTables> tableVisibilities = {};
+
+    for (const auto& [idx, param] : mParams)
+    {
+        RootParameterLocation& location = mLocations[idx];
+
+        if (std::holds_alternative<SingleRangeDesc>(param))
+        {
+            const SingleRangeDesc& range = std::get<SingleRangeDesc>(param);
+
+            const auto tableIt = std::find(tableVisibilities.begin(), tableVisibilities.begin() + mTablesCount, range.Visibility);
+            const uint32_t tableIdx = static_cast<uint32_t>(std::distance(tableVisibilities.begin(), tableIt));
+
+            if (tableIdx == mTablesCount)
+            {
+                Assert(mTablesCount < MaxTables);
+                tableVisibilities[mTablesCount++] = range.Visibility;
+                cost += g_TableCost;
+            }
+
+            location.Type = RootParameterType::Table;
+            location.TableIndex = static_cast<uint8_t>(tableIdx);
+            ++mTables[tableIdx].Size;
+        }
+        else if (std::holds_alternative<ConstantDesc>(param))
+        {
+            const ConstantDesc& constant = std::get<ConstantDesc>(param);
+
+            location.Type = RootParameterType::Constants;
+            cost += constant.Parameter.Constants.Num32BitValues;
+        }
+    }
+
+    // Root descriptor saves a descriptor copy on every bind, but costs more than a place in a table.
+    // Buffers are promoted as long as the whole root signature can still be kept in registers.
+    for (const auto& [idx, param] : mParams)
+    {
+        const SingleRangeDesc* range = std::get_if<SingleRangeDesc>(&param);
+        if (!range || range->Resource != ParameterResource::Buffer) { continue; }
+
+        RootParameterLocation& location = mLocations[idx];
+        RootTableDesc& table = mTables[location.TableIndex];
+
+        // Table is removed together with its last descriptor
+        const uint32_t promotedCost = cost + g_RootDescriptorCost - (table.Size == 1 ? g_TableCost : 0);
+        if (promotedCost > FastRootSignatureCost) { continue; }
+
+        switch (range->Range.RangeType)
+        {
+            case D3D12_DESCRIPTOR_RANGE_TYPE_CBV: { location.Type = RootParameterType::CBV; break; }
+            case D3D12_DESCRIPTOR_RANGE_TYPE_SRV: { location.Type = RootParameterType::SRV; break; }
+            case D3D12_DESCRIPTOR_RANGE_TYPE_UAV: { location.Type = RootParameterType::UAV; break; }
+            default: { Assert(0); }
+        }
+
+        --table.Size;
+        cost = promotedCost;
+    }
+
+    // Constants go first, then root descriptors, tables and the bindless table at the end
+    uint32_t rootIndex = 0;
+
+    for (RootParameterType type : { RootParameterType::Constants, RootParameterType::CBV, RootParameterType::SRV, RootParameterType::UAV })
+    {
+        for (const auto& [idx, param] : mParams)
+        {
+            if (mLocations[idx].Type == type)
+            {
+                mLocations[idx].RootIndex = static_cast<uint8_t>(rootIndex++);
+            }
+        }
+    }
+
+    std::array<uint32_t, MaxTables> tableRemap = {};
+    uint32_t tablesCount = 0;
+
+    for (uint32_t i = 0; i < mTablesCount; ++i)
+    {
+        if (mTables[i].Size == 0) { continue; }
+
+        tableRemap[i] = tablesCount;
+        mTables[tablesCount++] = { rootIndex++, 0 };
+    }
+    mTablesCount = tablesCount;
+
+    // Offsets inside of tables follow type and register, so consecutive registers end up next to each other
+    std::array<uint32_t, MaxParameters> tableParams;
+    uint32_t tableParamsCount = 0;
+
+    for (const auto& [idx, param] : mParams)
+    {
+        if (mLocations[idx].Type == RootParameterType::Table)
+        {
+            mLocations[idx].TableIndex = static_cast<uint8_t>(tableRemap[mLocations[idx].TableIndex]);
+            tableParams[tableParamsCount++] = idx;
+        }
+    }
+
+    std::sort(tableParams.begin(), tableParams.begin() + tableParamsCount, [this](uint32_t a, uint32_t b) {
+        const CD3DX12_DESCRIPTOR_RANGE1& rangeA = std::get<SingleRangeDesc>(mParams.at(a)).Range;
+        const CD3DX12_DESCRIPTOR_RANGE1& rangeB = std::get<SingleRangeDesc>(mParams.at(b)).Range;
+        return std::tie(mLocations[a].TableIndex, rangeA.RangeType, rangeA.BaseShaderRegister) < std::tie(mLocations[b].TableIndex, rangeB.RangeType, rangeB.BaseShaderRegister);
+        });
+
+    for (uint32_t i = 0; i < tableParamsCount; ++i)
+    {
+        RootParameterLocation& location = mLocations[tableParams[i]];
+        location.TableOffset = static_cast<uint8_t>(mTables[location.TableIndex].Size++);
+    }
+
+    if (hasBindlessTable)
+    {
+        mBindlessRootIndex = rootIndex++;
+    }
+
+    Assert(cost <= MaxRootSignatureCost); // Root signature is too big
+
+    mRootParametersCount = rootIndex;
+    mCost = cost;
+    mCompiled = true;
+}
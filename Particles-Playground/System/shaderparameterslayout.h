@@ -3,10 +3,42 @@
 class CommandList;
 class Sampler;
 
+// Raw and structured buffers can be bound as root descriptors, other resources always go through a descriptor table
+enum class ParameterResource : uint32_t
+{
+    Any = 0,
+    Buffer
+};
+
+enum class RootParameterType : uint8_t
+{
+    None = 0,
+    Constants,
+    Table,
+    CBV,
+    SRV,
+    UAV
+};
+
+// Place of a parameter in the compiled root signature, offset is used only by parameters inside a table
+struct RootParameterLocation
+{
+    RootParameterType Type = RootParameterType::None;
+    uint8_t RootIndex = 0;
+    uint8_t TableIndex = 0;
+    uint8_t TableOffset = 0;
+};
+
+struct RootTableDesc
+{
+    uint32_t RootIndex = 0;
+    uint32_t Size = 0;
+};
+
 struct RootParameters
 {
     std::vector<CD3DX12_ROOT_PARAMETER1> Parameters;
-    std::list<CD3DX12_DESCRIPTOR_RANGE1> Ranges;
+    std::vector<CD3DX12_DESCRIPTOR_RANGE1> Ranges;
     std::vector<CD3DX12_STATIC_SAMPLER_DESC> StaticSamplers;
 };
 
@@ -16,6 +48,7 @@ class ShaderParametersLayout
     {
         CD3DX12_DESCRIPTOR_RANGE1 Range;
         D3D12_SHADER_VISIBILITY Visibility;
+        ParameterResource Resource;
     };
 
     struct ConstantDesc
@@ -26,29 +59,68 @@ class ShaderParametersLayout
     using ParameterVar = std::variant<SingleRangeDesc, ConstantDesc>;
 
 public:
+    static const uint32_t MaxParameters = 16;
+    static const uint32_t MaxTables = 8;
+    static const uint32_t InvalidParameterIndex = std::numeric_limits<uint32_t>::max();
+
+    // Root signature can't take more than 64 DWORDs, but only first few of them are guaranteed to be kept in registers
+    static const uint32_t MaxRootSignatureCost = 64;
+    static const uint32_t FastRootSignatureCost = 16;
+
     ShaderParametersLayout() = default;
     ~ShaderParametersLayout() = default;
     ShaderParametersLayout(const ShaderParametersLayout&) = default;
     ShaderParametersLayout(ShaderParametersLayout&&) = default;
 
     ShaderParametersLayout& SetCBV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility);
-    ShaderParametersLayout& SetSRV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility);
-    ShaderParametersLayout& SetUAV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility);
+    ShaderParametersLayout& SetSRV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility, ParameterResource resource = ParameterResource::Any);
+    ShaderParametersLayout& SetUAV(uint32_t idx, uint32_t regIdx, D3D12_SHADER_VISIBILITY visibility, ParameterResource resource = ParameterResource::Any);
     ShaderParametersLayout& SetConstant(uint32_t idx, uint32_t regIdx, uint32_t size, D3D12_SHADER_VISIBILITY visibility);
     ShaderParametersLayout& SetStaticSampler(uint32_t regIdx, Sampler& desc, D3D12_SHADER_VISIBILITY visibility);
     ShaderParametersLayout& SetBindlessHeap(uint32_t idx);
 
+    // Names come from the reflection, they don't change the root signature
+    ShaderParametersLayout& SetParameterName(uint32_t idx, std::string_view name);
+    uint32_t GetParameterIndex(std::string_view name) const;
+    inline uint32_t GetParametersCount() const { return static_cast<uint32_t>(mParams.size()); }
+
+    // True if the layout has exactly these parameters, numbered in the given order
+    bool HasParameters(const std::vector<std::string>& names) const;
+
     [[nodiscard]] uint32_t Hash() const;
     [[nodiscard]] RootParameters GetParameters() const;
 
-    D3D12_SHADER_VISIBILITY GetVisibilityForParameterIndex(uint32_t idx);
+    D3D12_SHADER_VISIBILITY GetVisibilityForParameterIndex(uint32_t idx) const;
+
+    // Parameters are packed into the root signature when it's needed for the first time, indices passed to setters don't match root indices
+    const RootParameterLocation& GetRootParameterLocation(uint32_t idx) const;
+    const RootTableDesc& GetRootTable(uint32_t tableIdx) const;
+    uint32_t GetRootTablesCount() const;
+
+    // Size of the root signature in DWORDs
+    uint32_t GetRootSignatureCost() const;
 
     inline bool HasBindlessHeap() const { return mBindlessIndex != std::numeric_limits<uint32_t>::max(); }
-    inline uint32_t GetBindlessHeapIndex() const { return mBindlessIndex; }
+    uint32_t GetBindlessHeapIndex() const;
     
 private:
+    ShaderParametersLayout& SetParameter(uint32_t idx, const ParameterVar& param);
+    void Compile() const;
+
     uint32_t mBindlessIndex = std::numeric_limits<uint32_t>::max();
     std::map<uint32_t, ParameterVar> mParams;
+    std::map<uint32_t, std::string> mParamNames;
     std::vector<CD3DX12_STATIC_SAMPLER_DESC> mStaticSamplers;
 
+    // Compiled root signature
+    mutable bool mCompiled = false;
+    mutable std::array<RootParameterLocation, MaxParameters> mLocations = {};
+    mutable std::array<RootTableDesc, MaxTables> mTables = {};
+    mutable uint32_t mTablesCount = 0;
+    mutable uint32_t mRootParametersCount = 0;
+    mutable uint32_t mBindlessRootIndex = 0;
+    mutable uint32_t mCost = 0;
+
+    mutable std::optional<uint32_t> mHash;
+
 };
@@ -23,7 +23,7 @@ void TransientResourceAllocator::Free()
 void TransientResourceAllocator::PreUpdate()
 {
     Assert(mAllocator.GetAllocationNum() == 0);
-    Assert(mTransientResources.GetObjects().size() == 0);
+    Assert(mTransientResources.GetObjectsCount() == 0);
 
     const uint64_t currentFrameNum = Graphic::Get().GetCurrentFrameNumber();
     const uint32_t frameCount = Graphic::Get().GetFrameCount();
@@ -0,0 +1,81 @@
+#include "bitmapallocator.h"
+#include "memory.h"
+
+BitmapAllocator::BitmapAllocator(uint64_t startRange, uint64_t endRange)
+    : BaseAllocator(startRange, endRange)
+{
+    const uint64_t elementsCount = mEndRange - mStartRange;
+    const uint64_t wordsCount = Align(elementsCount, BitsPerWord) / BitsPerWord;
+    const uint64_t summaryWordsCount = Align(wordsCount, BitsPerWord) / BitsPerWord;
+
+    mWords.resize(wordsCount, 0);
+    mSummary.resize(summaryWordsCount, 0);
+
+    // Bits past the end are marked as allocated, so they are never returned
+    const uint32_t tailBits = static_cast<uint32_t>(elementsCount % BitsPerWord);
+    if (tailBits)
+    {
+        mWords.back() = FullWord << tailBits;
+    }
+
+    const uint32_t tailWords = static_cast<uint32_t>(wordsCount % BitsPerWord);
+    if (tailWords)
+    {
+        mSummary.back() = FullWord << tailWords;
+    }
+}
+
+Range BitmapAllocator::Allocate(uint32_t size, uint32_t alignment /*= 1*/)
+{
+    Assert(size == 1 && alignment == 1);
+
+    Range result{};
+
+    while (mFirstFreeSummaryWord < mSummary.size() && mSummary[mFirstFreeSummaryWord] == FullWord)
+    {
+        ++mFirstFreeSummaryWord;
+    }
+
+    if (mFirstFreeSummaryWord == mSummary.size()) // all elements are allocated
+    {
+        return result;
+    }
+
+    uint64_t& summary = mSummary[mFirstFreeSummaryWord];
+    const uint32_t wordIndex = mFirstFreeSummaryWord * BitsPerWord + FindFirstSetBit(~summary);
+
+    uint64_t& word = mWords[wordIndex];
+    const uint32_t bitIndex = FindFirstSetBit(~word);
+
+    word |= 1ULL << bitIndex;
+    if (word == FullWord)
+    {
+        summary |= 1ULL << (wordIndex % BitsPerWord);
+    }
+
+    result.Start = mStartRange + static_cast<uint64_t>(wordIndex) * BitsPerWord + bitIndex;
+    result.Size = 1;
+
+    ++mAllocationNum;
+    return result;
+}
+
+void BitmapAllocator::Free(Range& range)
+{
+    if (!IsAllocationValid(range)) { return; }
+
+    Assert(range.Size == 1);
+
+    const uint64_t element = range.Start - mStartRange;
+    const uint32_t wordIndex = static_cast<uint32_t>(element / BitsPerWord);
+    const uint32_t summaryIndex = wordIndex / BitsPerWord;
+
+    Assert(mWords[wordIndex] & (1ULL << (element % BitsPerWord))); // element isn't allocated
+
+    mWords[wordIndex] &= ~(1ULL << (element % BitsPerWord));
+    mSummary[summaryIndex] &= ~(1ULL << (wordIndex % BitsPerWord));
+    mFirstFreeSummaryWord = std::min(mFirstFreeSummaryWord, summaryIndex);
+
+    --mAllocationNum;
+    range.Invalidate();
+}
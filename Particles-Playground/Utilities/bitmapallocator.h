@@ -0,0 +1,25 @@
+#pragma once
+#include "allocatorcommon.h"
+
+// Allocator for single elements, e.g. descriptors. Every element has a bit which is set while it's allocated.
+// Summary bitmap keeps a bit per word which is set when the word is full, so a free element is found with two bit scans.
+class BitmapAllocator : public BaseAllocator
+{
+    static const uint32_t BitsPerWord = 64;
+    static const uint64_t FullWord = std::numeric_limits<uint64_t>::max();
+
+public:
+    BitmapAllocator(uint64_t startRange, uint64_t endRange);
+
+    // Only size and alignment equal to one are supported
+    virtual Range Allocate(uint32_t size, uint32_t alignment = 1) override;
+    virtual void Free(Range& range) override;
+
+private:
+    std::vector<uint64_t> mWords;
+    std::vector<uint64_t> mSummary;
+
+    // All summary words before this one are full
+    uint32_t mFirstFreeSummaryWord = 0;
+
+};
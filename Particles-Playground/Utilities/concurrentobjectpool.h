@@ -0,0 +1,102 @@
+#pragma once
+#include "Utilities/objectpool.h"
+
+// Object pool which allows allocating and freeing objects from many threads without locks.
+// Free slots are kept on a stack with a tagged head, so a slot popped and pushed again in the meantime can't break the CAS (ABA).
+// Freed objects are invalidated right away, but destroyed in ProcessPendingObjects, which is supposed to be called once per frame.
+// New objects show up in GetObjects and GetObjectsView after ProcessPendingObjects, GetObject can be used right after the allocation.
+template<typename ObjectType>
+class ConcurrentObjectPool
+{
+    static_assert(std::is_base_of_v<IObject<ObjectType>, ObjectType>, "ObjectType has to derive from IObject");
+
+    using IndexType = typename ObjectHandle<ObjectType>::InnerType;
+
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+    // Slot's state keeps its generation and whether there is a live object in it
+    static constexpr uint32_t AliveBit = ObjectHandle<ObjectType>::GenerationMax + 1;
+
+public:
+    using DefaultPredicate = typename ObjectPool<ObjectType>::DefaultPredicate;
+
+    static const uint32_t DefaultPageSize = 64;
+
+    ConcurrentObjectPool(uint32_t numObjects, uint32_t pageSize = DefaultPageSize)
+        : mNumObjects(numObjects)
+        , mPageSize(std::min(pageSize, numObjects))
+    {
+        Assert(mNumObjects != 0 && mNumObjects <= ObjectHandle<ObjectType>::IndexMax); // Number of objects is too big for current Object's Handle or equal zero
+        Assert(mPageSize != 0);
+    }
+
+    ConcurrentObjectPool(const ConcurrentObjectPool&) = delete;
+    ConcurrentObjectPool(ConcurrentObjectPool&&) = delete;
+
+    ConcurrentObjectPool& operator=(const ConcurrentObjectPool&) = delete;
+    ConcurrentObjectPool& operator=(ConcurrentObjectPool&&) = delete;
+
+    void Init();
+    void Free();
+
+    // Thread-safe
+    template<typename... Args>
+    [[nodiscard]] ObjectHandle<ObjectType> AllocateObject(Args&&... args);
+
+    // Thread-safe, object is destroyed in the next ProcessPendingObjects
+    void FreeObject(ObjectHandle<ObjectType>& handle);
+
+    // Thread-safe
+    ObjectType* GetObject(ObjectHandle<ObjectType> handle);
+    bool ValidateHandle(ObjectHandle<ObjectType> handle) const;
+
+    // Has to be called from a single thread, can't run together with GetObjects or GetObjectsView
+    void ProcessPendingObjects();
+
+    template<typename Pred = DefaultPredicate>
+    [[nodiscard]] std::vector<ObjectType*> GetObjects(Pred predicate = {}) const;
+
+    template<typename Pred = DefaultPredicate>
+    [[nodiscard]] ObjectPoolView<ObjectType, Pred> GetObjectsView(Pred predicate = {}) const;
+
+    inline uint32_t GetObjectsCount() const { return static_cast<uint32_t>(mDenseObjects.size()); }
+
+private:
+    uint32_t PopFreeIndex();
+    void PushFreeIndex(uint32_t index);
+    void PushPendingIndex(std::atomic<uint32_t>& list, std::atomic<uint32_t>* links, uint32_t index);
+    ObjectType* GetOrAllocatePage(uint32_t pageIndex);
+
+    inline ObjectType* GetSlot(uint32_t index) const { return &mPages[index / mPageSize].load(std::memory_order_acquire)[index % mPageSize]; }
+
+    static inline uint64_t PackFreeHead(uint32_t index, uint32_t tag) { return (static_cast<uint64_t>(tag) << 32) | index; }
+    static inline uint32_t GetFreeHeadIndex(uint64_t head) { return static_cast<uint32_t>(head); }
+    static inline uint32_t GetFreeHeadTag(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+    uint32_t mNumObjects = 0;
+    uint32_t mPageSize = 0;
+
+    // Pages are allocated by the first thread which needs them and are kept until the pool is freed
+    std::unique_ptr<std::atomic<ObjectType*>[]> mPages;
+    std::unique_ptr<std::atomic<uint32_t>[]> mStates;
+
+    // Links of the free stack and the pending frees list, a slot is never on both of them
+    std::unique_ptr<std::atomic<uint32_t>[]> mFreeLinks;
+    std::unique_ptr<std::atomic<uint32_t>[]> mCreatedLinks;
+
+    // Index and tag of the top free slot, tag is bumped with every change
+    std::atomic<uint64_t> mFreeHead = PackFreeHead(InvalidIndex, 0);
+
+    // Slots which have never been used are taken in order, before that the free stack is empty
+    std::atomic<uint32_t> mNextUnusedIndex = 0;
+
+    // Lists of slots waiting for ProcessPendingObjects
+    std::atomic<uint32_t> mPendingCreated = InvalidIndex;
+    std::atomic<uint32_t> mPendingFreed = InvalidIndex;
+
+    // Live objects are kept packed for iteration, only touched by ProcessPendingObjects
+    std::vector<ObjectType*> mDenseObjects;
+    std::vector<uint32_t> mDenseIndices;
+};
+
+#include "Utilities/concurrentobjectpool.inl"
@@ -0,0 +1,261 @@
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::Init()
+{
+    const uint32_t pagesCount = Align(mNumObjects, mPageSize) / mPageSize;
+
+    // Memory for objects is allocated in pages on demand, metadata is allocated up front so it never moves
+    mPages = std::make_unique<std::atomic<ObjectType*>[]>(pagesCount);
+    for (uint32_t i = 0; i < pagesCount; ++i)
+    {
+        mPages[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    mStates = std::make_unique<std::atomic<uint32_t>[]>(mNumObjects);
+    mFreeLinks = std::make_unique<std::atomic<uint32_t>[]>(mNumObjects);
+    mCreatedLinks = std::make_unique<std::atomic<uint32_t>[]>(mNumObjects);
+    for (uint32_t i = 0; i < mNumObjects; ++i)
+    {
+        mStates[i].store(0, std::memory_order_relaxed);
+        mFreeLinks[i].store(InvalidIndex, std::memory_order_relaxed);
+        mCreatedLinks[i].store(InvalidIndex, std::memory_order_relaxed);
+    }
+
+    mDenseObjects.reserve(mNumObjects);
+    mDenseIndices.resize(mNumObjects, InvalidIndex);
+}
+
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::Free()
+{
+    // Destroy objects freed during the last frame
+    ProcessPendingObjects();
+
+    // Make sure all objects were properly cleanup before calling the Free function
+    Assert(mDenseObjects.empty());
+
+    const uint32_t pagesCount = Align(mNumObjects, mPageSize) / mPageSize;
+    for (uint32_t i = 0; i < pagesCount; ++i)
+    {
+        std::free(mPages[i].exchange(nullptr));
+    }
+
+    mPages.reset();
+    mStates.reset();
+    mFreeLinks.reset();
+    mCreatedLinks.reset();
+    mDenseObjects.clear();
+    mDenseIndices.clear();
+
+    mFreeHead = PackFreeHead(InvalidIndex, 0);
+    mNextUnusedIndex = 0;
+}
+
+template<typename ObjectType>
+template<typename... Args>
+ObjectHandle<ObjectType> ConcurrentObjectPool<ObjectType>::AllocateObject(Args&&... args)
+{
+    uint32_t index = PopFreeIndex();
+
+    if (index == InvalidIndex)
+    {
+        index = mNextUnusedIndex.load(std::memory_order_relaxed);
+        do
+        {
+            if (index == mNumObjects)
+            {
+                Assert(false); // Pool is full
+                return {};
+            }
+        } while (!mNextUnusedIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+        GetOrAllocatePage(index / mPageSize);
+    }
+
+    // Slot belongs only to this thread now, call the constructor with given arguments
+    ObjectType* object = new (GetSlot(index)) (ObjectType) (std::forward<Args>(args)...);
+    object->mIndex = static_cast<IndexType>(index);
+
+    const uint32_t generation = mStates[index].load(std::memory_order_relaxed);
+    mStates[index].store(generation | AliveBit, std::memory_order_release);
+
+    PushPendingIndex(mPendingCreated, mCreatedLinks.get(), index);
+
+    return ObjectHandle<ObjectType>(static_cast<IndexType>(index), static_cast<IndexType>(generation));
+}
+
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::FreeObject(ObjectHandle<ObjectType>& handle)
+{
+    if (handle.GetHandle() == ObjectHandle<ObjectType>::Invalid) { return; }
+
+    const uint32_t index = handle.GetIndex();
+    Assert(index < mNumObjects);
+
+    // Bumping the generation invalidates all handles at once, only one of the threads freeing the same object can succeed
+    uint32_t expectedState = handle.GetGeneration() | AliveBit;
+    const uint32_t nextGeneration = (handle.GetGeneration() + 1) & ObjectHandle<ObjectType>::GenerationMax;
+
+    if (mStates[index].compare_exchange_strong(expectedState, nextGeneration, std::memory_order_acq_rel))
+    {
+        PushPendingIndex(mPendingFreed, mFreeLinks.get(), index);
+    }
+    else
+    {
+        Assert(false); // Object has been already freed
+    }
+
+    // Return invalid handle
+    handle = {};
+}
+
+template<typename ObjectType>
+ObjectType* ConcurrentObjectPool<ObjectType>::GetObject(ObjectHandle<ObjectType> handle)
+{
+    Assert(ValidateHandle(handle));
+
+    return GetSlot(handle.GetIndex());
+}
+
+template<typename ObjectType>
+bool ConcurrentObjectPool<ObjectType>::ValidateHandle(ObjectHandle<ObjectType> handle) const
+{
+    if( !(handle.GetIndex() < mNumObjects) ) { return false; }
+    if( mStates[handle.GetIndex()].load(std::memory_order_acquire) != (handle.GetGeneration() | AliveBit) ) { return false; }
+    return true;
+}
+
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::ProcessPendingObjects()
+{
+    // Frees have to be taken first, every freed object has been created before, so it's either packed already or on the created list
+    const uint32_t firstFreed = mPendingFreed.exchange(InvalidIndex, std::memory_order_acquire);
+    const uint32_t firstCreated = mPendingCreated.exchange(InvalidIndex, std::memory_order_acquire);
+
+    const uint32_t firstNewObject = static_cast<uint32_t>(mDenseObjects.size());
+    for (uint32_t index = firstCreated; index != InvalidIndex; index = mCreatedLinks[index].load(std::memory_order_relaxed))
+    {
+        mDenseObjects.push_back(GetSlot(index));
+    }
+
+    // List is in reverse order, keep objects in the order they were allocated
+    std::reverse(mDenseObjects.begin() + firstNewObject, mDenseObjects.end());
+    for (uint32_t i = firstNewObject; i < mDenseObjects.size(); ++i)
+    {
+        mDenseIndices[mDenseObjects[i]->mIndex] = i;
+    }
+
+    for (uint32_t index = firstFreed; index != InvalidIndex;)
+    {
+        const uint32_t nextIndex = mFreeLinks[index].load(std::memory_order_relaxed);
+
+        // Move the last live object into the freed position to keep them packed
+        const uint32_t denseIndex = mDenseIndices[index];
+        ObjectType* lastObject = mDenseObjects.back();
+        mDenseObjects[denseIndex] = lastObject;
+        mDenseIndices[lastObject->mIndex] = denseIndex;
+        mDenseObjects.pop_back();
+        mDenseIndices[index] = InvalidIndex;
+
+        // Call destructor on the object
+        ObjectType* object = GetSlot(index);
+        object->~ObjectType();
+        std::memset(static_cast<void*>(object), 0xFE, sizeof(ObjectType));
+
+        // Slot can be reused by other threads from now on
+        PushFreeIndex(index);
+
+        index = nextIndex;
+    }
+}
+
+template<typename ObjectType>
+template<typename Pred>
+std::vector<ObjectType*> ConcurrentObjectPool<ObjectType>::GetObjects(Pred predicate) const
+{
+    std::vector<ObjectType*> result;
+    result.reserve(mDenseObjects.size());
+
+    for (ObjectType* object : GetObjectsView(std::move(predicate)))
+    {
+        result.push_back(object);
+    }
+
+    return result;
+}
+
+template<typename ObjectType>
+template<typename Pred>
+ObjectPoolView<ObjectType, Pred> ConcurrentObjectPool<ObjectType>::GetObjectsView(Pred predicate) const
+{
+    return ObjectPoolView<ObjectType, Pred>(mDenseObjects.data(), mDenseObjects.data() + mDenseObjects.size(), std::move(predicate));
+}
+
+template<typename ObjectType>
+uint32_t ConcurrentObjectPool<ObjectType>::PopFreeIndex()
+{
+    uint64_t head = mFreeHead.load(std::memory_order_acquire);
+
+    while (GetFreeHeadIndex(head) != InvalidIndex)
+    {
+        // Link can be outdated if the slot was popped in the meantime, tag makes the CAS fail in that case
+        const uint32_t index = GetFreeHeadIndex(head);
+        const uint32_t nextIndex = mFreeLinks[index].load(std::memory_order_relaxed);
+
+        if (mFreeHead.compare_exchange_weak(head, PackFreeHead(nextIndex, GetFreeHeadTag(head) + 1), std::memory_order_acquire))
+        {
+            return index;
+        }
+    }
+
+    return InvalidIndex;
+}
+
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::PushFreeIndex(uint32_t index)
+{
+    uint64_t head = mFreeHead.load(std::memory_order_relaxed);
+
+    do
+    {
+        mFreeLinks[index].store(GetFreeHeadIndex(head), std::memory_order_relaxed);
+    } while (!mFreeHead.compare_exchange_weak(head, PackFreeHead(index, GetFreeHeadTag(head) + 1), std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<typename ObjectType>
+void ConcurrentObjectPool<ObjectType>::PushPendingIndex(std::atomic<uint32_t>& list, std::atomic<uint32_t>* links, uint32_t index)
+{
+    // Pending lists are only pushed to and taken as a whole, so they don't suffer from ABA
+    uint32_t head = list.load(std::memory_order_relaxed);
+
+    do
+    {
+        links[index].store(head, std::memory_order_relaxed);
+    } while (!list.compare_exchange_weak(head, index, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<typename ObjectType>
+ObjectType* ConcurrentObjectPool<ObjectType>::GetOrAllocatePage(uint32_t pageIndex)
+{
+    ObjectType* page = mPages[pageIndex].load(std::memory_order_acquire);
+    if (page)
+    {
+        return page;
+    }
+
+    const uint32_t firstIndex = pageIndex * mPageSize;
+    const uint32_t objectsCount = std::min(mPageSize, mNumObjects - firstIndex);
+
+    const uint32_t size = objectsCount * sizeof(ObjectType);
+    void* memory = std::malloc(size);
+    std::memset(memory, 0xFE, size);
+
+    // Other thread could have allocated the same page in the meantime, its memory is used then
+    ObjectType* newPage = reinterpret_cast<ObjectType*>(memory);
+    if (mPages[pageIndex].compare_exchange_strong(page, newPage, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        return newPage;
+    }
+
+    std::free(memory);
+    return page;
+}
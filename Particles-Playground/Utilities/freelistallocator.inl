@@ -30,18 +30,12 @@ void FreeListAllocator<AllocStrategy>::Free(Range& range)
     }
     else if (left == mFreeList.end() && right == mFreeList.rend()) // we can't merge with any block
     {
+        // Keep free list sorted by start, so neighbouring blocks can be merged later
         auto firstGreater = std::find_if(mFreeList.begin(), mFreeList.end(), [start](const Range& block) {
-            return start > block.Start;
+            return block.Start > start;
             });
 
-        if (firstGreater != mFreeList.end())
-        {
-            mFreeList.insert(firstGreater, { start,size });
-        }
-        else
-        {
-            mFreeList.push_front({ start, size });
-        }
+        mFreeList.insert(firstGreater, { start, size });
     }
 
     --mAllocationNum;
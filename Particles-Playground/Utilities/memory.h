@@ -19,6 +19,19 @@ constexpr T1 Align(T1 number, T2 alignment)
     return ((number + (alignment - 1)) / alignment) * alignment;
 }
 
+constexpr uint32_t NextPow2(uint32_t number)
+{
+    if (number <= 1) { return 1; }
+
+    number -= 1;
+    number |= number >> 1;
+    number |= number >> 2;
+    number |= number >> 4;
+    number |= number >> 8;
+    number |= number >> 16;
+    return number + 1;
+}
+
 inline uint32_t HashRange(const uint32_t* start, const uint32_t* end)
 {
     uint32_t seed = 0;
@@ -32,3 +45,13 @@ inline uint32_t HashRange(const uint32_t* start, const uint32_t* end)
 
     return seed;
 }
+
+// Index of the lowest set bit, number can't be zero
+inline uint32_t FindFirstSetBit(uint64_t number)
+{
+    Assert(number != 0);
+
+    unsigned long index = 0;
+    _BitScanForward64(&index, number);
+    return static_cast<uint32_t>(index);
+}
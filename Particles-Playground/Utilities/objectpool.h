@@ -57,10 +57,14 @@ protected:
 template<typename ObjectType>
 class ObjectPool;
 
+template<typename ObjectType>
+class ConcurrentObjectPool;
+
 template<typename ObjectType>
 class IObject
 {
     friend class ObjectPool<ObjectType>;
+    friend class ConcurrentObjectPool<ObjectType>;
     
 public:
     using HandleType = HandleBase<uint32_t, 24>;
@@ -87,6 +91,72 @@ private:
 template<typename ObjectType>
 using ObjectHandle = typename IObject<ObjectType>::HandleType;
 
+// Non-owning range over pool's live objects which satisfy the predicate, doesn't allocate.
+// Allocating or freeing objects of the pool invalidates the view.
+template<typename ObjectType, typename Pred>
+class ObjectPoolView
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(ObjectType* const* current, ObjectType* const* end, const Pred* predicate)
+            : mCurrent(current), mEnd(end), mPredicate(predicate)
+        {
+            SkipRejected();
+        }
+
+        inline ObjectType* operator*() const { return *mCurrent; }
+        inline bool operator==(const Iterator& rhs) const { return mCurrent == rhs.mCurrent; }
+        inline bool operator!=(const Iterator& rhs) const { return mCurrent != rhs.mCurrent; }
+
+        Iterator& operator++()
+        {
+            ++mCurrent;
+            SkipRejected();
+            return *this;
+        }
+
+    private:
+        void SkipRejected()
+        {
+            while (mCurrent != mEnd && !(*mPredicate)(*mCurrent))
+            {
+                ++mCurrent;
+            }
+        }
+
+        ObjectType* const* mCurrent = nullptr;
+        ObjectType* const* mEnd = nullptr;
+        const Pred* mPredicate = nullptr;
+    };
+
+    ObjectPoolView(ObjectType* const* begin, ObjectType* const* end, Pred predicate)
+        : mBegin(begin), mEnd(end), mPredicate(std::move(predicate))
+    { }
+
+    inline Iterator begin() const { return Iterator(mBegin, mEnd, &mPredicate); }
+    inline Iterator end() const { return Iterator(mEnd, mEnd, &mPredicate); }
+
+    inline bool empty() const { return begin() == end(); }
+
+    // Not cached, evaluates the predicate for all live objects, so callers should count once and keep the result
+    uint32_t CountMatching() const
+    {
+        uint32_t count = 0;
+        for (Iterator it = begin(); it != end(); ++it)
+        {
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    ObjectType* const* mBegin = nullptr;
+    ObjectType* const* mEnd = nullptr;
+    Pred mPredicate;
+};
+
 template<typename ObjectType>
 class ObjectPool
 {
@@ -95,6 +165,9 @@ class ObjectPool
 
     using IndexType = typename ObjectHandle<ObjectType>::InnerType;
 
+    static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+public:
     struct DefaultPredicate
     {
         bool operator()(ObjectType* object) const
@@ -103,12 +176,16 @@ class ObjectPool
         }
     };
 
-public:
-    ObjectPool(uint32_t numObjects)
+    static const uint32_t DefaultPageSize = 64;
+
+    // Objects are allocated in pages of pageSize objects when needed, numObjects is only the upper limit.
+    // Pages never move, so pointers to objects stay valid until the object is freed.
+    ObjectPool(uint32_t numObjects, uint32_t pageSize = DefaultPageSize)
         : mNumObjects(numObjects)
-        , mAllocator(0, numObjects)
+        , mPageSize(std::min(pageSize, numObjects))
     { 
         Assert(mNumObjects != 0 && mNumObjects <= ObjectHandle<ObjectType>::IndexMax); // Number of objects is too big for current Object's Handle or equal zero
+        Assert(mPageSize != 0);
     }
 
     void Init();
@@ -121,15 +198,43 @@ public:
     ObjectType* GetObject(ObjectHandle<ObjectType> handle);
     bool ValidateHandle(ObjectHandle<ObjectType> handle) const;
 
+    // Returns memory of pages without any live objects, handles to objects which lived there stay invalid
+    void ReleaseEmptyPages();
+
     template<typename Pred = DefaultPredicate>
     [[nodiscard]] std::vector<ObjectType*> GetObjects(Pred predicate = {}) const;
-    
+
+    // Iterates only over live objects, in no particular order
+    template<typename Pred = DefaultPredicate>
+    [[nodiscard]] ObjectPoolView<ObjectType, Pred> GetObjectsView(Pred predicate = {}) const;
+
+    inline uint32_t GetObjectsCount() const { return static_cast<uint32_t>(mDenseObjects.size()); }
+    inline uint32_t GetAllocatedPagesCount() const { return mAllocatedPagesCount; }
+
 private:
+    bool AllocatePage();
+    void FreePage(uint32_t pageIndex);
+
+    inline ObjectType* GetSlot(uint32_t index) const { return &mPages[index / mPageSize][index % mPageSize]; }
+
+    void SetNextFreeIndex(uint32_t index, uint32_t nextFreeIndex);
+    uint32_t GetNextFreeIndex(uint32_t index) const;
+
     uint32_t mNumObjects = 0;
-    FreeListAllocator<FirstFitStrategy> mAllocator;
-    ObjectType* mObjectMemory = nullptr;
+    uint32_t mPageSize = 0;
+    uint32_t mAllocatedPagesCount = 0;
+
+    // Not allocated pages are null, metadata below grows with the highest allocated page and never shrinks
+    std::vector<ObjectType*> mPages;
+    std::vector<uint32_t> mPageObjectsCount;
     std::vector<uint8_t> mGenerations;
-    std::vector<bool> mValidObjects;
+
+    // Live objects are kept packed (sparse set), mDenseIndices maps object's index to its position in mDenseObjects
+    std::vector<ObjectType*> mDenseObjects;
+    std::vector<uint32_t> mDenseIndices;
+
+    // Free slots form a stack, index of the next free slot is stored in the memory of the free slot itself
+    uint32_t mFirstFreeIndex = InvalidIndex;
 };
 
 #include "Utilities/objectpool.inl"
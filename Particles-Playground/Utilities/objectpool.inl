@@ -1,44 +1,49 @@
-
 template<typename ObjectType>
 void ObjectPool<ObjectType>::Init()
 {
-    // Allocate memory for objects
-    uint32_t size = mNumObjects * sizeof(ObjectType);
-    void* memory = std::malloc(size);
-    std::memset(memory, 0xFE, size);
-
-    mObjectMemory = reinterpret_cast<ObjectType*>(memory);
- 
-    mGenerations.resize(mNumObjects);
-    mValidObjects.resize(mNumObjects);
+    // Memory for objects is allocated in pages on demand
+    mPages.resize(Align(mNumObjects, mPageSize) / mPageSize, nullptr);
+    mPageObjectsCount.resize(mPages.size(), 0);
 }
 
 template<typename ObjectType>
 void ObjectPool<ObjectType>::Free()
 {
     // Make sure all objects were properly cleanup before calling the Free function
-    Assert(std::none_of(mValidObjects.cbegin(), mValidObjects.cend(), [](bool elem) { return elem; }));
+    Assert(mDenseObjects.empty());
 
-    std::free(mObjectMemory);
-    mObjectMemory = nullptr;
+    for (uint32_t i = 0; i < mPages.size(); ++i)
+    {
+        if (mPages[i])
+        {
+            FreePage(i);
+        }
+    }
+    mFirstFreeIndex = InvalidIndex;
 }
 
 template<typename ObjectType>
 template<typename... Args>
 ObjectHandle<ObjectType> ObjectPool<ObjectType>::AllocateObject(Args&&... args)
 {
-    Range allocation = mAllocator.Allocate(1);
-    Assert(allocation.IsValid());
+    if (mFirstFreeIndex == InvalidIndex)
+    {
+        const bool pageAllocated = AllocatePage();
+        Assert(pageAllocated); // Pool is full
+    }
 
-    // Convert allocation to index
-    const IndexType index = static_cast<IndexType>(allocation.Start);
+    // Pop a free slot
+    const IndexType index = static_cast<IndexType>(mFirstFreeIndex);
+    mFirstFreeIndex = GetNextFreeIndex(index);
 
     // Call the constructor with given arguments
-    new (&mObjectMemory[index]) (ObjectType) (std::forward<Args>(args)...);
-    ObjectType& object = mObjectMemory[index];
+    new (GetSlot(index)) (ObjectType) (std::forward<Args>(args)...);
+    ObjectType& object = *GetSlot(index);
     object.mIndex = index;
+    ++mPageObjectsCount[index / mPageSize];
 
-    mValidObjects[index] = true;
+    mDenseIndices[index] = static_cast<uint32_t>(mDenseObjects.size());
+    mDenseObjects.push_back(&object);
 
     return ObjectHandle<ObjectType>(index, mGenerations[index]);
 }
@@ -50,21 +55,26 @@ void ObjectPool<ObjectType>::FreeObject(ObjectHandle<ObjectType>& handle)
 
     Assert(ValidateHandle(handle));
 
+    // Move the last live object into the freed position to keep them packed
+    const uint32_t denseIndex = mDenseIndices[handle.GetIndex()];
+    ObjectType* lastObject = mDenseObjects.back();
+    mDenseObjects[denseIndex] = lastObject;
+    mDenseIndices[lastObject->mIndex] = denseIndex;
+    mDenseObjects.pop_back();
+    mDenseIndices[handle.GetIndex()] = InvalidIndex;
+
     // Call destructor on the object
-    ObjectType& object = mObjectMemory[handle.GetIndex()];
+    ObjectType& object = *GetSlot(handle.GetIndex());
     object.~ObjectType();
     std::memset(&object, 0xFE, sizeof(ObjectType));
-
-    mValidObjects[handle.GetIndex()] = false;
+    --mPageObjectsCount[handle.GetIndex() / mPageSize];
 
     // Increase object's generation to mark that existing handles to this object are no longer valid
     ++mGenerations[handle.GetIndex()];
 
-    // Free the allocation
-    Range allocation;
-    allocation.Start = handle.GetIndex();
-    allocation.Size = 1;
-    mAllocator.Free(allocation);
+    // Push the slot back on the free stack
+    SetNextFreeIndex(handle.GetIndex(), mFirstFreeIndex);
+    mFirstFreeIndex = handle.GetIndex();
 
     // Return invalid handle
     handle = {};
@@ -75,15 +85,14 @@ ObjectType* ObjectPool<ObjectType>::GetObject(ObjectHandle<ObjectType> handle)
 {
     Assert(ValidateHandle(handle));
 
-    ObjectType& object = mObjectMemory[handle.GetIndex()];
-    return &object;
+    return GetSlot(handle.GetIndex());
 }
 
 template<typename ObjectType>
 bool ObjectPool<ObjectType>::ValidateHandle(ObjectHandle<ObjectType> handle) const
 {
-    if( !(handle.GetIndex() < mNumObjects) ) { return false; }
-    if( !mValidObjects[handle.GetIndex()] ) { return false; }
+    if( !(handle.GetIndex() < mDenseIndices.size()) ) { return false; }
+    if( mDenseIndices[handle.GetIndex()] == InvalidIndex ) { return false; }
     if( mGenerations[handle.GetIndex()] != handle.GetGeneration() ) { return false; }
     return true;
 }
@@ -93,20 +102,138 @@ template<typename Pred>
 std::vector<ObjectType*> ObjectPool<ObjectType>::GetObjects(Pred predicate) const
 {
     std::vector<ObjectType*> result;
-    result.reserve(mAllocator.GetAllocationNum());
+    result.reserve(mDenseObjects.size());
 
-    for(uint32_t i = 0; i < mNumObjects; ++i)
+    for (ObjectType* object : GetObjectsView(std::move(predicate)))
     {
-        if (result.size() == mAllocator.GetAllocationNum()) { break; }
+        result.push_back(object);
+    }
 
-        ObjectType* object = &mObjectMemory[i];
-        const bool isValid = mValidObjects[i];
-        if(isValid && predicate(object))
+    return result;
+}
+
+template<typename ObjectType>
+template<typename Pred>
+ObjectPoolView<ObjectType, Pred> ObjectPool<ObjectType>::GetObjectsView(Pred predicate) const
+{
+    return ObjectPoolView<ObjectType, Pred>(mDenseObjects.data(), mDenseObjects.data() + mDenseObjects.size(), std::move(predicate));
+}
+
+template<typename ObjectType>
+void ObjectPool<ObjectType>::SetNextFreeIndex(uint32_t index, uint32_t nextFreeIndex)
+{
+    static_assert(sizeof(ObjectType) >= sizeof(uint32_t), "Free slot has to be able to store the index of the next one");
+    std::memcpy(static_cast<void*>(GetSlot(index)), &nextFreeIndex, sizeof(uint32_t));
+}
+
+template<typename ObjectType>
+uint32_t ObjectPool<ObjectType>::GetNextFreeIndex(uint32_t index) const
+{
+    uint32_t nextFreeIndex;
+    std::memcpy(&nextFreeIndex, static_cast<const void*>(GetSlot(index)), sizeof(uint32_t));
+    return nextFreeIndex;
+}
+
+template<typename ObjectType>
+void ObjectPool<ObjectType>::ReleaseEmptyPages()
+{
+    std::vector<bool> releasedPages(mPages.size(), false);
+    bool anyReleased = false;
+
+    for (uint32_t i = 0; i < mPages.size(); ++i)
+    {
+        releasedPages[i] = mPages[i] && mPageObjectsCount[i] == 0;
+        anyReleased |= releasedPages[i];
+    }
+
+    if (!anyReleased)
+    {
+        return;
+    }
+
+    // Rebuild the free stack without slots of released pages, it has to be done while their memory is still there
+    uint32_t firstFreeIndex = InvalidIndex;
+    uint32_t lastFreeIndex = InvalidIndex;
+
+    for (uint32_t index = mFirstFreeIndex; index != InvalidIndex;)
+    {
+        const uint32_t nextIndex = GetNextFreeIndex(index);
+
+        if (!releasedPages[index / mPageSize])
         {
-            result.push_back(object);
+            if (lastFreeIndex == InvalidIndex)
+            {
+                firstFreeIndex = index;
+            }
+            else
+            {
+                SetNextFreeIndex(lastFreeIndex, index);
+            }
+            lastFreeIndex = index;
         }
+
+        index = nextIndex;
     }
 
-    return result;
+    if (lastFreeIndex != InvalidIndex)
+    {
+        SetNextFreeIndex(lastFreeIndex, InvalidIndex);
+    }
+    mFirstFreeIndex = firstFreeIndex;
+
+    for (uint32_t i = 0; i < mPages.size(); ++i)
+    {
+        if (releasedPages[i])
+        {
+            FreePage(i);
+        }
+    }
+}
+
+template<typename ObjectType>
+bool ObjectPool<ObjectType>::AllocatePage()
+{
+    // Lowest pages are used first, so objects stay close to each other
+    auto page = std::find(mPages.begin(), mPages.end(), nullptr);
+    if (page == mPages.end())
+    {
+        return false;
+    }
+
+    const uint32_t pageIndex = static_cast<uint32_t>(std::distance(mPages.begin(), page));
+    const uint32_t firstIndex = pageIndex * mPageSize;
+    const uint32_t objectsCount = std::min(mPageSize, mNumObjects - firstIndex);
+
+    const uint32_t size = objectsCount * sizeof(ObjectType);
+    void* memory = std::malloc(size);
+    std::memset(memory, 0xFE, size);
+
+    *page = reinterpret_cast<ObjectType*>(memory);
+    ++mAllocatedPagesCount;
+
+    // Generations of released pages are kept, so old handles can't become valid again
+    if (mGenerations.size() < firstIndex + objectsCount)
+    {
+        mGenerations.resize(firstIndex + objectsCount, 0);
+        mDenseIndices.resize(firstIndex + objectsCount, InvalidIndex);
+    }
+
+    // Push slots in reverse, so the lowest indices are allocated first
+    for (uint32_t i = firstIndex + objectsCount; i > firstIndex; --i)
+    {
+        SetNextFreeIndex(i - 1, mFirstFreeIndex);
+        mFirstFreeIndex = i - 1;
+    }
+
+    return true;
 }
 
+template<typename ObjectType>
+void ObjectPool<ObjectType>::FreePage(uint32_t pageIndex)
+{
+    Assert(mPageObjectsCount[pageIndex] == 0);
+
+    std::free(mPages[pageIndex]);
+    mPages[pageIndex] = nullptr;
+    --mAllocatedPagesCount;
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include "Utilities/simd.h"
 
+// Every generator has a SIMD version giving the same results per lane as the scalar one and shaders
 namespace RngType
 {
     struct PCG
@@ -10,6 +12,13 @@ namespace RngType
             uint32_t word = ((state >> ((state >> 28U) + 4U)) ^ state) * 277803737U;
             return (word >> 22U) ^ word;
         }
+
+        Simd::UInt GetRandom(Simd::UInt seed)
+        {
+            Simd::UInt state = seed * Simd::UInt(747796405U) + Simd::UInt(2891336453U);
+            Simd::UInt word = ((state >> ((state >> 28) + Simd::UInt(4U))) ^ state) * Simd::UInt(277803737U);
+            return (word >> 22) ^ word;
+        }
     };
 
     struct xxHash32
@@ -27,9 +36,56 @@ namespace RngType
             h32 = PRIME32_3 * (h32 ^ (h32 >> 13));
             return h32 ^ (h32 >> 16);
         }
+
+        // Two input variant, same as GetRandomXxHash32(uint2(seed, index)) in shaders
+        uint32_t GetRandom(uint32_t seed, uint32_t index)
+        {
+            const uint32_t PRIME32_2 = 2246822519U;
+            const uint32_t PRIME32_3 = 3266489917U;
+            const uint32_t PRIME32_4 = 668265263U;
+            const uint32_t PRIME32_5 = 374761393U;
+
+            uint32_t h32 = index + PRIME32_5 + seed * PRIME32_3;
+            h32 = PRIME32_4 * ((h32 << 17) | (h32 >> (32 - 17)));
+            h32 = PRIME32_2 * (h32 ^ (h32 >> 15));
+            h32 = PRIME32_3 * (h32 ^ (h32 >> 13));
+            return h32 ^ (h32 >> 16);
+        }
+
+        Simd::UInt GetRandom(Simd::UInt seed, Simd::UInt index)
+        {
+            const Simd::UInt PRIME32_2(2246822519U);
+            const Simd::UInt PRIME32_3(3266489917U);
+            const Simd::UInt PRIME32_4(668265263U);
+            const Simd::UInt PRIME32_5(374761393U);
+
+            Simd::UInt h32 = index + PRIME32_5 + seed * PRIME32_3;
+            h32 = PRIME32_4 * h32.Rotl(17);
+            h32 = PRIME32_2 * (h32 ^ (h32 >> 15));
+            h32 = PRIME32_3 * (h32 ^ (h32 >> 13));
+            return h32 ^ (h32 >> 16);
+        }
     };
 }
 
+// Same conversion as GetRandomFloat in shaders, result is in [0;1)
+inline float ConvertRandomToFloat(uint32_t random)
+{
+    random &= 0x007FFFFFU; // Extract mantisa part
+    random |= 0x3F800000U; // Set exponent to 127, this will result in float [1;2)
+
+    float result;
+    std::memcpy(&result, &random, sizeof(float));
+    return result - 1.0f;
+}
+
+inline Simd::Float ConvertRandomToFloat(Simd::UInt random)
+{
+    random = random & Simd::UInt(0x007FFFFFU);
+    random = random | Simd::UInt(0x3F800000U);
+    return random.AsFloat() - Simd::Float(1.0f);
+}
+
 template<typename Type = RngType::PCG>
 class RandomNumberGenerator
 {
@@ -56,3 +112,89 @@ private:
     uint32_t mInternalSeed = 0;
     Type mEngine;
 };
+
+// Gives the same sequence as RandomNumberGenerator, but numbers can be taken from many threads at once
+template<typename Type = RngType::PCG>
+class AtomicRandomNumberGenerator
+{
+public:
+    AtomicRandomNumberGenerator(uint32_t seed)
+        : mInternalSeed(seed)
+    { }
+
+    ~AtomicRandomNumberGenerator() = default;
+
+    uint32_t GetRandom()
+    {
+        Type engine;
+        uint32_t seed = mInternalSeed.load(std::memory_order_relaxed);
+        uint32_t nextSeed = engine.GetRandom(seed);
+
+        while (!mInternalSeed.compare_exchange_weak(seed, nextSeed, std::memory_order_relaxed))
+        {
+            nextSeed = engine.GetRandom(seed);
+        }
+        return nextSeed;
+    }
+
+    AtomicRandomNumberGenerator(const AtomicRandomNumberGenerator&) = delete;
+    AtomicRandomNumberGenerator(AtomicRandomNumberGenerator&&) = delete;
+
+    AtomicRandomNumberGenerator& operator=(const AtomicRandomNumberGenerator&) = delete;
+    AtomicRandomNumberGenerator& operator=(AtomicRandomNumberGenerator&&) = delete;
+
+private:
+    std::atomic<uint32_t> mInternalSeed = 0;
+};
+
+// Counter based generator keyed by emitter's seed and particle's index, produces the same stream as particle shaders
+class ParticleRandomNumberGenerator
+{
+public:
+    ParticleRandomNumberGenerator(uint32_t seed, uint32_t particleIndex)
+        : mInternalSeed(seed), mParticleIndex(particleIndex)
+    { }
+
+    uint32_t GetRandom()
+    {
+        mInternalSeed = RngType::xxHash32().GetRandom(mInternalSeed, mParticleIndex);
+        return mInternalSeed;
+    }
+
+    float GetRandomFloat()
+    {
+        return ConvertRandomToFloat(GetRandom());
+    }
+
+    // Fills result with the first random number of every particle, lanes are independent so they are processed in SIMD registers
+    static void GetRandom(uint32_t seed, const uint32_t* particleIndices, uint32_t count, uint32_t* result)
+    {
+        GetRandomBatch(seed, particleIndices, count, result, [](Simd::UInt random) { return random; }, [](uint32_t random) { return random; });
+    }
+
+    static void GetRandomFloat(uint32_t seed, const uint32_t* particleIndices, uint32_t count, float* result)
+    {
+        GetRandomBatch(seed, particleIndices, count, result, [](Simd::UInt random) { return ConvertRandomToFloat(random); }, [](uint32_t random) { return ConvertRandomToFloat(random); });
+    }
+
+private:
+    template<typename T, typename SimdFunc, typename ScalarFunc>
+    static void GetRandomBatch(uint32_t seed, const uint32_t* particleIndices, uint32_t count, T* result, SimdFunc&& simdFunc, ScalarFunc&& scalarFunc)
+    {
+        const Simd::UInt seeds(seed);
+
+        uint32_t i = 0;
+        for (; i + Simd::Width <= count; i += Simd::Width)
+        {
+            simdFunc(RngType::xxHash32().GetRandom(seeds, Simd::UInt::Load(particleIndices + i))).Store(result + i);
+        }
+
+        for (; i < count; ++i)
+        {
+            result[i] = scalarFunc(RngType::xxHash32().GetRandom(seed, particleIndices[i]));
+        }
+    }
+
+    uint32_t mInternalSeed = 0;
+    uint32_t mParticleIndex = 0;
+};
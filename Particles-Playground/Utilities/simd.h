@@ -0,0 +1,218 @@
+#pragma once
+#include <immintrin.h>
+
+// Thin wrappers over SSE4.1 or AVX2 registers, width depends on the instruction set enabled for the build
+#if defined(__AVX2__)
+#define SIMD_AVX2 1
+#else
+#define SIMD_AVX2 0
+#endif
+
+namespace Simd
+{
+#if SIMD_AVX2
+    static const uint32_t Width = 8;
+    using FloatReg = __m256;
+    using IntReg = __m256i;
+#else
+    static const uint32_t Width = 4;
+    using FloatReg = __m128;
+    using IntReg = __m128i;
+#endif
+
+    struct UInt;
+
+    struct Float
+    {
+        FloatReg Value;
+
+        Float() = default;
+        Float(FloatReg value) : Value(value) { }
+
+#if SIMD_AVX2
+        explicit Float(float value) : Value(_mm256_set1_ps(value)) { }
+
+        static Float Load(const float* data) { return _mm256_loadu_ps(data); }
+        void Store(float* data) const { _mm256_storeu_ps(data, Value); }
+
+        Float operator+(Float rhs) const { return _mm256_add_ps(Value, rhs.Value); }
+        Float operator-(Float rhs) const { return _mm256_sub_ps(Value, rhs.Value); }
+        Float operator*(Float rhs) const { return _mm256_mul_ps(Value, rhs.Value); }
+        Float operator/(Float rhs) const { return _mm256_div_ps(Value, rhs.Value); }
+        Float operator&(Float rhs) const { return _mm256_and_ps(Value, rhs.Value); }
+        Float operator|(Float rhs) const { return _mm256_or_ps(Value, rhs.Value); }
+
+        Float operator>(Float rhs) const { return _mm256_cmp_ps(Value, rhs.Value, _CMP_GT_OQ); }
+        Float operator<=(Float rhs) const { return _mm256_cmp_ps(Value, rhs.Value, _CMP_LE_OQ); }
+
+        uint32_t Mask() const { return static_cast<uint32_t>(_mm256_movemask_ps(Value)); }
+#else
+        explicit Float(float value) : Value(_mm_set1_ps(value)) { }
+
+        static Float Load(const float* data) { return _mm_loadu_ps(data); }
+        void Store(float* data) const { _mm_storeu_ps(data, Value); }
+
+        Float operator+(Float rhs) const { return _mm_add_ps(Value, rhs.Value); }
+        Float operator-(Float rhs) const { return _mm_sub_ps(Value, rhs.Value); }
+        Float operator*(Float rhs) const { return _mm_mul_ps(Value, rhs.Value); }
+        Float operator/(Float rhs) const { return _mm_div_ps(Value, rhs.Value); }
+        Float operator&(Float rhs) const { return _mm_and_ps(Value, rhs.Value); }
+        Float operator|(Float rhs) const { return _mm_or_ps(Value, rhs.Value); }
+
+        Float operator>(Float rhs) const { return _mm_cmpgt_ps(Value, rhs.Value); }
+        Float operator<=(Float rhs) const { return _mm_cmple_ps(Value, rhs.Value); }
+
+        uint32_t Mask() const { return static_cast<uint32_t>(_mm_movemask_ps(Value)); }
+#endif
+
+        Float& operator+=(Float rhs) { *this = *this + rhs; return *this; }
+        Float& operator-=(Float rhs) { *this = *this - rhs; return *this; }
+        Float& operator*=(Float rhs) { *this = *this * rhs; return *this; }
+    };
+
+    struct UInt
+    {
+        IntReg Value;
+
+        UInt() = default;
+        UInt(IntReg value) : Value(value) { }
+
+#if SIMD_AVX2
+        explicit UInt(uint32_t value) : Value(_mm256_set1_epi32(static_cast<int32_t>(value))) { }
+
+        static UInt Load(const uint32_t* data) { return _mm256_loadu_si256(reinterpret_cast<const IntReg*>(data)); }
+        void Store(uint32_t* data) const { _mm256_storeu_si256(reinterpret_cast<IntReg*>(data), Value); }
+
+        UInt operator+(UInt rhs) const { return _mm256_add_epi32(Value, rhs.Value); }
+        UInt operator*(UInt rhs) const { return _mm256_mullo_epi32(Value, rhs.Value); }
+        UInt operator^(UInt rhs) const { return _mm256_xor_si256(Value, rhs.Value); }
+        UInt operator|(UInt rhs) const { return _mm256_or_si256(Value, rhs.Value); }
+        UInt operator&(UInt rhs) const { return _mm256_and_si256(Value, rhs.Value); }
+        UInt operator<<(int32_t shift) const { return _mm256_slli_epi32(Value, shift); }
+        UInt operator>>(int32_t shift) const { return _mm256_srli_epi32(Value, shift); }
+        UInt operator>>(UInt shift) const { return _mm256_srlv_epi32(Value, shift.Value); }
+
+        Float AsFloat() const { return _mm256_castsi256_ps(Value); }
+#else
+        explicit UInt(uint32_t value) : Value(_mm_set1_epi32(static_cast<int32_t>(value))) { }
+
+        static UInt Load(const uint32_t* data) { return _mm_loadu_si128(reinterpret_cast<const IntReg*>(data)); }
+        void Store(uint32_t* data) const { _mm_storeu_si128(reinterpret_cast<IntReg*>(data), Value); }
+
+        UInt operator+(UInt rhs) const { return _mm_add_epi32(Value, rhs.Value); }
+        UInt operator*(UInt rhs) const { return _mm_mullo_epi32(Value, rhs.Value); }
+        UInt operator^(UInt rhs) const { return _mm_xor_si128(Value, rhs.Value); }
+        UInt operator|(UInt rhs) const { return _mm_or_si128(Value, rhs.Value); }
+        UInt operator&(UInt rhs) const { return _mm_and_si128(Value, rhs.Value); }
+        UInt operator<<(int32_t shift) const { return _mm_slli_epi32(Value, shift); }
+        UInt operator>>(int32_t shift) const { return _mm_srli_epi32(Value, shift); }
+
+        // SSE has no per lane variable shift
+        UInt operator>>(UInt shift) const
+        {
+            alignas(16) uint32_t values[Width];
+            alignas(16) uint32_t shifts[Width];
+            Store(values);
+            shift.Store(shifts);
+            for (uint32_t i = 0; i < Width; ++i)
+            {
+                values[i] >>= shifts[i];
+            }
+            return Load(values);
+        }
+
+        Float AsFloat() const { return _mm_castsi128_ps(Value); }
+#endif
+
+        UInt Rotl(int32_t shift) const { return (*this << shift) | (*this >> (32 - shift)); }
+    };
+
+    // Picks lanes from b where mask is set, from a otherwise
+    inline Float Select(Float mask, Float a, Float b)
+    {
+#if SIMD_AVX2
+        return _mm256_blendv_ps(a.Value, b.Value, mask.Value);
+#else
+        return _mm_blendv_ps(a.Value, b.Value, mask.Value);
+#endif
+    }
+
+    inline Float Min(Float a, Float b)
+    {
+#if SIMD_AVX2
+        return _mm256_min_ps(a.Value, b.Value);
+#else
+        return _mm_min_ps(a.Value, b.Value);
+#endif
+    }
+
+    inline Float Max(Float a, Float b)
+    {
+#if SIMD_AVX2
+        return _mm256_max_ps(a.Value, b.Value);
+#else
+        return _mm_max_ps(a.Value, b.Value);
+#endif
+    }
+
+    inline Float Abs(Float value)
+    {
+        // Clear the sign bit
+        return value & UInt(0x7FFFFFFFU).AsFloat();
+    }
+
+    inline Float Sqrt(Float value)
+    {
+#if SIMD_AVX2
+        return _mm256_sqrt_ps(value.Value);
+#else
+        return _mm_sqrt_ps(value.Value);
+#endif
+    }
+
+    inline Float Floor(Float value)
+    {
+#if SIMD_AVX2
+        return _mm256_floor_ps(value.Value);
+#else
+        return _mm_floor_ps(value.Value);
+#endif
+    }
+
+    inline Float Lerp(Float a, Float b, Float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    // There are no vectorized trigonometric functions in the standard library, they are evaluated per lane
+    template<typename Func>
+    inline Float PerLane(Float value, Func&& func)
+    {
+        alignas(32) float values[Width];
+        value.Store(values);
+        for (uint32_t i = 0; i < Width; ++i)
+        {
+            values[i] = func(values[i]);
+        }
+        return Float::Load(values);
+    }
+
+    inline Float Sin(Float value)
+    {
+        return PerLane(value, [](float x) { return std::sin(x); });
+    }
+
+    inline Float Cos(Float value)
+    {
+        return PerLane(value, [](float x) { return std::cos(x); });
+    }
+
+    inline Float Pow(Float base, Float exponent)
+    {
+        alignas(32) float exponents[Width];
+        exponent.Store(exponents);
+
+        uint32_t lane = 0;
+        return PerLane(base, [&](float x) { return std::pow(x, exponents[lane++]); });
+    }
+}
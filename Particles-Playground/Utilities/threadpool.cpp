@@ -0,0 +1,101 @@
+#include "Utilities/threadpool.h"
+
+ThreadPool::ThreadPool(uint32_t workersCount)
+{
+    mWorkers.reserve(workersCount);
+    for (uint32_t i = 0; i < workersCount; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+    }
+    mWorkAvailable.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Small ranges aren't worth waking up workers
+    if (count == 1 || mWorkers.empty())
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Assert(!mTask); // Nested parallel loops aren't supported
+
+        mTask = &func;
+        mTasksCount = count;
+        mNextTask = 0;
+        mFinishedTasks = 0;
+        ++mJobId;
+    }
+    mWorkAvailable.notify_all();
+
+    ProcessTasks(func, count);
+
+    // Workers may still hold a reference to the task, so wait until all of them are done with it
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkFinished.wait(lock, [this]() { return mFinishedTasks == mTasksCount && mActiveWorkers == 0; });
+    mTask = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t lastJobId = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkAvailable.wait(lock, [this, lastJobId]() { return mExit || (mTask && mJobId != lastJobId); });
+
+        if (mExit)
+        {
+            return;
+        }
+
+        lastJobId = mJobId;
+        const std::function<void(uint32_t)>& task = *mTask;
+        const uint32_t tasksCount = mTasksCount;
+        ++mActiveWorkers;
+        lock.unlock();
+
+        ProcessTasks(task, tasksCount);
+
+        lock.lock();
+        --mActiveWorkers;
+        lock.unlock();
+        mWorkFinished.notify_all();
+    }
+}
+
+void ThreadPool::ProcessTasks(const std::function<void(uint32_t)>& task, uint32_t tasksCount)
+{
+    uint32_t index = mNextTask.fetch_add(1);
+    while (index < tasksCount)
+    {
+        task(index);
+        ++mFinishedTasks;
+        index = mNextTask.fetch_add(1);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Simple pool of worker threads that split a range of tasks between them, calling thread takes part in the work too
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t workersCount = std::max(std::thread::hardware_concurrency(), 2U) - 1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // Calls func for every index in [0, count) and returns once all calls are finished
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+    inline uint32_t GetWorkersCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+
+private:
+    void WorkerLoop();
+    void ProcessTasks(const std::function<void(uint32_t)>& task, uint32_t tasksCount);
+
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkFinished;
+
+    const std::function<void(uint32_t)>* mTask = nullptr;
+    uint32_t mTasksCount = 0;
+    std::atomic<uint32_t> mNextTask = 0;
+    std::atomic<uint32_t> mFinishedTasks = 0;
+    uint32_t mActiveWorkers = 0;
+    uint64_t mJobId = 0;
+    bool mExit = false;
+
+};
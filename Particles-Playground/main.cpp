@@ -1,9 +1,24 @@
 #include "System/engine.h"
+#include "Benchmarks/benchmarks.h"
 
 int32_t WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int32_t nShowCmd)
 {
     Engine::Get().Startup();
 
+    // Runs headless checks and benchmarks instead of the scene, exit code tells whether all of them passed
+    if (std::string_view(lpCmdLine).find("-benchmark") != std::string_view::npos)
+    {
+        // Window stays hidden, but the upload benchmark advances frames, so the first one has to be signaled
+        Graphic::Get().PostStartup();
+
+        const bool passed = RunBenchmarks();
+
+        Engine::Get().PreShutdown();
+        Engine::Get().Shutdown();
+
+        return passed ? 0 : 1;
+    }
+
     GPUParticleSystem gpuParticlesSystem;
     gpuParticlesSystem.Init();
 
@@ -44,6 +59,7 @@ int32_t WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, i
     GPUEmitterTemplate* emitterTemplate1 = gpuParticlesSystem.GetEmitterTemplate(emitterTemplateHandle1);
     emitterTemplate1->SetSpawnShader(spawnLogic);
     emitterTemplate1->SetUpdateShader(updateLogic);
+    emitterTemplate1->SetSpecializedConstants(EmitterConstantField::All);
 
     GPUEmitterHandle emitter1 = gpuParticlesSystem.CreateEmitter(emitterTemplateHandle1, 800);
     gpuParticlesSystem.GetEmitter(emitter1)->SetSpawnRate(100.0f).SetParticleLifeTime(2.0f).SetParticleColor({ 1,0.1f,0.1f,1 }).SetPosition({ -20,0,0 }).SetLoopTime(3);
@@ -65,8 +81,13 @@ int32_t WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, i
     graph.AddExternalGPUBuffer(RESOURCEID("EmitterConstantBuffer"), gpuParticlesSystem.GetEmitterConstantBuffer());
     graph.AddExternalGPUBuffer(RESOURCEID("EmitterStatusBuffer"), gpuParticlesSystem.GetEmitterStatusBuffer());
     graph.AddExternalGPUBuffer(RESOURCEID("EmitterIndexBuffer"), gpuParticlesSystem.GetEmitterIndexBuffer());
+    graph.AddExternalGPUBuffer(RESOURCEID("EmitterWorkBuffer"), gpuParticlesSystem.GetEmitterWorkBuffer());
+    graph.AddExternalGPUBuffer(RESOURCEID("SpawnGroupTableBuffer"), gpuParticlesSystem.GetSpawnGroupTableBuffer());
     graph.AddExternalGPUBuffer(RESOURCEID("DrawIndirectBuffer"), gpuParticlesSystem.GetDrawIndirectBuffer());
     graph.AddExternalGPUBuffer(RESOURCEID("FreeIndicesBuffer"), gpuParticlesSystem.GetFreeIndicesBuffer());
+    graph.AddExternalGPUBuffer(RESOURCEID("IndicesBuffer"), gpuParticlesSystem.GetIndicesBuffer());
+    graph.AddExternalGPUBuffer(RESOURCEID("SortKeysBuffer"), gpuParticlesSystem.GetSortKeysBuffer());
+    graph.AddExternalGPUBuffer(RESOURCEID("SortValuesBuffer"), gpuParticlesSystem.GetSortValuesBuffer());
     graph.AddExternalGPUBuffer(RESOURCEID("ParticlesDataBuffer"), gpuParticlesSystem.GetParticlesDataBuffer());
 
     graph.AddNode<PrepareSceneBufferNode>();
@@ -75,7 +96,11 @@ int32_t WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, i
     graph.AddNode<GPUParticleSystemUpdateEmittersNode>();
     graph.AddNode<GPUParticleSystemUpdateParticlesNode>();
     graph.AddNode<GPUParticleSystemSpawnParticlesNode>();
+    graph.AddNode<GPUParticleSystemBuildSortKeysNode>();
+    graph.AddNode<GPUParticleSystemSortParticlesNode>();
+    graph.AddNode<GPUParticleSystemPrepareDrawParticlesNode>();
     graph.AddNode<GPUParticleSystemDrawParticlesNode>();
+    graph.AddNode<GPUParticleSystemReadbackEmittersStatusNode>(true);
     graph.AddNode<PresentToScreenNode>(true);
 
     graph.Setup();
@@ -86,11 +111,52 @@ int32_t WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, i
     sceneData.mGPUParticleSystem = &gpuParticlesSystem;
     sceneData.mCamera = &camera;
 
+    // Times every kernel mode on the current scene and closes the window, the fastest one is the mode to pick for it
+    const bool timeKernelModes = std::string_view(lpCmdLine).find("-kernelmodes") != std::string_view::npos;
+    constexpr uint32_t KernelModeWarmupFrames = 120;
+    constexpr uint32_t KernelModeMeasuredFrames = 600;
+    constexpr ParticleKernelMode KernelModes[] = { ParticleKernelMode::PerTemplate, ParticleKernelMode::Uber, ParticleKernelMode::Fused };
+    constexpr const char* KernelModeNames[] = { "PerTemplate", "Uber", "Fused" };
+    uint32_t kernelModeIndex = 0;
+    uint32_t kernelModeFrame = 0;
+    std::chrono::high_resolution_clock::time_point kernelModeStart;
+
+    if (timeKernelModes)
+    {
+        Graphic::Get().SetVSync(false);
+        gpuParticlesSystem.SetKernelMode(KernelModes[kernelModeIndex]);
+    }
+
     while (Window::Get().IsRunning())
     {
+        if (timeKernelModes)
+        {
+            if (kernelModeFrame == KernelModeWarmupFrames)
+            {
+                kernelModeStart = std::chrono::high_resolution_clock::now();
+            }
+            else if (kernelModeFrame == KernelModeWarmupFrames + KernelModeMeasuredFrames)
+            {
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - kernelModeStart;
+                OutputDebugMessage("Kernel mode %s: %.3f ms per frame\n", KernelModeNames[kernelModeIndex], elapsed.count() / KernelModeMeasuredFrames);
+
+                kernelModeFrame = 0;
+                if (++kernelModeIndex == std::size(KernelModes))
+                {
+                    Window::Get().Close();
+                    break;
+                }
+
+                gpuParticlesSystem.SetKernelMode(KernelModes[kernelModeIndex]);
+            }
+
+            ++kernelModeFrame;
+        }
+
         Engine::Get().PreUpdate();
 
         transientAllocator.PreUpdate();
+        gpuParticlesSystem.PreUpdate();
 
         //GlobalTimer& timer = Engine::Get().GetTimer();
         //OutputDebugMessage("Elapsed: %f, Delta: %f\n", timer.GetElapsedTime(), timer.GetDeltaTime());
@@ -16,6 +16,8 @@ using namespace DirectX;
 
 // std
 #include <cinttypes>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <array>
 #include <vector>
@@ -28,6 +30,11 @@ using namespace DirectX;
 #include <algorithm>
 #include <numeric>
 #include <optional>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 // custom
 #include "Utilities/debug.h"